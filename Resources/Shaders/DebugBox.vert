@@ -0,0 +1,18 @@
+#version 460 core
+
+layout(location = 0) in vec3 corner; // of the [-1, 1] cube
+layout(location = 1) in vec4 color;
+layout(location = 2) in vec3 center;
+layout(location = 3) in vec3 axisX; // scaled by the half extents
+layout(location = 4) in vec3 axisY;
+layout(location = 5) in vec3 axisZ;
+
+out vec4 Color;
+
+uniform mat4 viewProjection;
+
+void main()
+{
+    Color = color;
+    gl_Position = viewProjection * vec4(center + axisX * corner.x + axisY * corner.y + axisZ * corner.z, 1.0);
+}
\ No newline at end of file
@@ -0,0 +1,14 @@
+#version 460 core
+
+layout(location = 0) in vec3 position;
+layout(location = 1) in vec4 color;
+
+out vec4 Color;
+
+uniform mat4 viewProjection;
+
+void main()
+{
+    Color = color;
+    gl_Position = viewProjection * vec4(position, 1.0);
+}
\ No newline at end of file
@@ -4,52 +4,126 @@ out vec4 FragColor;
 
 in vec2 TexCoords;
 
-uniform sampler2D Positions;
-uniform sampler2D Normals;
-uniform sampler2D Albedo;
+uniform sampler2D Depth;
+uniform sampler2D Normals;  // .rg = octahedral encoded normal
+uniform sampler2D Albedo;   // .rgb = albedo, .a = ambient occlusion
+uniform sampler2D Material; // .r = roughness, .g = metallic
 
 uniform sampler2DArray ShadowMaps;
 uniform samplerCubeArray ShadowCubeMaps;
 
-uniform vec3 camPos;
+// must match DeferredMode in Renderer.hpp
+const int DEFERRED_POSITION = 0;
+const int DEFERRED_NORMAL = 1;
+const int DEFERRED_ALBEDO = 2;
+const int DEFERRED_SHADING = 3;
+const int DEFERRED_LIGHT_HEATMAP = 4; // the shading tinted by the number of lights of each cluster
 
-const int MAX_LIGHTS = 10;
+uniform int deferredMode;
+uniform mat4 inverseViewProjection; // the world position is rebuilt from the depth
+
+layout(std140, binding = 0) uniform Camera{
+    mat4 view;
+    mat4 projection;
+    vec4 camPos;
+};
 
 struct PointLight {
-    vec3 position;
-    vec3 color;
-    int shadowMapIndex;
+    vec4 position;
+    vec4 color;
+    int shadowMapIndex; // -1 without a shadow map
+    float range;
 };
 
+const int SHADOW_CASCADE_COUNT = 4;
+const float SHADOW_CASCADE_SCALE = 0.5; // the cascades share a layer, one quadrant each
+
 struct DirectionalLight {
-    vec3 direction;
-    vec3 color;
-    int shadowMapIndex;
-    mat4 lightSpaceMatrix;
+    vec4 direction;
+    vec4 color;
+    mat4 lightSpaceMatrices[SHADOW_CASCADE_COUNT];
+    vec4 cascadeSplits; // view distance where each cascade ends
+    vec4 cascadeBiases;
+    int shadowMapIndex; // the layer of the cascades, -1 without a shadow map
 };
 
 struct SpotLight {
-    vec3 position;
-    vec3 direction;
-    vec3 color;
+    vec4 position;
+    vec4 direction;
+    vec4 color;
+    mat4 lightSpaceMatrix;
     float cutOff;
     float outerCutOff;
     int shadowMapIndex;
-    mat4 lightSpaceMatrix;
+    float range;
+};
+
+// written by UniformBlocks.cpp, only the lights that change are uploaded
+layout(std430, binding = 7) readonly buffer PointLights{
+    int numPointLights;
+    PointLight pointLights[];
 };
 
-uniform PointLight pointLights[MAX_LIGHTS];
-uniform DirectionalLight directionalLights[MAX_LIGHTS];
-uniform SpotLight spotLights[MAX_LIGHTS];
-uniform int numPointLights;
-uniform int numDirectionalLights;
-uniform int numSpotLights;
+layout(std430, binding = 8) readonly buffer DirectionalLights{
+    int numDirectionalLights;
+    DirectionalLight directionalLights[];
+};
+
+layout(std430, binding = 9) readonly buffer SpotLights{
+    int numSpotLights;
+    SpotLight spotLights[];
+};
+
+// written by LightClustering.comp
+layout(std430, binding = 11) readonly buffer ClusterLights{
+    uvec2 clusterLights[];
+};
+
+layout(std430, binding = 12) readonly buffer ClusterLightIndices{
+    uint clusterLightIndices[];
+};
+
+// must match LightClustering.hpp
+const uvec3 GRID_SIZE = uvec3(16, 9, 24);
+const uint MAX_LIGHTS_PER_CLUSTER = 128;
 
 const float PI = 3.14159265359;
 
+uint GetCluster(vec3 position)
+{
+    float zNear = projection[3][2] / (projection[2][2] - 1.0);
+    float zFar = projection[3][2] / (projection[2][2] + 1.0);
+    float depth = max(-(view * vec4(position, 1.0)).z, zNear);
+    uint slice = min(uint(log(depth / zNear) / log(zFar / zNear) * float(GRID_SIZE.z)), GRID_SIZE.z - 1);
+    uvec2 tile = min(uvec2(TexCoords * vec2(GRID_SIZE.xy)), GRID_SIZE.xy - 1);
+
+    return tile.x + tile.y * GRID_SIZE.x + slice * GRID_SIZE.x * GRID_SIZE.y;
+}
+
+// brings the inverse square falloff smoothly to 0 at the range the light was clustered with
+float RangeWindow(float distance, float range)
+{
+    float ratio = distance / range;
+    float window = clamp(1.0 - ratio * ratio * ratio * ratio, 0.0, 1.0);
+    return window * window;
+}
+
+// blue for few lights, through green and yellow, to red at MAX_LIGHTS_PER_CLUSTER / 4 and more
+vec3 Heatmap(uint count)
+{
+    if(count == 0)
+        return vec3(0.0);
+
+    float t = clamp(float(count) / float(MAX_LIGHTS_PER_CLUSTER / 4), 0.0, 1.0);
+    return clamp(vec3(t * 4.0 - 2.0, t < 0.5 ? t * 4.0 : 4.0 - t * 4.0, 2.0 - t * 4.0), 0.0, 1.0);
+}
+
 // return 0.0 if in shadow, 1.0 if not
-float CalcShadowSpot(int shadowMapIndex, vec4 fragPosLightSpace, vec3 lightDir)
+float CalcShadowSpot(int shadowMapIndex, vec4 fragPosLightSpace, vec3 lightDir, vec3 normal)
 {
+    if(shadowMapIndex < 0)
+        return 1.0;
+
     vec3 projCoords = fragPosLightSpace.xyz / fragPosLightSpace.w;
     projCoords = projCoords * 0.5 + 0.5;
     float closestDepth = texture(ShadowMaps, vec3(projCoords.xy, shadowMapIndex)).r;
@@ -60,7 +134,7 @@ float CalcShadowSpot(int shadowMapIndex, vec4 fragPosLightSpace, vec3 lightDir)
     float shadow = 0.0;
     vec2 texelSize = 1.0 / vec2(textureSize(ShadowMaps, 0).xy);
 
-    float bias = max(0.05 * (1.0 - dot(texture(Normals, TexCoords).rgb, lightDir)), 0.002);
+    float bias = max(0.05 * (1.0 - dot(normal, lightDir)), 0.002);
     
     for(int x = -1; x <= 1; x++){
         for(int y = -1; y <= 1; y++){
@@ -77,23 +151,42 @@ float CalcShadowSpot(int shadowMapIndex, vec4 fragPosLightSpace, vec3 lightDir)
     return shadow;
 }
 
-float CalcShadowDirectional(int shadowMapIndex, vec4 fragPosLightSpace, vec3 lightDir)
+float CalcShadowDirectional(DirectionalLight light, vec3 fragPos)
 {
+    if(light.shadowMapIndex < 0)
+        return 1.0;
+
+    // the first cascade that reaches the fragment, the farther ones have bigger texels
+    float viewDepth = -(view * vec4(fragPos, 1.0)).z;
+    int cascade = 0;
+
+    while(cascade < SHADOW_CASCADE_COUNT && viewDepth > light.cascadeSplits[cascade])
+        cascade++;
+
+    //past the last cascade, consider not in shadow
+    if(cascade == SHADOW_CASCADE_COUNT)
+        return 1.0;
+
+    vec4 fragPosLightSpace = light.lightSpaceMatrices[cascade] * vec4(fragPos, 1.0);
     vec3 projCoords = fragPosLightSpace.xyz / fragPosLightSpace.w;
     projCoords = projCoords * 0.5 + 0.5;
-    float closestDepth = texture(ShadowMaps, vec3(projCoords.xy, shadowMapIndex)).r;
     float currentDepth = projCoords.z;
 
-
     //PCF (Percentage-Closer Filtering) to soften shadows
     float shadow = 0.0;
     vec2 texelSize = 1.0 / vec2(textureSize(ShadowMaps, 0).xy);
+    // the taps stay inside the quadrant of the cascade, the neighbouring ones belong to the other cascades
+    vec2 quadrant = vec2(cascade % 2, cascade / 2) * SHADOW_CASCADE_SCALE;
+    vec2 quadrantMin = quadrant + 0.5 * texelSize;
+    vec2 quadrantMax = quadrant + vec2(SHADOW_CASCADE_SCALE) - 0.5 * texelSize;
+    vec2 uv = quadrant + clamp(projCoords.xy, 0.0, 1.0) * SHADOW_CASCADE_SCALE;
 
-    float bias = 0.005;
+    float bias = light.cascadeBiases[cascade];
     
     for(int x = -1; x <= 1; x++){
         for(int y = -1; y <= 1; y++){
-            float pcfDepth = texture(ShadowMaps, vec3(projCoords.xy + vec2(x, y) * texelSize, shadowMapIndex)).r; 
+            vec2 tap = clamp(uv + vec2(x, y) * texelSize, quadrantMin, quadrantMax);
+            float pcfDepth = texture(ShadowMaps, vec3(tap, light.shadowMapIndex)).r; 
             shadow += ((currentDepth - bias > pcfDepth) ? 0.0 : 1.0);        
         }    
     }
@@ -108,7 +201,10 @@ float CalcShadowDirectional(int shadowMapIndex, vec4 fragPosLightSpace, vec3 lig
 
 float CalcShadowCube(PointLight pointLight, vec3 fragPos)
 {
-    vec3 fragToLight = fragPos - pointLight.position;
+    if(pointLight.shadowMapIndex < 0)
+        return 1.0;
+
+    vec3 fragToLight = fragPos - pointLight.position.xyz;
     float closestDepth = texture(ShadowCubeMaps, vec4(fragToLight, pointLight.shadowMapIndex)).r;
     closestDepth *= 25.0; 
     float currentDepth = length(fragToLight);
@@ -132,6 +228,22 @@ float CalcShadowCube(PointLight pointLight, vec3 fragPos)
     return shadow;
 }
 
+vec3 OctahedralDecode(vec2 e)
+{
+    e = e * 2.0 - 1.0;
+    vec3 v = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-v.z, 0.0);
+    v.x += v.x >= 0.0 ? -t : t;
+    v.y += v.y >= 0.0 ? -t : t;
+    return normalize(v);
+}
+
+vec3 ReconstructPosition(float depth)
+{
+    vec4 position = inverseViewProjection * vec4(vec3(TexCoords, depth) * 2.0 - 1.0, 1.0);
+    return position.xyz / position.w;
+}
+
 float DistributionGGX(vec3 N, vec3 H, float roughness)
 {
     float a = roughness*roughness;
@@ -174,14 +286,34 @@ vec3 fresnelSchlick(float cosTheta, vec3 F0)
 
 void main()
 {
-    vec3 albedo = pow(texture(Albedo, TexCoords).rgb, vec3(2.2));
-    vec3 normal = texture(Normals, TexCoords).rgb;
-    vec3 position = texture(Positions, TexCoords).rgb;
-    float roughness = texture(Positions, TexCoords).a;
-    float metallic = texture(Normals, TexCoords).a;
-    float ao = texture(Albedo, TexCoords).a;
+    // the pass covers the same scaled corner of its target as the G-buffer pass, so the fragment is also the texel of the G-buffer.
+    // TexCoords go from 0 to 1 over that corner, like the screen positions of the G-buffer pass
+    ivec2 texel = ivec2(gl_FragCoord.xy);
+    vec4 albedoAO = texelFetch(Albedo, texel, 0);
+    vec2 material = texelFetch(Material, texel, 0).rg;
+
+    vec3 albedo = pow(albedoAO.rgb, vec3(2.2));
+    vec3 normal = OctahedralDecode(texelFetch(Normals, texel, 0).rg);
+    vec3 position = ReconstructPosition(texelFetch(Depth, texel, 0).r);
+    float roughness = material.r;
+    float metallic = material.g;
+    float ao = albedoAO.a;
+
+    // the G-buffer views, decoded like the shading reads them
+    if(deferredMode == DEFERRED_POSITION){
+        FragColor = vec4(position, 1.0);
+        return;
+    }
+    if(deferredMode == DEFERRED_NORMAL){
+        FragColor = vec4(normal, 1.0);
+        return;
+    }
+    if(deferredMode == DEFERRED_ALBEDO){
+        FragColor = vec4(albedoAO.rgb, 1.0);
+        return;
+    }
 
-    vec3 V = normalize(camPos - position);
+    vec3 V = normalize(camPos.xyz - position);
 
     vec3 F0 = vec3(0.04); 
     F0 = mix(F0, albedo, metallic);
@@ -189,16 +321,22 @@ void main()
     // reflectance equation
     vec3 Lo = vec3(0.0);
 
+    // only the point and spot lights assigned to the cluster of the fragment
+    uint cluster = GetCluster(position);
+    uvec2 clusterCounts = clusterLights[cluster];
+    uint clusterFirst = cluster * MAX_LIGHTS_PER_CLUSTER;
+
     // Point Lights
-    for(int i = 0; i < numPointLights; i++) 
+    for(uint k = 0; k < clusterCounts.x; k++) 
     {
+        uint i = clusterLightIndices[clusterFirst + k];
         float shadow = CalcShadowCube(pointLights[i], position);
 
-        vec3 L = normalize(pointLights[i].position - position);
+        vec3 L = normalize(pointLights[i].position.xyz - position);
         vec3 H = normalize(V + L);
-        float distance = length(pointLights[i].position - position);
-        float attenuation = 1.0 / (distance * distance);
-        vec3 radiance = pointLights[i].color * attenuation;
+        float distance = length(pointLights[i].position.xyz - position);
+        float attenuation = RangeWindow(distance, pointLights[i].range) / (distance * distance);
+        vec3 radiance = pointLights[i].color.rgb * attenuation;
 
         float NDF = DistributionGGX(normal, H, roughness);  
         float NDF2 = DistributionGGX(-normal, H, roughness); 
@@ -228,12 +366,11 @@ void main()
     // Directional Lights
     for(int i = 0; i < numDirectionalLights; i++) 
     {
-        vec4 fragPosLightSpace = (directionalLights[i].lightSpaceMatrix * vec4(position, 1.0));
-        float shadow = CalcShadowDirectional(directionalLights[i].shadowMapIndex, fragPosLightSpace, -directionalLights[i].direction);
+        float shadow = CalcShadowDirectional(directionalLights[i], position);
 
-        vec3 L = normalize(-directionalLights[i].direction);
+        vec3 L = normalize(-directionalLights[i].direction.xyz);
         vec3 H = normalize(V + L);
-        vec3 radiance = directionalLights[i].color;
+        vec3 radiance = directionalLights[i].color.rgb;
 
         float NDF = DistributionGGX(normal, H, roughness);   
         float NDF2 = DistributionGGX(-normal, H, roughness);
@@ -260,18 +397,19 @@ void main()
     }   
 
     // Spot Lights
-    for(int i = 0; i < numSpotLights; i++) 
+    for(uint k = 0; k < clusterCounts.y; k++) 
     {
+        uint i = clusterLightIndices[clusterFirst + clusterCounts.x + k];
         vec4 fragPosLightSpace = (spotLights[i].lightSpaceMatrix * vec4(position, 1.0));
-        float shadow = CalcShadowSpot(spotLights[i].shadowMapIndex, fragPosLightSpace, -spotLights[i].direction);
+        float shadow = CalcShadowSpot(spotLights[i].shadowMapIndex, fragPosLightSpace, -spotLights[i].direction.xyz, normal);
 
-        vec3 L = normalize(spotLights[i].position - position);
+        vec3 L = normalize(spotLights[i].position.xyz - position);
         vec3 H = normalize(V + L);
-        float distance = length(spotLights[i].position - position);
-        float attenuation = 1.0 / (distance * distance);
-        vec3 radiance = spotLights[i].color * attenuation;
+        float distance = length(spotLights[i].position.xyz - position);
+        float attenuation = RangeWindow(distance, spotLights[i].range) / (distance * distance);
+        vec3 radiance = spotLights[i].color.rgb * attenuation;
 
-        float theta = dot(L, normalize(-spotLights[i].direction));
+        float theta = dot(L, normalize(-spotLights[i].direction.xyz));
         float epsilon = spotLights[i].cutOff - spotLights[i].outerCutOff;
         float intensity = clamp((theta - spotLights[i].outerCutOff) / epsilon, 0.0, 1.0);
         radiance *= intensity;
@@ -305,5 +443,8 @@ void main()
     
     vec3 color = ambient + Lo;
 
+    if(deferredMode == DEFERRED_LIGHT_HEATMAP)
+        color = mix(color, Heatmap(clusterCounts.x + clusterCounts.y), 0.75);
+
     FragColor = vec4(color, 1.0);
 }
\ No newline at end of file
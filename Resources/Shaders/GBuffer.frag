@@ -1,10 +1,9 @@
 #version 460 core
 
-layout (location = 0) out vec4 PositionOut;
-layout (location = 1) out vec4 NormalOut;
-layout (location = 2) out vec4 AlbedoOut;
+layout (location = 0) out vec2 NormalOut;
+layout (location = 1) out vec4 AlbedoOut;
+layout (location = 2) out vec2 MaterialOut;
 
-in vec3 fragPosition;
 in vec2 fragTexCoord;
 in vec3 fragNormal;
 in vec3 fragTangent;
@@ -23,6 +22,19 @@ uniform sampler2D roughnessMap;
 uniform sampler2D aoMap;
 
 uniform bool hasTextures[5];
+uniform int lodColor; // LOD of the mesh when they are shown, -1 otherwise
+
+const vec3 LOD_COLORS[4] = vec3[](vec3(0.1, 0.9, 0.1), vec3(0.9, 0.9, 0.1), vec3(0.9, 0.5, 0.1), vec3(0.9, 0.1, 0.1));
+
+// the normal projected on the octahedron, the lower half folded over the upper one, mapped to [0, 1] for the unorm target
+vec2 OctahedralEncode(vec3 n)
+{
+    n /= abs(n.x) + abs(n.y) + abs(n.z);
+    if(n.z < 0.0){
+        n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+    }
+    return n.xy * 0.5 + 0.5;
+}
 
 void main(){
     vec3 albedo, normal;
@@ -51,7 +63,11 @@ void main(){
     mat3 TBN = transpose(mat3(fragTangent, fragBinormal, fragNormal));
     normal = normalize(TBN * (2.0 * normal - 1.0));
 
-    PositionOut = vec4(fragPosition, roughness);
-    NormalOut = vec4(normal, metallic);
+    NormalOut = OctahedralEncode(normal);
+    MaterialOut = vec2(roughness, metallic);
     AlbedoOut = vec4(pow(texture(albedoMap, fragTexCoord).rgb, vec3(2.2)), ao);
+
+    if(lodColor >= 0){
+        AlbedoOut.rgb = mix(AlbedoOut.rgb, LOD_COLORS[min(lodColor, 3)], 0.7);
+    }
 }
@@ -2,26 +2,46 @@
 
 const int MAX_BONE_INFLUENCE = 4;
 const int MAX_BONES = 100;
+const uint NO_BONE = 255u;
 
 layout (location = 0) in vec3 vertexPosition;
-layout (location = 1) in vec3 vertexNormal;
+layout (location = 1) in vec2 vertexNormal; // octahedral
 layout (location = 2) in vec2 vertexTexCoord;
-layout (location = 3) in vec3 vertexTangent;
-layout (location = 4) in ivec4 boneIDsIn;
+layout (location = 3) in vec2 vertexTangent; // octahedral
+layout (location = 4) in uvec4 boneIDsIn; // NO_BONE for the unused influences
 layout (location = 5) in vec4 weightsIn;
+layout (location = 6) in mat4 instanceModel;  // per instance, locations 6 to 9
+layout (location = 10) in mat3 instanceNormal; // per instance, locations 10 to 12
 
-out vec3 fragPosition;
 out vec2 fragTexCoord;
 out vec3 fragNormal;
 out vec3 fragTangent;
 out vec3 fragBinormal;
 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+invariant gl_Position; // the depth pre-pass computes the same position
+
+layout(std140, binding = 0) uniform Camera{
+    mat4 view;
+    mat4 projection;
+    vec4 camPos;
+};
 uniform mat4 finalBonesMatrices[MAX_BONES];
 uniform bool isPlaying;
 
+int BoneID(uint id)
+{
+    return id == NO_BONE ? -1 : int(id);
+}
+
+vec3 OctahedralDecode(vec2 e)
+{
+    vec3 v = vec3(e, 1.0f - abs(e.x) - abs(e.y));
+    float t = max(-v.z, 0.0f);
+    v.x += v.x >= 0.0f ? -t : t;
+    v.y += v.y >= 0.0f ? -t : t;
+    return normalize(v);
+}
+
 void main()
 {
     float weights[MAX_BONE_INFLUENCE];
@@ -31,10 +51,13 @@ void main()
     weights[3] = weightsIn.w;
 
     int boneIDs[MAX_BONE_INFLUENCE];
-    boneIDs[0] = boneIDsIn.x;
-    boneIDs[1] = boneIDsIn.y;
-    boneIDs[2] = boneIDsIn.z;
-    boneIDs[3] = boneIDsIn.w;
+    boneIDs[0] = BoneID(boneIDsIn.x);
+    boneIDs[1] = BoneID(boneIDsIn.y);
+    boneIDs[2] = BoneID(boneIDsIn.z);
+    boneIDs[3] = BoneID(boneIDsIn.w);
+
+    vec3 normal = OctahedralDecode(vertexNormal);
+    vec3 tangent = OctahedralDecode(vertexTangent);
 
     vec4 totalPosition = vec4(0.0f);
     vec4 totalNormal = vec4(0.0f);
@@ -44,8 +67,8 @@ void main()
         for(int i = 0; i < MAX_BONE_INFLUENCE; i++){  
             if(boneIDs[i] == -1 && i == 0){                     //no bones for this vertex, just keep initial values
                 totalPosition = vec4(vertexPosition, 1.0f);
-                totalNormal = vec4(vertexNormal, 0.0f);
-                totalTangent = vec4(vertexTangent, 0.0f);
+                totalNormal = vec4(normal, 0.0f);
+                totalTangent = vec4(tangent, 0.0f);
                 break;
             }
             
@@ -54,8 +77,8 @@ void main()
             }
 
             vec4 localPosition = finalBonesMatrices[boneIDs[i]] * vec4(vertexPosition, 1.0f) * weights[i];
-            vec4 localNormal = finalBonesMatrices[boneIDs[i]] * vec4(vertexNormal, 0.0f) * weights[i];
-            vec4 localTangent = finalBonesMatrices[boneIDs[i]] * vec4(vertexTangent, 0.0f) * weights[i];
+            vec4 localNormal = finalBonesMatrices[boneIDs[i]] * vec4(normal, 0.0f) * weights[i];
+            vec4 localTangent = finalBonesMatrices[boneIDs[i]] * vec4(tangent, 0.0f) * weights[i];
 
             totalPosition += localPosition;
             totalNormal += localNormal;
@@ -63,22 +86,20 @@ void main()
         }
     }else{
         totalPosition = vec4(vertexPosition, 1.0f);
-        totalNormal = vec4(vertexNormal, 0.0f);
-        totalTangent = vec4(vertexTangent, 0.0f);
+        totalNormal = vec4(normal, 0.0f);
+        totalTangent = vec4(tangent, 0.0f);
     }
 
     totalNormal.xyz = normalize(totalNormal.xyz);
 
     vec3 vertexBinormal = cross(totalNormal.xyz, totalTangent.xyz);
-    mat3 normalMatrix = transpose(inverse(mat3(model)));
     
-    fragPosition = vec3(model * totalPosition);
     fragTexCoord = vertexTexCoord;
-    fragNormal = normalize(normalMatrix * totalNormal.xyz);
-    fragTangent = normalize(normalMatrix * totalTangent.xyz);
+    fragNormal = normalize(instanceNormal * totalNormal.xyz);
+    fragTangent = normalize(instanceNormal * totalTangent.xyz);
     fragTangent = normalize(fragTangent - dot(fragTangent, fragNormal) * fragNormal);
-    fragBinormal = normalize(normalMatrix * vertexBinormal);
+    fragBinormal = normalize(instanceNormal * vertexBinormal);
     fragBinormal = cross(fragNormal, fragTangent);
 
-    gl_Position = projection * view * model * totalPosition;
+    gl_Position = projection * view * instanceModel * totalPosition;
 }
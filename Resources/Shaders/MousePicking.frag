@@ -1,7 +1,7 @@
 #version 460 core
 
 uniform uint id;
-uniform uint transform_index;
+flat in uint transformIndex;
 
 out uvec3 data;
 
@@ -9,7 +9,7 @@ void main(){
     uvec3 temp = uvec3(0);
     temp.x = (id >> 16) & 0xFFFF;
     temp.y = id & 0xFFFF;
-    temp.z = transform_index;
+    temp.z = transformIndex;
 
     data = temp;
 }
\ No newline at end of file
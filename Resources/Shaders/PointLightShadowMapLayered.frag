@@ -0,0 +1,15 @@
+#version 460 core
+
+in ShadowVertex{
+    vec4 FragPos;
+    flat vec3 LightPos;
+    flat int Layer;
+    flat int Viewport;
+} fs_in;
+
+void main()
+{
+    float distance = length(fs_in.FragPos.xyz - fs_in.LightPos);
+    distance = distance / 25.0;
+    gl_FragDepth = distance;
+}
\ No newline at end of file
@@ -12,6 +12,7 @@ uniform bool useBloom;
 uniform float exposure;
 uniform int toneMappingType;
 uniform float bloomStrength;
+uniform vec2 renderScale; // part of the screen and bloom textures the scene was rendered in
 
 vec3 ACESFilm(vec3 x)
 {
@@ -52,10 +53,14 @@ vec3 ReinhardTonemap(vec3 x)
 
 void main()
 {
-    vec3 result = texture(screenTexture, TexCoords).rgb;
+    // kept half a texel inside the rendered part, so the bilinear upscale doesn't blend in what lies past it
+    vec2 halfTexel = 0.5 / vec2(textureSize(screenTexture, 0));
+    vec2 sceneCoords = min(TexCoords * renderScale, renderScale - halfTexel);
+
+    vec3 result = texture(screenTexture, sceneCoords).rgb;
 
     if(useBloom){
-        vec3 bloomColor = texture(bloomBlurTexture, TexCoords).rgb;
+        vec3 bloomColor = texture(bloomBlurTexture, sceneCoords).rgb;
         vec3 dirtColor = vec3(0.0);
         
         if(useDirtTexture){
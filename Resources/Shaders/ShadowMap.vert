@@ -2,21 +2,27 @@
 
 const int MAX_BONE_INFLUENCE = 4;
 const int MAX_BONES = 100;
+const uint NO_BONE = 255u;
 
 layout (location = 0) in vec3 vertexPosition;
-layout (location = 1) in vec3 vertexNormal;
+layout (location = 1) in vec2 vertexNormal; // octahedral
 layout (location = 2) in vec2 vertexTexCoord;
-layout (location = 3) in vec3 vertexTangent;
-layout (location = 4) in ivec4 boneIDsIn;
+layout (location = 3) in vec2 vertexTangent; // octahedral
+layout (location = 4) in uvec4 boneIDsIn; // NO_BONE for the unused influences
 layout (location = 5) in vec4 weightsIn;
+layout (location = 6) in mat4 instanceModel; // per instance, locations 6 to 9
 
 out vec4 FragPos;
 
 uniform mat4 lightSpaceMatrix;
-uniform mat4 model;
 uniform mat4 finalBonesMatrices[MAX_BONES];
 uniform bool isPlaying;
 
+int BoneID(uint id)
+{
+    return id == NO_BONE ? -1 : int(id);
+}
+
 void main()
 {
     float weights[MAX_BONE_INFLUENCE];
@@ -26,10 +32,10 @@ void main()
     weights[3] = weightsIn.w;
 
     int boneIDs[MAX_BONE_INFLUENCE];
-    boneIDs[0] = boneIDsIn.x;
-    boneIDs[1] = boneIDsIn.y;
-    boneIDs[2] = boneIDsIn.z;
-    boneIDs[3] = boneIDsIn.w;
+    boneIDs[0] = BoneID(boneIDsIn.x);
+    boneIDs[1] = BoneID(boneIDsIn.y);
+    boneIDs[2] = BoneID(boneIDsIn.z);
+    boneIDs[3] = BoneID(boneIDsIn.w);
 
     vec4 totalPosition = vec4(0.0f);
 
@@ -51,6 +57,6 @@ void main()
         totalPosition = vec4(vertexPosition, 1.0f);
     }
     
-    FragPos = model * totalPosition;
-    gl_Position = lightSpaceMatrix * model * totalPosition;
+    FragPos = instanceModel * totalPosition;
+    gl_Position = lightSpaceMatrix * instanceModel * totalPosition;
 }
@@ -0,0 +1,12 @@
+#version 460 core
+
+in ShadowVertex{
+    vec4 FragPos;
+    flat vec3 LightPos;
+    flat int Layer;
+    flat int Viewport;
+} fs_in;
+
+void main()
+{
+}
\ No newline at end of file
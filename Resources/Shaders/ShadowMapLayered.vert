@@ -0,0 +1,91 @@
+#version 460 core
+#extension GL_ARB_shader_viewport_layer_array : enable
+#extension GL_AMD_vertex_shader_layer : enable
+#extension GL_AMD_vertex_shader_viewport_index : enable
+
+const int MAX_BONE_INFLUENCE = 4;
+const int MAX_BONES = 100;
+const uint NO_BONE = 255u;
+
+layout (location = 0) in vec3 vertexPosition;
+layout (location = 1) in vec2 vertexNormal; // octahedral
+layout (location = 2) in vec2 vertexTexCoord;
+layout (location = 3) in vec2 vertexTangent; // octahedral
+layout (location = 4) in uvec4 boneIDsIn; // NO_BONE for the unused influences
+layout (location = 5) in vec4 weightsIn;
+layout (location = 6) in mat4 instanceModel; // per instance, locations 6 to 9
+layout (location = 13) in float instanceView; // per instance, the view of the pass it is drawn into
+
+struct ShadowLayer{
+    mat4 lightSpaceMatrix;
+    vec4 lightPosition;
+    int layer;
+    int viewport; // 0 for the whole layer, 1 + the cascade for its quadrant
+};
+
+layout (std430, binding = 13) readonly buffer ShadowLayers{
+    ShadowLayer layers[];
+};
+
+out ShadowVertex{
+    vec4 FragPos;
+    flat vec3 LightPos;
+    flat int Layer; // read by the geometry shader when gl_Layer and gl_ViewportIndex can't be written here
+    flat int Viewport;
+} vs_out;
+
+uniform mat4 finalBonesMatrices[MAX_BONES];
+uniform bool isPlaying;
+
+int BoneID(uint id)
+{
+    return id == NO_BONE ? -1 : int(id);
+}
+
+void main()
+{
+    float weights[MAX_BONE_INFLUENCE];
+    weights[0] = weightsIn.x;
+    weights[1] = weightsIn.y;
+    weights[2] = weightsIn.z;
+    weights[3] = weightsIn.w;
+
+    int boneIDs[MAX_BONE_INFLUENCE];
+    boneIDs[0] = BoneID(boneIDsIn.x);
+    boneIDs[1] = BoneID(boneIDsIn.y);
+    boneIDs[2] = BoneID(boneIDsIn.z);
+    boneIDs[3] = BoneID(boneIDsIn.w);
+
+    vec4 totalPosition = vec4(0.0f);
+
+    if(isPlaying){
+        for(int i = 0; i < MAX_BONE_INFLUENCE; i++){  
+            if(boneIDs[i] == -1 && i == 0){                     //no bones for this vertex, just keep initial values
+                totalPosition = vec4(vertexPosition, 1.0f);
+                break;
+            }
+            
+            if(boneIDs[i] >= MAX_BONES || boneIDs[i] == -1){    //nothing at this index, skip it
+                continue;
+            }
+
+            vec4 localPosition = finalBonesMatrices[boneIDs[i]] * vec4(vertexPosition, 1.0f) * weights[i];
+            totalPosition += localPosition;
+        }
+    }else{
+        totalPosition = vec4(vertexPosition, 1.0f);
+    }
+    
+    int view = int(instanceView);
+
+    vs_out.FragPos = instanceModel * totalPosition;
+    vs_out.LightPos = layers[view].lightPosition.xyz;
+    vs_out.Layer = layers[view].layer;
+    vs_out.Viewport = layers[view].viewport;
+    gl_Position = layers[view].lightSpaceMatrix * vs_out.FragPos;
+
+#if defined(GL_ARB_shader_viewport_layer_array) || (defined(GL_AMD_vertex_shader_layer) && defined(GL_AMD_vertex_shader_viewport_index))
+    gl_Layer = vs_out.Layer;
+    gl_ViewportIndex = vs_out.Viewport;
+#endif
+}
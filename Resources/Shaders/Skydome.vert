@@ -3,8 +3,11 @@ layout (location = 0) in vec3 aPos;
 
 out vec3 TexCoords;
 
-uniform mat4 projection;
-uniform mat4 view;
+layout(std140, binding = 0) uniform Camera{
+    mat4 view;
+    mat4 projection;
+    vec4 camPos;
+};
 uniform mat4 model;
 
 void main()
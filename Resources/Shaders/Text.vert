@@ -1,15 +1,25 @@
 #version 460 core
 layout(location = 0) in vec2 vertex;
 
+struct Glyph{
+    vec2 position;
+    float size;
+    int letter;
+};
+
+layout(std430, binding = 10) readonly buffer Glyphs{
+    Glyph glyphs[];
+};
+
 out vec2 TexCoords;
-out int index;
+out flat int letter;
 
-uniform mat4 transforms[100];
 uniform mat4 proj;
 
 void main(){
-    gl_Position = proj * transforms[gl_InstanceID] * vec4(vertex.xy, 0.0, 1.0);
-    index = gl_InstanceID;
+    Glyph glyph = glyphs[gl_InstanceID];
+    gl_Position = proj * vec4(glyph.position + vertex.xy * glyph.size, 0.0, 1.0);
+    letter = glyph.letter;
     TexCoords = vertex.xy;
     TexCoords.y = 1.0f - TexCoords.y;
 }
\ No newline at end of file
@@ -6,6 +6,9 @@
 #include <assimp/Importer.hpp>
 #include <assimp/postprocess.h>
 
+static constexpr UniformHandle FINAL_BONES_MATRICES("finalBonesMatrices");
+static constexpr UniformHandle IS_PLAYING("isPlaying");
+
 Animator::Animator(const std::string& animationPath, Model& model, float ticksPerSecond)
     : m_CurrentTime(0.0f), m_DeltaTime(0.0f)
 {
@@ -95,28 +98,22 @@ void Animator::UploadFinalBoneMatrices()
     Shader& shader = GetGBufferShader();
     shader.Bind();
 
-    if(m_IsPlaying){
-        for(unsigned int i = 0; i < m_FinalBoneMatrices.size(); i++){
-            std::string uniformName = "finalBonesMatrices[" + std::to_string(i) + "]";
-            shader.SetUniformMat4fv(uniformName, m_FinalBoneMatrices[i]);
-        } 
+    if(m_IsPlaying && !m_FinalBoneMatrices.empty()){ // the matrices are contiguous, so the whole array goes in one call
+        shader.SetUniformMat4fv(FINAL_BONES_MATRICES, m_FinalBoneMatrices[0], m_FinalBoneMatrices.size());
     }
 
-    shader.SetUniform1i("isPlaying", m_IsPlaying);
+    shader.SetUniform1i(IS_PLAYING, m_IsPlaying);
 }
 
 void Animator::UploadFinalBoneMatrices(Shader& shader)
 {
     shader.Bind();
 
-    if(m_IsPlaying){
-        for(unsigned int i = 0; i < m_FinalBoneMatrices.size(); i++){
-            std::string uniformName = "finalBonesMatrices[" + std::to_string(i) + "]";
-            shader.SetUniformMat4fv(uniformName, m_FinalBoneMatrices[i]);
-        } 
+    if(m_IsPlaying && !m_FinalBoneMatrices.empty()){ // the matrices are contiguous, so the whole array goes in one call
+        shader.SetUniformMat4fv(FINAL_BONES_MATRICES, m_FinalBoneMatrices[0], m_FinalBoneMatrices.size());
     }
 
-    shader.SetUniform1i("isPlaying", m_IsPlaying);
+    shader.SetUniform1i(IS_PLAYING, m_IsPlaying);
 }
 
 void Animator::SetCurrentAnimation(unsigned int index)
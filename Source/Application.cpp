@@ -26,7 +26,13 @@
 #include <Animator.hpp>
 #include <MousePicking.hpp>
 #include <Skydome.hpp>
+#include <UniformBlocks.hpp>
+#include <StreamBuffer.hpp>
+#include <DebugDraw.hpp>
 #include <SettingsMenu.hpp>
+#include <LightClustering.hpp>
+#include <DynamicResolution.hpp>
+#include <GPUCulling.hpp>
 
 #include <gtc/matrix_transform.hpp>
 #include <gtc/type_ptr.hpp>
@@ -92,6 +98,11 @@ void Application::Run()
             ShouldDisplayTimers(true);
         }
 
+        BeginStreamFrame();
+
+        // ImGui sets state behind the cache, start each frame from a known state
+        InvalidateGLState();
+
         PollEvents();
         HandleInputs(deltaTime);
 
@@ -124,12 +135,26 @@ void Application::Run()
         #ifdef DEBUG
             drawn = 0;
             culled = 0; 
+            bounds_rebuilt = 0;
+            state_changes = 0;
+            state_changes_unsorted = 0;
+            gl_calls_issued = 0;
+            gl_calls_elided = 0;
+            triangles = 0;
+            shadow_views = 0;
+            shadow_views_rendered = 0;
+            shadow_caches_rendered = 0;
         #endif
 
-        Timer timer2("GBUFFER_PASS");
+        BeginDynamicResolutionFrame();
 
-        GetDeferredShader().Bind();
-        GetDeferredShader().SetUniform3fv("camPos", GetCamera().GetPosition(), 1);
+        Timer timer1("DRAW_LISTS");
+        BuildDrawLists(m_MapEditMode && !GetShowSettingsMenu());
+        timer1.PrintTime();
+
+        Timer timer_depth("DEPTH_PREPASS");
+
+        UpdateCameraBlock(GetCamera().GetViewMatrix(), GetCamera().GetProjectionMatrix(), GetCamera().GetPosition());
 
         ClearColor(0, 0, 0, 1);
         ClearScreen();
@@ -138,15 +163,25 @@ void Application::Run()
         gbuffer.Bind();
         ClearScreen();
 
+        // the scene passes draw the bottom left corner of the targets, up to the post-processing pass
+        SetRenderViewport();
+
         DisableColorBlend();
 
+        DrawDepthPrepass();
+
+        timer_depth.PrintTime();
+
+        Timer timer2("GBUFFER_PASS");
+
         DrawModels(GetGBufferShader(), GetCamera().GetViewMatrix());
 
         EnableColorBlend();
 
         timer2.PrintTime();
 
-        Timer timer3("SHADOW_MAPPING");
+        // named by the path, so the timings of the layered and of the per map submission can be compared
+        Timer timer3(GetUseLayeredShadows() && !GetUseGPUCulling() ? "SHADOW_MAPPING_LAYERED" : "SHADOW_MAPPING");
 
         GetDeferredShader().Bind();
 
@@ -155,6 +190,10 @@ void Application::Run()
 
         timer3.PrintTime();
 
+        Timer timer_clustering("LIGHT_CLUSTERING");
+        AssignLightsToClusters();
+        timer_clustering.PrintTime();
+
         Timer timer4("DEFERRED_PASS");
         DeferredPass(gbuffer, GetDeferredShader(), GetCamera());
         timer4.PrintTime();
@@ -169,7 +208,14 @@ void Application::Run()
             DrawCube(spotLight.pos, glm::vec4(spotLight.color, 1.0f));
         }
 
-        DrawSkydome(GetCamera().GetViewMatrix(), GetCamera().GetProjectionMatrix(), glm::translate(glm::mat4(1.0f), GetCamera().GetPosition()));
+        DrawSkydome(glm::translate(glm::mat4(1.0f), GetCamera().GetPosition()));
+
+        // the skydome is the last draw that reads the camera and light blocks
+        FenceUniformBlocks();
+
+        // debug shapes are drawn in the HDR framebuffer, where they can be depth tested against the scene
+        if(g_DrawBoundingBoxes) DrawBoundingBoxes();
+        FlushDebugDraw(GetCamera().GetProjectionMatrix() * GetCamera().GetViewMatrix());
 
         //bloom pass
 
@@ -183,6 +229,7 @@ void Application::Run()
 
         timer6.PrintTime();
 
+        SetViewport(0, 0, g_ScreenWidth, g_ScreenHeight);
         PostProcessingPass();
 
         DrawFPS(1.0f / deltaTime, 10, 10);
@@ -190,10 +237,16 @@ void Application::Run()
         DrawText(FormatText("Camera pos: %f %f %f", GetCamera().GetPosition().x, GetCamera().GetPosition().y, GetCamera().GetPosition().z), 10, 70, 1, glm::vec4(1.0f, 1.0f, 1.0f, 1.0f));
         
         #ifdef DEBUG
-            DrawText(FormatText("Drawn: %u Culled: %u", drawn, culled), 10, 100, 1, glm::vec4(1.0f, 1.0f, 1.0f, 1.0f));
+            DrawText(FormatText("Drawn: %u Culled: %u Bounds rebuilt: %u", drawn, culled, bounds_rebuilt), 10, 100, 1, glm::vec4(1.0f, 1.0f, 1.0f, 1.0f));
+            DrawText(FormatText("State changes: %u (unsorted: %u)", state_changes, state_changes_unsorted), 10, 130, 1, glm::vec4(1.0f, 1.0f, 1.0f, 1.0f));
+            DrawText(FormatText("GL calls: %u Elided: %u", gl_calls_issued, gl_calls_elided), 10, 160, 1, glm::vec4(1.0f, 1.0f, 1.0f, 1.0f));
+            DrawText(FormatText("Triangles: %u", triangles), 10, 190, 1, glm::vec4(1.0f, 1.0f, 1.0f, 1.0f));
+            DrawText(FormatText("Resolution: %dx%d (%.0f%%, %s) GPU: %.2f ms Target: %.2f ms", GetRenderWidth(), GetRenderHeight(), GetRenderScale() * 100.0f,
+                                GetUseDynamicResolution() ? "dynamic" : "fixed", GetGPUFrameTime(), GetTargetFrameTime()), 10, 220, 1, glm::vec4(1.0f, 1.0f, 1.0f, 1.0f));
+            DrawText(FormatText("Shadow maps rendered: %u/%u (static caches: %u)", shadow_views_rendered, shadow_views, shadow_caches_rendered), 10, 250, 1, glm::vec4(1.0f, 1.0f, 1.0f, 1.0f));
+            DrawText(FormatText("Cascade casters: %u %u %u %u GPU: %.2f %.2f %.2f %.2f ms", GetCascadeCasters(0), GetCascadeCasters(1), GetCascadeCasters(2), GetCascadeCasters(3),
+                                GetShadowCascadeTime(0), GetShadowCascadeTime(1), GetShadowCascadeTime(2), GetShadowCascadeTime(3)), 10, 280, 1, glm::vec4(1.0f, 1.0f, 1.0f, 1.0f));
         #endif
-        
-        if(g_DrawBoundingBoxes) DrawBoundingBoxes();
 
         if(GetShowSettingsMenu()){
             SettingsMenu();
@@ -203,6 +256,9 @@ void Application::Run()
             EditMode();
         }
 
+        EndDynamicResolutionFrame();
+
+        EndStreamFrame();
         SwapBuffers();
 
         if(m_ShouldTakeScreenshot){
@@ -229,6 +285,7 @@ void Application::HandleInputs(double deltaTime)
     if(IsKeyPressed(KEY_2) && IsKeyDown(KEY_LEFT_CONTROL)) SetDeferredMode(DEFERRED_NORMAL);
     if(IsKeyPressed(KEY_3) && IsKeyDown(KEY_LEFT_CONTROL)) SetDeferredMode(DEFERRED_ALBEDO);
     if(IsKeyPressed(KEY_4) && IsKeyDown(KEY_LEFT_CONTROL)) SetDeferredMode(DEFERRED_SHADING);
+    if(IsKeyPressed(KEY_5) && IsKeyDown(KEY_LEFT_CONTROL)) SetDeferredMode(DEFERRED_LIGHT_HEATMAP);
 
     if(!ImGui::GetIO().WantCaptureKeyboard || !m_MapEditMode){
         if(IsKeyDown(KEY_W) || IsKeyDown(KEY_UP))   GetCamera().ProcessKeyboard(Camera::Movement::FORWARD, deltaTime);
@@ -273,20 +330,17 @@ void Application::HandleInputs(double deltaTime)
 
 void Application::DrawBoundingBoxes()
 {
-    DisableDepthTest();
-
     auto& Models = GetModels();
 
     for(auto& [id, model] : Models){
         auto& transforms = model.GetTransforms();
+        auto& meshes = model.GetMeshes();
 
-        for(uint32_t i = 0; i < transforms.size(); i++){
-            auto& meshes = model.GetMeshes();
-            auto& transform = transforms[i];
+        model.UpdateBounds(nullptr, GetBoundsRevision());
 
-            for(auto &mesh : meshes){
-                AABB bb = mesh.GetAABB();
-                OBB obb = OBBFromAABB(bb, transform); //use the OBB so you can rotate the model
+        for(uint32_t i = 0; i < transforms.size(); i++){
+            for(uint32_t j = 0; j < meshes.size(); j++){
+                const OBB& obb = model.GetWorldOBB(i, j); //use the OBB so you can rotate the model
 
                 glm::vec4 color = glm::vec4(1.0f, 0.0f, 0.0f, 1.0f);
 
@@ -294,42 +348,10 @@ void Application::DrawBoundingBoxes()
                     color = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);
                 }
 
-                //Get corners of the OBB. You could just draw transform * AABB but this ensures that the OBB is correct 
-                std::vector<glm::vec3> corners(8);
-    
-                glm::vec3 axisX = obb.rotation[0];
-                glm::vec3 axisY = obb.rotation[1];
-                glm::vec3 axisZ = obb.rotation[2];
-                glm::vec3 halfExtents = obb.extents;
-
-                corners[0] = obb.center + axisX * halfExtents.x + axisY * halfExtents.y + axisZ * halfExtents.z;
-                corners[1] = obb.center + axisX * halfExtents.x + axisY * halfExtents.y - axisZ * halfExtents.z;
-                corners[2] = obb.center + axisX * halfExtents.x - axisY * halfExtents.y + axisZ * halfExtents.z;
-                corners[3] = obb.center + axisX * halfExtents.x - axisY * halfExtents.y - axisZ * halfExtents.z;
-                corners[4] = obb.center - axisX * halfExtents.x + axisY * halfExtents.y + axisZ * halfExtents.z;
-                corners[5] = obb.center - axisX * halfExtents.x + axisY * halfExtents.y - axisZ * halfExtents.z;
-                corners[6] = obb.center - axisX * halfExtents.x - axisY * halfExtents.y + axisZ * halfExtents.z;
-                corners[7] = obb.center - axisX * halfExtents.x - axisY * halfExtents.y - axisZ * halfExtents.z;
-            
-                DrawLine3D(corners[0], corners[1], color);
-                DrawLine3D(corners[1], corners[3], color);
-                DrawLine3D(corners[3], corners[2], color);
-                DrawLine3D(corners[2], corners[0], color);
-
-                DrawLine3D(corners[4], corners[5], color);
-                DrawLine3D(corners[5], corners[7], color);
-                DrawLine3D(corners[7], corners[6], color);
-                DrawLine3D(corners[6], corners[4], color);
-
-                DrawLine3D(corners[0], corners[4], color);
-                DrawLine3D(corners[1], corners[5], color);
-                DrawLine3D(corners[2], corners[6], color);
-                DrawLine3D(corners[3], corners[7], color);
+                DebugBox(obb, color, false);
             }
         }
     }
-
-    EnableDepthTest();
 }
 
 void Application::EditMode()
@@ -520,27 +542,33 @@ void Application::EditMode()
     float translation[3], rotation[3], scale[3];
     if(m_SelectedModel.model_id != std::numeric_limits<uint32_t>::max()){
         ImGuizmo::SetRect(0, 0, g_ScreenWidth, g_ScreenHeight);
-        ImGuizmo::Manipulate(glm::value_ptr(GetCamera().GetViewMatrix()), glm::value_ptr(GetCamera().GetProjectionMatrix()), m_GizmoMode, ImGuizmo::MODE::WORLD, glm::value_ptr(selected_model->GetTransform(m_SelectedModel.transform_index)));
+        bool changed = ImGuizmo::Manipulate(glm::value_ptr(GetCamera().GetViewMatrix()), glm::value_ptr(GetCamera().GetProjectionMatrix()), m_GizmoMode, ImGuizmo::MODE::WORLD, glm::value_ptr(selected_model->GetTransform(m_SelectedModel.transform_index)));
         
         ImGuizmo::DecomposeMatrixToComponents(glm::value_ptr(selected_model->GetTransform(m_SelectedModel.transform_index)), translation, rotation, scale);
 
         ImGui::Text("Translation");
         ImGui::SameLine();
-        ImGui::InputFloat3("##translation", translation);
+        bool edited = ImGui::InputFloat3("##translation", translation);
 
         ImGui::Text("Rotation");
         ImGui::SameLine();
-        ImGui::InputFloat3("##rotation", rotation);
+        edited |= ImGui::InputFloat3("##rotation", rotation);
 
         ImGui::Text("Scale");
         ImGui::SameLine();
-        ImGui::InputFloat3("##scale", scale);
-
-        ImGuizmo::RecomposeMatrixFromComponents(translation, rotation, scale, glm::value_ptr(selected_model->GetTransform(m_SelectedModel.transform_index)));
+        edited |= ImGui::InputFloat3("##scale", scale);
+
+        // recomposing an unchanged matrix would still move it by the rounding errors of the round trip
+        if(edited){
+            ImGuizmo::RecomposeMatrixFromComponents(translation, rotation, scale, glm::value_ptr(selected_model->GetTransform(m_SelectedModel.transform_index)));
+            selected_model->MarkTransformDirty(m_SelectedModel.transform_index);
+        }else if(changed){ // the gizmo writes the matrix itself
+            selected_model->MarkTransformDirty(m_SelectedModel.transform_index);
+        }
     }
 
     ImGui::End();
 
     ImGui::Render();
     ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
-}
+}
\ No newline at end of file
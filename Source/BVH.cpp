@@ -0,0 +1,378 @@
+#include <BVH.hpp>
+
+#include <glm.hpp>
+
+#include <algorithm>
+#include <cassert>
+
+static inline AABB Union(const AABB& a, const AABB& b)
+{
+    return AABB(glm::min(a.min, b.min), glm::max(a.max, b.max));
+}
+
+static inline bool Contains(const AABB& outer, const AABB& inner)
+{
+    return outer.min.x <= inner.min.x && outer.min.y <= inner.min.y && outer.min.z <= inner.min.z &&
+           outer.max.x >= inner.max.x && outer.max.y >= inner.max.y && outer.max.z >= inner.max.z;
+}
+
+static inline float SurfaceArea(const AABB& aabb)
+{
+    glm::vec3 d = aabb.max - aabb.min;
+    return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+}
+
+int BVH::AllocateNode()
+{
+    if(m_FreeList == BVH_NULL_NODE){
+        m_Nodes.emplace_back();
+        m_Nodes.back().parent = m_FreeList;
+        m_Nodes.back().height = -1;
+        m_FreeList = m_Nodes.size() - 1;
+    }
+
+    int node = m_FreeList;
+    m_FreeList = m_Nodes[node].parent;
+
+    m_Nodes[node].parent = BVH_NULL_NODE;
+    m_Nodes[node].child1 = BVH_NULL_NODE;
+    m_Nodes[node].child2 = BVH_NULL_NODE;
+    m_Nodes[node].height = 0;
+    m_Nodes[node].data = {nullptr, nullptr, 0, 0};
+
+    return node;
+}
+
+void BVH::FreeNode(int node)
+{
+    m_Nodes[node].parent = m_FreeList;
+    m_Nodes[node].height = -1;
+    m_FreeList = node;
+}
+
+int BVH::CreateProxy(const AABB& aabb, const BVHProxy& data)
+{
+    int proxy_id = AllocateNode();
+
+    m_Nodes[proxy_id].aabb = AABB(aabb.min - glm::vec3(BVH_FAT_MARGIN), aabb.max + glm::vec3(BVH_FAT_MARGIN));
+    m_Nodes[proxy_id].data = data;
+
+    InsertLeaf(proxy_id);
+    m_ProxyCount++;
+
+    return proxy_id;
+}
+
+void BVH::DestroyProxy(int proxy_id)
+{
+    assert(proxy_id >= 0 && proxy_id < (int)m_Nodes.size() && m_Nodes[proxy_id].IsLeaf());
+
+    RemoveLeaf(proxy_id);
+    FreeNode(proxy_id);
+    m_ProxyCount--;
+}
+
+bool BVH::MoveProxy(int proxy_id, const AABB& aabb)
+{
+    assert(proxy_id >= 0 && proxy_id < (int)m_Nodes.size() && m_Nodes[proxy_id].IsLeaf());
+
+    if(Contains(m_Nodes[proxy_id].aabb, aabb)){
+        return false;
+    }
+
+    RemoveLeaf(proxy_id);
+    m_Nodes[proxy_id].aabb = AABB(aabb.min - glm::vec3(BVH_FAT_MARGIN), aabb.max + glm::vec3(BVH_FAT_MARGIN));
+    InsertLeaf(proxy_id);
+
+    return true;
+}
+
+void BVH::Clear()
+{
+    m_Nodes.clear();
+    m_Root = BVH_NULL_NODE;
+    m_FreeList = BVH_NULL_NODE;
+    m_ProxyCount = 0;
+}
+
+void BVH::InsertLeaf(int leaf)
+{
+    if(m_Root == BVH_NULL_NODE){
+        m_Root = leaf;
+        m_Nodes[m_Root].parent = BVH_NULL_NODE;
+        return;
+    }
+
+    // Find the best sibling by descending the tree with the surface area heuristic
+    AABB leaf_aabb = m_Nodes[leaf].aabb;
+    int index = m_Root;
+
+    while(!m_Nodes[index].IsLeaf()){
+        int child1 = m_Nodes[index].child1;
+        int child2 = m_Nodes[index].child2;
+
+        float area = SurfaceArea(m_Nodes[index].aabb);
+        float combined_area = SurfaceArea(Union(m_Nodes[index].aabb, leaf_aabb));
+
+        float cost = 2.0f * combined_area; // cost of creating a new parent for this node and the new leaf
+        float inheritance_cost = 2.0f * (combined_area - area); // minimum cost of pushing the leaf further down the tree
+
+        auto ChildCost = [&](int child){
+            float new_area = SurfaceArea(Union(leaf_aabb, m_Nodes[child].aabb));
+            if(m_Nodes[child].IsLeaf()){
+                return new_area + inheritance_cost;
+            }
+            return (new_area - SurfaceArea(m_Nodes[child].aabb)) + inheritance_cost;
+        };
+
+        float cost1 = ChildCost(child1);
+        float cost2 = ChildCost(child2);
+
+        if(cost < cost1 && cost < cost2){
+            break;
+        }
+
+        index = cost1 < cost2 ? child1 : child2;
+    }
+
+    int sibling = index;
+
+    // Create a new parent
+    int old_parent = m_Nodes[sibling].parent;
+    int new_parent = AllocateNode();
+    m_Nodes[new_parent].parent = old_parent;
+    m_Nodes[new_parent].aabb = Union(leaf_aabb, m_Nodes[sibling].aabb);
+    m_Nodes[new_parent].height = m_Nodes[sibling].height + 1;
+    m_Nodes[new_parent].child1 = sibling;
+    m_Nodes[new_parent].child2 = leaf;
+    m_Nodes[sibling].parent = new_parent;
+    m_Nodes[leaf].parent = new_parent;
+
+    if(old_parent != BVH_NULL_NODE){
+        if(m_Nodes[old_parent].child1 == sibling){
+            m_Nodes[old_parent].child1 = new_parent;
+        }else{
+            m_Nodes[old_parent].child2 = new_parent;
+        }
+    }else{
+        m_Root = new_parent;
+    }
+
+    // Walk back up the tree fixing heights and boxes
+    index = m_Nodes[leaf].parent;
+    while(index != BVH_NULL_NODE){
+        index = Balance(index);
+
+        int child1 = m_Nodes[index].child1;
+        int child2 = m_Nodes[index].child2;
+
+        m_Nodes[index].height = 1 + std::max(m_Nodes[child1].height, m_Nodes[child2].height);
+        m_Nodes[index].aabb = Union(m_Nodes[child1].aabb, m_Nodes[child2].aabb);
+
+        index = m_Nodes[index].parent;
+    }
+}
+
+void BVH::RemoveLeaf(int leaf)
+{
+    if(leaf == m_Root){
+        m_Root = BVH_NULL_NODE;
+        return;
+    }
+
+    int parent = m_Nodes[leaf].parent;
+    int grand_parent = m_Nodes[parent].parent;
+    int sibling = m_Nodes[parent].child1 == leaf ? m_Nodes[parent].child2 : m_Nodes[parent].child1;
+
+    if(grand_parent != BVH_NULL_NODE){
+        // Destroy the parent and connect the sibling to the grand parent
+        if(m_Nodes[grand_parent].child1 == parent){
+            m_Nodes[grand_parent].child1 = sibling;
+        }else{
+            m_Nodes[grand_parent].child2 = sibling;
+        }
+        m_Nodes[sibling].parent = grand_parent;
+        FreeNode(parent);
+
+        int index = grand_parent;
+        while(index != BVH_NULL_NODE){
+            index = Balance(index);
+
+            int child1 = m_Nodes[index].child1;
+            int child2 = m_Nodes[index].child2;
+
+            m_Nodes[index].aabb = Union(m_Nodes[child1].aabb, m_Nodes[child2].aabb);
+            m_Nodes[index].height = 1 + std::max(m_Nodes[child1].height, m_Nodes[child2].height);
+
+            index = m_Nodes[index].parent;
+        }
+    }else{
+        m_Root = sibling;
+        m_Nodes[sibling].parent = BVH_NULL_NODE;
+        FreeNode(parent);
+    }
+}
+
+// Perform a left or right rotation if node A is imbalanced. Returns the new root of the subtree
+int BVH::Balance(int iA)
+{
+    Node* A = &m_Nodes[iA];
+    if(A->IsLeaf() || A->height < 2){
+        return iA;
+    }
+
+    int iB = A->child1;
+    int iC = A->child2;
+    Node* B = &m_Nodes[iB];
+    Node* C = &m_Nodes[iC];
+
+    int balance = C->height - B->height;
+
+    // Rotate C up
+    if(balance > 1){
+        int iF = C->child1;
+        int iG = C->child2;
+        Node* F = &m_Nodes[iF];
+        Node* G = &m_Nodes[iG];
+
+        // Swap A and C
+        C->child1 = iA;
+        C->parent = A->parent;
+        A->parent = iC;
+
+        // A's old parent should point to C
+        if(C->parent != BVH_NULL_NODE){
+            if(m_Nodes[C->parent].child1 == iA){
+                m_Nodes[C->parent].child1 = iC;
+            }else{
+                m_Nodes[C->parent].child2 = iC;
+            }
+        }else{
+            m_Root = iC;
+        }
+
+        // Rotate
+        if(F->height > G->height){
+            C->child2 = iF;
+            A->child2 = iG;
+            G->parent = iA;
+            A->aabb = Union(B->aabb, G->aabb);
+            C->aabb = Union(A->aabb, F->aabb);
+
+            A->height = 1 + std::max(B->height, G->height);
+            C->height = 1 + std::max(A->height, F->height);
+        }else{
+            C->child2 = iG;
+            A->child2 = iF;
+            F->parent = iA;
+            A->aabb = Union(B->aabb, F->aabb);
+            C->aabb = Union(A->aabb, G->aabb);
+
+            A->height = 1 + std::max(B->height, F->height);
+            C->height = 1 + std::max(A->height, G->height);
+        }
+
+        return iC;
+    }
+
+    // Rotate B up
+    if(balance < -1){
+        int iD = B->child1;
+        int iE = B->child2;
+        Node* D = &m_Nodes[iD];
+        Node* E = &m_Nodes[iE];
+
+        // Swap A and B
+        B->child1 = iA;
+        B->parent = A->parent;
+        A->parent = iB;
+
+        // A's old parent should point to B
+        if(B->parent != BVH_NULL_NODE){
+            if(m_Nodes[B->parent].child1 == iA){
+                m_Nodes[B->parent].child1 = iB;
+            }else{
+                m_Nodes[B->parent].child2 = iB;
+            }
+        }else{
+            m_Root = iB;
+        }
+
+        // Rotate
+        if(D->height > E->height){
+            B->child2 = iD;
+            A->child1 = iE;
+            E->parent = iA;
+            A->aabb = Union(C->aabb, E->aabb);
+            B->aabb = Union(A->aabb, D->aabb);
+
+            A->height = 1 + std::max(C->height, E->height);
+            B->height = 1 + std::max(A->height, D->height);
+        }else{
+            B->child2 = iE;
+            A->child1 = iD;
+            D->parent = iA;
+            A->aabb = Union(C->aabb, D->aabb);
+            B->aabb = Union(A->aabb, E->aabb);
+
+            A->height = 1 + std::max(C->height, D->height);
+            B->height = 1 + std::max(A->height, E->height);
+        }
+
+        return iB;
+    }
+
+    return iA;
+}
+
+void BVH::CollectLeaves(int node, std::vector<int>& leaves, std::vector<int>& stack) const
+{
+    size_t base = stack.size();
+    stack.push_back(node);
+
+    while(stack.size() > base){
+        int index = stack.back();
+        stack.pop_back();
+
+        if(m_Nodes[index].IsLeaf()){
+            leaves.push_back(index);
+        }else{
+            stack.push_back(m_Nodes[index].child1);
+            stack.push_back(m_Nodes[index].child2);
+        }
+    }
+}
+
+void BVH::QueryFrustum(Frustum& frustum, std::vector<int>& inside, std::vector<int>& intersecting, std::vector<int>& stack) const
+{
+    inside.clear();
+    intersecting.clear();
+
+    if(m_Root == BVH_NULL_NODE){
+        return;
+    }
+
+    stack.clear();
+    stack.push_back(m_Root);
+
+    while(!stack.empty()){
+        int index = stack.back();
+        stack.pop_back();
+
+        const Node& node = m_Nodes[index];
+        FrustumIntersection result = AABBFrustumIntersection(frustum, node.aabb.min, node.aabb.max);
+
+        if(result == FRUSTUM_OUTSIDE){
+            continue;
+        }
+
+        if(result == FRUSTUM_INSIDE){ // accept the whole subtree
+            CollectLeaves(index, inside, stack);
+        }else if(node.IsLeaf()){
+            intersecting.push_back(index);
+        }else{
+            stack.push_back(node.child1);
+            stack.push_back(node.child2);
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <BoundingBox.hpp>
+#include <Frustum.hpp>
+
+#include <vector>
+#include <cstdint>
+
+class Model;
+class Animator;
+
+inline constexpr float BVH_FAT_MARGIN = 0.2f; // how much the stored boxes are enlarged, so small movements don't need a reinsertion
+inline constexpr int BVH_NULL_NODE = -1;
+
+/**
+ * \brief What a leaf of the scene tree refers to: one mesh of one instance of a model
+ */
+struct BVHProxy{
+    Model* model;
+    Animator* animator; // nullptr for static models
+    uint32_t transform_index;
+    uint32_t mesh_index;
+};
+
+/**
+ * \brief Dynamic AABB tree. Leaves store enlarged ("fat") world space AABBs, internal nodes the union of their children.
+ * The tree is kept balanced with rotations while inserting
+ */
+class BVH{
+public:
+    BVH() = default;
+    ~BVH() = default;
+
+    /**
+     * \returns the id of the new proxy
+     */
+    int CreateProxy(const AABB& aabb, const BVHProxy& data);
+    void DestroyProxy(int proxy_id);
+
+    /**
+     * \brief Refit a proxy after the object moved. The leaf is reinserted only if the new box is not contained in the fat one
+     * \returns true if the leaf was reinserted
+     */
+    bool MoveProxy(int proxy_id, const AABB& aabb);
+
+    inline void SetProxyData(int proxy_id, const BVHProxy& data) { m_Nodes[proxy_id].data = data; }
+    inline const BVHProxy& GetProxyData(int proxy_id) const { return m_Nodes[proxy_id].data; }
+    inline const AABB& GetFatAABB(int proxy_id) const { return m_Nodes[proxy_id].aabb; }
+    inline uint32_t GetProxyCount() const { return m_ProxyCount; }
+    inline int GetHeight() const { return m_Root == BVH_NULL_NODE ? 0 : m_Nodes[m_Root].height; }
+
+    /**
+     * \brief Walk the tree against the frustum. Subtrees that are completely inside are accepted without testing their leaves
+     * \param inside filled with the proxies whose fat AABB is completely inside the frustum
+     * \param intersecting filled with the proxies whose fat AABB intersects the frustum. They still need a precise test
+     * \param stack scratch memory of the caller, so queries from different threads don't share state
+     */
+    void QueryFrustum(Frustum& frustum, std::vector<int>& inside, std::vector<int>& intersecting, std::vector<int>& stack) const;
+
+    void Clear();
+
+private:
+    struct Node{
+        AABB aabb;
+        BVHProxy data;
+        int parent; // next free node when the node is in the free list
+        int child1;
+        int child2;
+        int height; // 0 for leaves, -1 for free nodes
+
+        inline bool IsLeaf() const { return child1 == BVH_NULL_NODE; }
+    };
+
+    int AllocateNode();
+    void FreeNode(int node);
+    void InsertLeaf(int leaf);
+    void RemoveLeaf(int leaf);
+    int Balance(int node);
+    void CollectLeaves(int node, std::vector<int>& leaves, std::vector<int>& stack) const;
+
+    std::vector<Node> m_Nodes;
+    int m_Root = BVH_NULL_NODE;
+    int m_FreeList = BVH_NULL_NODE;
+    uint32_t m_ProxyCount = 0;
+};
\ No newline at end of file
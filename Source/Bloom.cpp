@@ -1,7 +1,9 @@
 #include <Bloom.hpp>
+#include <OpenGL.hpp>
 #include <Renderer.hpp>
 #include <Globals.hpp>
 #include <ComputeShader.hpp>
+#include <DynamicResolution.hpp>
 
 #include <limits>
 
@@ -18,8 +20,7 @@ static ComputeShader g_BloomUpsampleShader;
 void InitBloom()
 {
     glGenTextures(1, &g_BloomTexture);
-    glActiveTexture(GL_TEXTURE10);
-    glBindTexture(GL_TEXTURE_2D, g_BloomTexture);
+    BindTexture(g_BloomTexture, 10);
 
     glTexStorage2D(GL_TEXTURE_2D, NUM_MIPS, GL_RGBA32F, g_ScreenWidth, g_ScreenHeight);
     glGenerateMipmap(GL_TEXTURE_2D);
@@ -39,8 +40,8 @@ void InitBloom()
 
 void DeinitBloom()
 {
-    glDeleteTextures(1, &g_BloomTexture);
-    glDeleteTextures(1, &g_BloomTexView);
+    DeleteTextures(1, &g_BloomTexture);
+    DeleteTextures(1, &g_BloomTexView);
 
     g_BloomFilterShader.Unload();
     g_BloomDownsampleShader.Unload();
@@ -51,11 +52,14 @@ void BloomPass()
 {
     Framebuffer& fbo = GetDeferredPassFramebuffer();
 
-    glBindFramebuffer(GL_FRAMEBUFFER, fbo.GetFBO());
+    // only the scaled corner of the deferred pass holds the scene, the mips are built over the same corner
+    int render_width = GetRenderWidth();
+    int render_height = GetRenderHeight();
+
+    BindFramebuffer(GL_FRAMEBUFFER, fbo.GetFBO());
     glReadBuffer(GL_COLOR_ATTACHMENT0);
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, g_BloomTexture);
-    glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, 0, g_ScreenWidth, g_ScreenHeight);
+    BindTexture(g_BloomTexture, 0);
+    glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, 0, render_width, render_height);
 
     g_BloomFilterShader.Bind();
     g_BloomFilterShader.SetUniform1f("gBloomThreshold", g_BloomThreshold);
@@ -63,8 +67,8 @@ void BloomPass()
 
     glBindImageTexture(0, g_BloomTexture, 0, GL_FALSE, 0, GL_READ_WRITE, GL_RGBA32F);
     
-    int groupCountX = glm::ceil(g_ScreenWidth / 16.0f);
-    int groupCountY = glm::ceil(g_ScreenHeight / 16.0f);
+    int groupCountX = glm::ceil(render_width / 16.0f);
+    int groupCountY = glm::ceil(render_height / 16.0f);
     glDispatchCompute(groupCountX, groupCountY, 1);
     
     glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
@@ -74,10 +78,10 @@ void BloomPass()
         glBindImageTexture(0, g_BloomTexture, i, GL_FALSE, 0, GL_READ_ONLY, GL_RGBA32F);
         glBindImageTexture(1, g_BloomTexture, i + 1, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA32F);
 
-        g_BloomDownsampleShader.SetUniform2i("srcResolution", g_ScreenWidth / (1 << i), g_ScreenHeight / (1 << i));
+        g_BloomDownsampleShader.SetUniform2i("srcResolution", render_width / (1 << i), render_height / (1 << i));
 
-        int width = g_ScreenWidth / (1 << (i + 1));
-        int height = g_ScreenHeight / (1 << (i + 1));
+        int width = render_width / (1 << (i + 1));
+        int height = render_height / (1 << (i + 1));
 
         groupCountX = glm::ceil(width / 16.0f);
         groupCountY = glm::ceil(height / 16.0f);
@@ -92,10 +96,10 @@ void BloomPass()
         glBindImageTexture(0, g_BloomTexture, i, GL_FALSE, 0, GL_READ_ONLY, GL_RGBA32F);
         glBindImageTexture(1, g_BloomTexture, i - 1, GL_FALSE, 0, GL_READ_WRITE, GL_RGBA32F);
 
-        g_BloomUpsampleShader.SetUniform2i("srcResolution", g_ScreenWidth / (1 << i), g_ScreenHeight / (1 << i));
+        g_BloomUpsampleShader.SetUniform2i("srcResolution", render_width / (1 << i), render_height / (1 << i));
 
-        int width = g_ScreenWidth / (1 << (i - 1));
-        int height = g_ScreenHeight / (1 << (i - 1));
+        int width = render_width / (1 << (i - 1));
+        int height = render_height / (1 << (i - 1));
 
         int groupCountX = glm::ceil(width / 16.0f);
         int groupCountY = glm::ceil(height / 16.0f);
@@ -105,7 +109,7 @@ void BloomPass()
         glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
     }
 
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    BindFramebuffer(GL_FRAMEBUFFER, 0);
 }
 
 unsigned int GetBloomTexture()
@@ -6,7 +6,7 @@
 
 OBB OBBFromAABB(const AABB& aabb, glm::mat4 modelMatrix)
 {
-    std::vector<glm::vec3> aabbVertices = {
+    const glm::vec3 aabbVertices[8] = {
         glm::vec3(aabb.min.x, aabb.min.y, aabb.min.z),
         glm::vec3(aabb.max.x, aabb.min.y, aabb.min.z),
         glm::vec3(aabb.min.x, aabb.max.y, aabb.min.z),
@@ -17,17 +17,13 @@ OBB OBBFromAABB(const AABB& aabb, glm::mat4 modelMatrix)
         glm::vec3(aabb.max.x, aabb.max.y, aabb.max.z)
     };
 
-    std::vector<glm::vec3> transformedVertices;
-    for(const auto& vertex : aabbVertices){
-        glm::vec4 transformedVertex = modelMatrix * glm::vec4(vertex, 1.0f);
-        transformedVertices.push_back(glm::vec3(transformedVertex));
-    }
-
+    glm::vec3 transformedVertices[8];
     glm::vec3 center(0.0f);
-    for(const auto& vertex : transformedVertices){
-        center += vertex;
+    for(int i = 0; i < 8; i++){
+        transformedVertices[i] = glm::vec3(modelMatrix * glm::vec4(aabbVertices[i], 1.0f));
+        center += transformedVertices[i];
     }
-    center /= static_cast<float>(transformedVertices.size());
+    center /= 8.0f;
 
     glm::vec3 scale;
     glm::quat rotationQuat;
@@ -52,8 +48,13 @@ OBB OBBFromAABB(const AABB& aabb, glm::mat4 modelMatrix)
 
 AABB AABBFromOBB(const OBB& obb)
 {
-    glm::vec3 min = obb.center - obb.extents;
-    glm::vec3 max = obb.center + obb.extents;
+    // project the extents of the rotated axes on the world axes
+    glm::vec3 halfSize = glm::abs(obb.rotation[0]) * obb.extents.x +
+                         glm::abs(obb.rotation[1]) * obb.extents.y +
+                         glm::abs(obb.rotation[2]) * obb.extents.z;
+
+    glm::vec3 min = obb.center - halfSize;
+    glm::vec3 max = obb.center + halfSize;
 
     return AABB(min, max);
 }
\ No newline at end of file
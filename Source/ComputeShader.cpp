@@ -1,7 +1,9 @@
 #include <ComputeShader.hpp>
+#include <OpenGL.hpp>
 #include <Log.hpp>
 
 #include <glad/glad.h>
+#include <gtc/type_ptr.hpp>
 
 #include <cstdio>
 #include <vector>
@@ -53,17 +55,20 @@ void ComputeShader::Load(const char* computeShaderPath)
         LogError("Failed to link compute shader: %s", infoLog);
     }
 
+    m_Uniforms.Build(m_ID);
+
     glDeleteShader(id);
 }
 
 void ComputeShader::Unload()
 {
     glDeleteProgram(m_ID);
+    m_Uniforms.Clear();
 }
 
 void ComputeShader::Bind()
 {
-    glUseProgram(m_ID);
+    UseProgram(m_ID);
 }
 
 void ComputeShader::Dispatch(unsigned int numGroupsX, unsigned int numGroupsY, unsigned int numGroupsZ)
@@ -71,37 +76,51 @@ void ComputeShader::Dispatch(unsigned int numGroupsX, unsigned int numGroupsY, u
     glDispatchCompute(numGroupsX, numGroupsY, numGroupsZ);
 }
 
-void ComputeShader::SetUniform1i(const std::string& name, int value)
+void ComputeShader::SetUniform1i(UniformHandle handle, int value)
 {
-    glUniform1i(GetUniformLocation(name), value);
+    glUniform1i(GetUniformLocation(handle), value);
 }
 
-void ComputeShader::SetUniform1f(const std::string& name, float value)
+void ComputeShader::SetUniform1ui(UniformHandle handle, unsigned int value)
 {
-    glUniform1f(GetUniformLocation(name), value);
+    glUniform1ui(GetUniformLocation(handle), value);
 }
 
-void ComputeShader::SetUniform2i(const std::string& name, int x, int y)
+void ComputeShader::SetUniform1f(UniformHandle handle, float value)
 {
-    glUniform2i(GetUniformLocation(name), x, y);
+    glUniform1f(GetUniformLocation(handle), value);
 }
 
-void ComputeShader::SetUniform4f(const std::string& name, float x, float y, float z, float w)
+void ComputeShader::SetUniform2i(UniformHandle handle, int x, int y)
 {
-    glUniform4f(GetUniformLocation(name), x, y, z, w);
+    glUniform2i(GetUniformLocation(handle), x, y);
 }
 
-int ComputeShader::GetUniformLocation(const std::string& name)
+void ComputeShader::SetUniform2f(UniformHandle handle, float x, float y)
 {
-    if(m_UniformsCache.find(name) != m_UniformsCache.end()){
-        return m_UniformsCache[name];
-    }
+    glUniform2f(GetUniformLocation(handle), x, y);
+}
 
-    int location = glGetUniformLocation(m_ID, name.c_str());
+void ComputeShader::SetUniform4f(UniformHandle handle, float x, float y, float z, float w)
+{
+    glUniform4f(GetUniformLocation(handle), x, y, z, w);
+}
+
+void ComputeShader::SetUniform4fv(UniformHandle handle, const glm::vec4& vector, unsigned int count)
+{
+    glUniform4fv(GetUniformLocation(handle), count, glm::value_ptr(vector));
+}
+
+void ComputeShader::SetUniformMat4fv(UniformHandle handle, const glm::mat4& matrix, unsigned int count)
+{
+    glUniformMatrix4fv(GetUniformLocation(handle), count, GL_FALSE, glm::value_ptr(matrix));
+}
+
+int ComputeShader::GetUniformLocation(UniformHandle handle) const
+{
+    int location = m_Uniforms.GetLocation(handle);
     if(location == -1){
-        LogWarning("Uniform %s not found in shader", name.c_str());
-    }else{
-        m_UniformsCache[name] = location;
+        LogWarning("Uniform %s not found in shader", handle.GetName() ? handle.GetName() : "(unnamed)");
     }
 
     return location;
@@ -1,7 +1,9 @@
 #pragma once
 
+#include <UniformHandle.hpp>
+#include <glm.hpp>
+
 #include <string>
-#include <unordered_map>
 
 class ComputeShader{
 public:
@@ -16,14 +18,18 @@ public:
 
     inline unsigned int GetID() const { return m_ID; }
 
-    void SetUniform1i(const std::string& name, int value);
-    void SetUniform1f(const std::string& name, float value);
-    void SetUniform2i(const std::string& name, int x, int y);
-    void SetUniform4f(const std::string& name, float x, float y, float z, float w);
+    void SetUniform1i(UniformHandle handle, int value);
+    void SetUniform1ui(UniformHandle handle, unsigned int value);
+    void SetUniform1f(UniformHandle handle, float value);
+    void SetUniform2i(UniformHandle handle, int x, int y);
+    void SetUniform2f(UniformHandle handle, float x, float y);
+    void SetUniform4f(UniformHandle handle, float x, float y, float z, float w);
+    void SetUniform4fv(UniformHandle handle, const glm::vec4& vector, unsigned int count = 1);
+    void SetUniformMat4fv(UniformHandle handle, const glm::mat4& matrix, unsigned int count = 1);
 
 private:
-    int GetUniformLocation(const std::string& name);
+    int GetUniformLocation(UniformHandle handle) const;
 
     unsigned int m_ID;
-    std::unordered_map<std::string, int> m_UniformsCache;
+    UniformTable m_Uniforms; // rebuilt every time the program is linked, so the hot reload resolves the locations again
 };
\ No newline at end of file
@@ -0,0 +1,198 @@
+#include <Culling.hpp>
+
+#include <cmath>
+
+#if defined(CULLING_AVX)
+    #include <immintrin.h>
+#elif defined(CULLING_SSE)
+    #include <emmintrin.h>
+#endif
+
+void CullingBatch::Clear()
+{
+    centerX.clear(); centerY.clear(); centerZ.clear();
+    extentX.clear(); extentY.clear(); extentZ.clear();
+    axisXx.clear(); axisXy.clear(); axisXz.clear();
+    axisYx.clear(); axisYy.clear(); axisYz.clear();
+    axisZx.clear(); axisZy.clear(); axisZz.clear();
+}
+
+void CullingBatch::Reserve(size_t count)
+{
+    centerX.reserve(count); centerY.reserve(count); centerZ.reserve(count);
+    extentX.reserve(count); extentY.reserve(count); extentZ.reserve(count);
+    axisXx.reserve(count); axisXy.reserve(count); axisXz.reserve(count);
+    axisYx.reserve(count); axisYy.reserve(count); axisYz.reserve(count);
+    axisZx.reserve(count); axisZy.reserve(count); axisZz.reserve(count);
+}
+
+uint32_t CullingBatch::Add(const OBB& obb)
+{
+    uint32_t index = centerX.size();
+
+    centerX.push_back(obb.center.x); centerY.push_back(obb.center.y); centerZ.push_back(obb.center.z);
+    extentX.push_back(obb.extents.x); extentY.push_back(obb.extents.y); extentZ.push_back(obb.extents.z);
+    axisXx.push_back(obb.rotation[0].x); axisXy.push_back(obb.rotation[0].y); axisXz.push_back(obb.rotation[0].z);
+    axisYx.push_back(obb.rotation[1].x); axisYy.push_back(obb.rotation[1].y); axisYz.push_back(obb.rotation[1].z);
+    axisZx.push_back(obb.rotation[2].x); axisZy.push_back(obb.rotation[2].y); axisZz.push_back(obb.rotation[2].z);
+
+    return index;
+}
+
+// same math as OBBInFrustum, kept in the same order so every path gives identical results
+static inline bool BoxInFrustum(const Frustum& frustum, const CullingBatch& batch, size_t i)
+{
+    for(const Plane& plane : frustum.Planes){
+        const glm::vec3& n = plane.normal;
+
+        float projectedRadius = batch.extentX[i] * std::abs(batch.axisXx[i] * n.x + batch.axisXy[i] * n.y + batch.axisXz[i] * n.z) +
+                                batch.extentY[i] * std::abs(batch.axisYx[i] * n.x + batch.axisYy[i] * n.y + batch.axisYz[i] * n.z) +
+                                batch.extentZ[i] * std::abs(batch.axisZx[i] * n.x + batch.axisZy[i] * n.y + batch.axisZz[i] * n.z);
+
+        float distance = (n.x * batch.centerX[i] + n.y * batch.centerY[i] + n.z * batch.centerZ[i]) - plane.distance;
+
+        if(distance < -projectedRadius){
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static void CullRangeScalar(const Frustum& frustum, const CullingBatch& batch, size_t start, std::vector<uint32_t>& visible)
+{
+    for(size_t i = start; i < batch.Size(); i++){
+        if(BoxInFrustum(frustum, batch, i)){
+            visible.push_back(i);
+        }
+    }
+}
+
+void CullBatchScalar(Frustum& frustum, const CullingBatch& batch, std::vector<uint32_t>& visible)
+{
+    visible.clear();
+    CullRangeScalar(frustum, batch, 0, visible);
+}
+
+#if defined(CULLING_AVX)
+
+void CullBatchAVX(Frustum& frustum, const CullingBatch& batch, std::vector<uint32_t>& visible)
+{
+    visible.clear();
+
+    const size_t count = batch.Size();
+    const size_t simdCount = count & ~size_t(7);
+    const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7FFFFFFF));
+
+    for(size_t i = 0; i < simdCount; i += 8){
+        __m256 cx = _mm256_loadu_ps(&batch.centerX[i]), cy = _mm256_loadu_ps(&batch.centerY[i]), cz = _mm256_loadu_ps(&batch.centerZ[i]);
+        __m256 ex = _mm256_loadu_ps(&batch.extentX[i]), ey = _mm256_loadu_ps(&batch.extentY[i]), ez = _mm256_loadu_ps(&batch.extentZ[i]);
+        __m256 xx = _mm256_loadu_ps(&batch.axisXx[i]), xy = _mm256_loadu_ps(&batch.axisXy[i]), xz = _mm256_loadu_ps(&batch.axisXz[i]);
+        __m256 yx = _mm256_loadu_ps(&batch.axisYx[i]), yy = _mm256_loadu_ps(&batch.axisYy[i]), yz = _mm256_loadu_ps(&batch.axisYz[i]);
+        __m256 zx = _mm256_loadu_ps(&batch.axisZx[i]), zy = _mm256_loadu_ps(&batch.axisZy[i]), zz = _mm256_loadu_ps(&batch.axisZz[i]);
+
+        __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+
+        for(const Plane& plane : frustum.Planes){
+            __m256 nx = _mm256_set1_ps(plane.normal.x);
+            __m256 ny = _mm256_set1_ps(plane.normal.y);
+            __m256 nz = _mm256_set1_ps(plane.normal.z);
+
+            __m256 dx = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(xx, nx), _mm256_mul_ps(xy, ny)), _mm256_mul_ps(xz, nz));
+            __m256 dy = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(yx, nx), _mm256_mul_ps(yy, ny)), _mm256_mul_ps(yz, nz));
+            __m256 dz = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(zx, nx), _mm256_mul_ps(zy, ny)), _mm256_mul_ps(zz, nz));
+
+            __m256 radius = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ex, _mm256_and_ps(dx, absMask)),
+                                                        _mm256_mul_ps(ey, _mm256_and_ps(dy, absMask))),
+                                                        _mm256_mul_ps(ez, _mm256_and_ps(dz, absMask)));
+
+            __m256 distance = _mm256_sub_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(nx, cx), _mm256_mul_ps(ny, cy)), _mm256_mul_ps(nz, cz)),
+                                            _mm256_set1_ps(plane.distance));
+
+            // distance >= -radius
+            inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, _mm256_sub_ps(_mm256_setzero_ps(), radius), _CMP_GE_OQ));
+
+            if(_mm256_movemask_ps(inside) == 0){ // every box of the group is already out
+                break;
+            }
+        }
+
+        int mask = _mm256_movemask_ps(inside);
+        for(int bit = 0; bit < 8; bit++){
+            if(mask & (1 << bit)){
+                visible.push_back(i + bit);
+            }
+        }
+    }
+
+    CullRangeScalar(frustum, batch, simdCount, visible);
+}
+
+#endif
+
+#if defined(CULLING_SSE)
+
+void CullBatchSSE(Frustum& frustum, const CullingBatch& batch, std::vector<uint32_t>& visible)
+{
+    visible.clear();
+
+    const size_t count = batch.Size();
+    const size_t simdCount = count & ~size_t(3);
+    const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+
+    for(size_t i = 0; i < simdCount; i += 4){
+        __m128 cx = _mm_loadu_ps(&batch.centerX[i]), cy = _mm_loadu_ps(&batch.centerY[i]), cz = _mm_loadu_ps(&batch.centerZ[i]);
+        __m128 ex = _mm_loadu_ps(&batch.extentX[i]), ey = _mm_loadu_ps(&batch.extentY[i]), ez = _mm_loadu_ps(&batch.extentZ[i]);
+        __m128 xx = _mm_loadu_ps(&batch.axisXx[i]), xy = _mm_loadu_ps(&batch.axisXy[i]), xz = _mm_loadu_ps(&batch.axisXz[i]);
+        __m128 yx = _mm_loadu_ps(&batch.axisYx[i]), yy = _mm_loadu_ps(&batch.axisYy[i]), yz = _mm_loadu_ps(&batch.axisYz[i]);
+        __m128 zx = _mm_loadu_ps(&batch.axisZx[i]), zy = _mm_loadu_ps(&batch.axisZy[i]), zz = _mm_loadu_ps(&batch.axisZz[i]);
+
+        __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+
+        for(const Plane& plane : frustum.Planes){
+            __m128 nx = _mm_set1_ps(plane.normal.x);
+            __m128 ny = _mm_set1_ps(plane.normal.y);
+            __m128 nz = _mm_set1_ps(plane.normal.z);
+
+            __m128 dx = _mm_add_ps(_mm_add_ps(_mm_mul_ps(xx, nx), _mm_mul_ps(xy, ny)), _mm_mul_ps(xz, nz));
+            __m128 dy = _mm_add_ps(_mm_add_ps(_mm_mul_ps(yx, nx), _mm_mul_ps(yy, ny)), _mm_mul_ps(yz, nz));
+            __m128 dz = _mm_add_ps(_mm_add_ps(_mm_mul_ps(zx, nx), _mm_mul_ps(zy, ny)), _mm_mul_ps(zz, nz));
+
+            __m128 radius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ex, _mm_and_ps(dx, absMask)),
+                                                  _mm_mul_ps(ey, _mm_and_ps(dy, absMask))),
+                                                  _mm_mul_ps(ez, _mm_and_ps(dz, absMask)));
+
+            __m128 distance = _mm_sub_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, cx), _mm_mul_ps(ny, cy)), _mm_mul_ps(nz, cz)),
+                                         _mm_set1_ps(plane.distance));
+
+            // distance >= -radius
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, _mm_sub_ps(_mm_setzero_ps(), radius)));
+
+            if(_mm_movemask_ps(inside) == 0){ // every box of the group is already out
+                break;
+            }
+        }
+
+        int mask = _mm_movemask_ps(inside);
+        for(int bit = 0; bit < 4; bit++){
+            if(mask & (1 << bit)){
+                visible.push_back(i + bit);
+            }
+        }
+    }
+
+    CullRangeScalar(frustum, batch, simdCount, visible);
+}
+
+#endif
+
+void CullBatch(Frustum& frustum, const CullingBatch& batch, std::vector<uint32_t>& visible)
+{
+#if defined(CULLING_AVX)
+    CullBatchAVX(frustum, batch, visible);
+#elif defined(CULLING_SSE)
+    CullBatchSSE(frustum, batch, visible);
+#else
+    CullBatchScalar(frustum, batch, visible);
+#endif
+}
\ No newline at end of file
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <Frustum.hpp>
+#include <BoundingBox.hpp>
+
+#include <vector>
+#include <cstdint>
+
+/**
+ * \brief World-space OBBs stored as a structure of arrays, so the culling kernel can test several boxes per iteration
+ */
+struct CullingBatch{
+    std::vector<float> centerX, centerY, centerZ;
+    std::vector<float> extentX, extentY, extentZ;
+    std::vector<float> axisXx, axisXy, axisXz; // rotation[0]
+    std::vector<float> axisYx, axisYy, axisYz; // rotation[1]
+    std::vector<float> axisZx, axisZy, axisZz; // rotation[2]
+
+    void Clear();
+    void Reserve(size_t count);
+
+    /**
+     * \returns the index of the added box
+     */
+    uint32_t Add(const OBB& obb);
+
+    inline size_t Size() const { return centerX.size(); }
+};
+
+/**
+ * \brief Test every box of the batch against the frustum planes.
+ * Uses AVX (8 boxes per iteration) or SSE (4 boxes per iteration) when available, the scalar path otherwise
+ * \param visible filled with the indices of the boxes that are at least partially inside the frustum, in increasing order
+ */
+extern void CullBatch(Frustum& frustum, const CullingBatch& batch, std::vector<uint32_t>& visible);
+
+/**
+ * \brief Scalar version of CullBatch. Gives the same results as calling OBBInFrustum on every box
+ */
+extern void CullBatchScalar(Frustum& frustum, const CullingBatch& batch, std::vector<uint32_t>& visible);
+
+#if defined(__AVX__)
+    #define CULLING_AVX
+#endif
+#if defined(__AVX__) || defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define CULLING_SSE
+#endif
+
+#if defined(CULLING_AVX)
+/**
+ * \brief AVX version of CullBatch, 8 boxes per iteration
+ */
+extern void CullBatchAVX(Frustum& frustum, const CullingBatch& batch, std::vector<uint32_t>& visible);
+#endif
+
+#if defined(CULLING_SSE)
+/**
+ * \brief SSE version of CullBatch, 4 boxes per iteration
+ */
+extern void CullBatchSSE(Frustum& frustum, const CullingBatch& batch, std::vector<uint32_t>& visible);
+#endif
\ No newline at end of file
@@ -0,0 +1,219 @@
+#include <DebugDraw.hpp>
+#include <StreamBuffer.hpp>
+#include <OpenGL.hpp>
+#include <Shader.hpp>
+
+#include <glad/glad.h>
+
+#include <vector>
+#include <cstring>
+#include <cstddef>
+
+struct DebugVertex{
+    glm::vec3 position;
+    uint32_t color; // RGBA8
+};
+
+/**
+ * \brief A wireframe box, the unit cube corners are moved to center + axes * corner by DebugBox.vert
+ */
+struct DebugBoxInstance{
+    glm::vec3 center;
+    uint32_t color;
+    glm::vec3 axes[3]; // scaled by the half extents
+};
+
+enum DebugDepthMode{
+    DEBUG_DEPTH_TEST,
+    DEBUG_NO_DEPTH_TEST,
+    NUM_DEBUG_DEPTH_MODES
+};
+
+static constexpr unsigned int CUBE_BINDING = 0;
+static constexpr unsigned int STREAM_BINDING = 1; // the line vertices or the box instances, from the stream buffer
+static constexpr UniformHandle VIEW_PROJECTION("viewProjection");
+
+static std::vector<DebugVertex> g_Lines[NUM_DEBUG_DEPTH_MODES];
+static std::vector<DebugBoxInstance> g_Boxes[NUM_DEBUG_DEPTH_MODES];
+
+static unsigned int g_LineVAO = 0;
+static unsigned int g_BoxVAO = 0;
+static unsigned int g_CubeEdges = 0; // the 12 edges of the [-1, 1] cube as a line list
+static Shader g_LineShader;
+static Shader g_BoxShader;
+
+static uint32_t PackColor(glm::vec4 color)
+{
+    glm::vec4 c = glm::min(glm::max(color, glm::vec4(0.0f)), glm::vec4(1.0f)) * 255.0f + 0.5f;
+    return (uint32_t)c.x | ((uint32_t)c.y << 8) | ((uint32_t)c.z << 16) | ((uint32_t)c.w << 24);
+}
+
+void InitDebugDraw()
+{
+    const glm::vec3 corners[8] = {
+        {-1.0f, -1.0f, -1.0f}, {1.0f, -1.0f, -1.0f}, {1.0f, 1.0f, -1.0f}, {-1.0f, 1.0f, -1.0f},
+        {-1.0f, -1.0f, 1.0f}, {1.0f, -1.0f, 1.0f}, {1.0f, 1.0f, 1.0f}, {-1.0f, 1.0f, 1.0f}
+    };
+
+    const int edges[24] = {
+        0, 1, 1, 2, 2, 3, 3, 0,
+        4, 5, 5, 6, 6, 7, 7, 4,
+        0, 4, 1, 5, 2, 6, 3, 7
+    };
+
+    glm::vec3 edgeVertices[24];
+    for(int i = 0; i < 24; i++){
+        edgeVertices[i] = corners[edges[i]];
+    }
+
+    glGenBuffers(1, &g_CubeEdges);
+    BindBuffer(GL_COPY_WRITE_BUFFER, g_CubeEdges);
+    glBufferStorage(GL_COPY_WRITE_BUFFER, sizeof(edgeVertices), edgeVertices, 0);
+    BindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    // lines: position and color
+    glGenVertexArrays(1, &g_LineVAO);
+    BindVertexArray(g_LineVAO);
+    glEnableVertexAttribArray(0);
+    glVertexAttribFormat(0, 3, GL_FLOAT, GL_FALSE, offsetof(DebugVertex, position));
+    glVertexAttribBinding(0, STREAM_BINDING);
+    glEnableVertexAttribArray(1);
+    glVertexAttribFormat(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, offsetof(DebugVertex, color));
+    glVertexAttribBinding(1, STREAM_BINDING);
+
+    // boxes: the cube edges, and one DebugBoxInstance per instance
+    glGenVertexArrays(1, &g_BoxVAO);
+    BindVertexArray(g_BoxVAO);
+    glEnableVertexAttribArray(0);
+    glVertexAttribFormat(0, 3, GL_FLOAT, GL_FALSE, 0);
+    glVertexAttribBinding(0, CUBE_BINDING);
+    glBindVertexBuffer(CUBE_BINDING, g_CubeEdges, 0, sizeof(glm::vec3));
+
+    glEnableVertexAttribArray(1);
+    glVertexAttribFormat(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, offsetof(DebugBoxInstance, color));
+    glVertexAttribBinding(1, STREAM_BINDING);
+    glEnableVertexAttribArray(2);
+    glVertexAttribFormat(2, 3, GL_FLOAT, GL_FALSE, offsetof(DebugBoxInstance, center));
+    glVertexAttribBinding(2, STREAM_BINDING);
+
+    for(unsigned int i = 0; i < 3; i++){
+        glEnableVertexAttribArray(3 + i);
+        glVertexAttribFormat(3 + i, 3, GL_FLOAT, GL_FALSE, offsetof(DebugBoxInstance, axes) + i * sizeof(glm::vec3));
+        glVertexAttribBinding(3 + i, STREAM_BINDING);
+    }
+
+    glVertexBindingDivisor(STREAM_BINDING, 1);
+
+    BindVertexArray(0);
+
+    g_LineShader.Load("Resources/Shaders/DebugLine.vert", "Resources/Shaders/Debug.frag");
+    g_BoxShader.Load("Resources/Shaders/DebugBox.vert", "Resources/Shaders/Debug.frag");
+}
+
+void DeinitDebugDraw()
+{
+    DeleteVertexArrays(1, &g_LineVAO);
+    DeleteVertexArrays(1, &g_BoxVAO);
+    DeleteBuffers(1, &g_CubeEdges);
+
+    g_LineShader.Unload();
+    g_BoxShader.Unload();
+
+    for(int i = 0; i < NUM_DEBUG_DEPTH_MODES; i++){
+        g_Lines[i].clear();
+        g_Boxes[i].clear();
+    }
+}
+
+void DebugLine(glm::vec3 start, glm::vec3 end, glm::vec4 color, bool depth_test)
+{
+    DebugLine(start, end, color, color, depth_test);
+}
+
+void DebugLine(glm::vec3 start, glm::vec3 end, glm::vec4 start_color, glm::vec4 end_color, bool depth_test)
+{
+    std::vector<DebugVertex>& lines = g_Lines[depth_test ? DEBUG_DEPTH_TEST : DEBUG_NO_DEPTH_TEST];
+    lines.push_back({start, PackColor(start_color)});
+    lines.push_back({end, PackColor(end_color)});
+}
+
+void DebugBox(glm::vec3 min, glm::vec3 max, glm::vec4 color, bool depth_test)
+{
+    glm::vec3 half = (max - min) * 0.5f;
+
+    g_Boxes[depth_test ? DEBUG_DEPTH_TEST : DEBUG_NO_DEPTH_TEST].push_back({
+        (min + max) * 0.5f, PackColor(color),
+        {glm::vec3(half.x, 0.0f, 0.0f), glm::vec3(0.0f, half.y, 0.0f), glm::vec3(0.0f, 0.0f, half.z)}
+    });
+}
+
+void DebugBox(const AABB& box, glm::vec4 color, bool depth_test)
+{
+    DebugBox(box.min, box.max, color, depth_test);
+}
+
+void DebugBox(const OBB& box, glm::vec4 color, bool depth_test)
+{
+    g_Boxes[depth_test ? DEBUG_DEPTH_TEST : DEBUG_NO_DEPTH_TEST].push_back({
+        box.center, PackColor(color),
+        {box.rotation[0] * box.extents.x, box.rotation[1] * box.extents.y, box.rotation[2] * box.extents.z}
+    });
+}
+
+void DebugFrustum(const glm::vec3 corners[8], glm::vec4 color, bool depth_test)
+{
+    for(int i = 0; i < 4; i++){
+        DebugLine(corners[i], corners[(i + 1) % 4], color, depth_test);         // far face
+        DebugLine(corners[4 + i], corners[4 + (i + 1) % 4], color, depth_test); // near face
+        DebugLine(corners[i], corners[4 + i], color, depth_test);               // edges between the faces
+    }
+}
+
+void FlushDebugDraw(const glm::mat4& view_projection)
+{
+    for(int mode = 0; mode < NUM_DEBUG_DEPTH_MODES; mode++){
+        std::vector<DebugVertex>& lines = g_Lines[mode];
+        std::vector<DebugBoxInstance>& boxes = g_Boxes[mode];
+
+        if(lines.empty() && boxes.empty()){
+            continue;
+        }
+
+        if(mode == DEBUG_DEPTH_TEST){
+            EnableDepthTest();
+        }else{
+            DisableDepthTest();
+        }
+
+        if(!lines.empty()){
+            StreamAllocation alloc = StreamAllocate(lines.size() * sizeof(DebugVertex));
+            memcpy(alloc.data, lines.data(), lines.size() * sizeof(DebugVertex));
+
+            g_LineShader.Bind();
+            g_LineShader.SetUniformMat4fv(VIEW_PROJECTION, view_projection);
+
+            BindVertexArray(g_LineVAO);
+            glBindVertexBuffer(STREAM_BINDING, alloc.buffer, alloc.offset, sizeof(DebugVertex));
+            glDrawArrays(GL_LINES, 0, lines.size());
+
+            lines.clear();
+        }
+
+        if(!boxes.empty()){
+            StreamAllocation alloc = StreamAllocate(boxes.size() * sizeof(DebugBoxInstance));
+            memcpy(alloc.data, boxes.data(), boxes.size() * sizeof(DebugBoxInstance));
+
+            g_BoxShader.Bind();
+            g_BoxShader.SetUniformMat4fv(VIEW_PROJECTION, view_projection);
+
+            BindVertexArray(g_BoxVAO);
+            glBindVertexBuffer(STREAM_BINDING, alloc.buffer, alloc.offset, sizeof(DebugBoxInstance));
+            glDrawArraysInstanced(GL_LINES, 0, 24, boxes.size());
+
+            boxes.clear();
+        }
+    }
+
+    BindVertexArray(0);
+    EnableDepthTest();
+}
\ No newline at end of file
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <BoundingBox.hpp>
+
+#include <glm.hpp>
+
+/**
+ * \brief Immediate-mode debug shapes. They are accumulated during the frame and drawn by FlushDebugDraw,
+ * with one line draw and one instanced box draw for each depth mode
+ */
+extern void InitDebugDraw();
+extern void DeinitDebugDraw();
+
+/**
+ * \param depth_test false to draw the shape on top of the scene
+ */
+extern void DebugLine(glm::vec3 start, glm::vec3 end, glm::vec4 color, bool depth_test = true);
+extern void DebugLine(glm::vec3 start, glm::vec3 end, glm::vec4 start_color, glm::vec4 end_color, bool depth_test = true);
+extern void DebugBox(glm::vec3 min, glm::vec3 max, glm::vec4 color, bool depth_test = true);
+extern void DebugBox(const AABB& box, glm::vec4 color, bool depth_test = true);
+extern void DebugBox(const OBB& box, glm::vec4 color, bool depth_test = true);
+/**
+ * \param corners far face then near face, in the order of g_FrustumCorners
+ */
+extern void DebugFrustum(const glm::vec3 corners[8], glm::vec4 color, bool depth_test = true);
+
+/**
+ * \brief Draw the shapes queued since the last flush in the bound framebuffer, then clear the queue
+ */
+extern void FlushDebugDraw(const glm::mat4& view_projection);
\ No newline at end of file
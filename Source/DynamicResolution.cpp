@@ -0,0 +1,150 @@
+#include <DynamicResolution.hpp>
+#include <OpenGL.hpp>
+#include <Globals.hpp>
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <cmath>
+
+inline constexpr float FRAME_TIME_SMOOTHING = 0.2f; // weight of a new sample in the smoothed GPU time
+inline constexpr float TARGET_HEADROOM = 0.9f; // aim under the target, so the scale doesn't oscillate around it
+inline constexpr float MAX_SCALE_STEP = 0.05f; // the scale moves at most this much for each sample
+inline constexpr float MIN_SCALE_CHANGE = 0.01f; // smaller corrections are ignored
+
+static bool g_UseDynamicResolution = false;
+static float g_TargetFrameTime = DEFAULT_TARGET_FRAME_TIME;
+static float g_RenderScale = MAX_RENDER_SCALE;
+static float g_GPUFrameTime = 0.0f;
+
+// a start and an end timestamp for each frame in flight. GL_TIMESTAMP queries don't conflict with the GL_TIME_ELAPSED ones of the timers
+static unsigned int g_StartQueries[GPU_FRAME_QUERIES];
+static unsigned int g_EndQueries[GPU_FRAME_QUERIES];
+static uint32_t g_NextQuery = 0;
+static uint32_t g_PendingQueries = 0;
+static bool g_FrameTimed = false;
+
+void InitDynamicResolution()
+{
+    glGenQueries(GPU_FRAME_QUERIES, g_StartQueries);
+    glGenQueries(GPU_FRAME_QUERIES, g_EndQueries);
+
+    g_NextQuery = 0;
+    g_PendingQueries = 0;
+    g_FrameTimed = false;
+    g_GPUFrameTime = 0.0f;
+}
+
+void DeinitDynamicResolution()
+{
+    glDeleteQueries(GPU_FRAME_QUERIES, g_StartQueries);
+    glDeleteQueries(GPU_FRAME_QUERIES, g_EndQueries);
+}
+
+static void UpdateRenderScale(float gpu_time)
+{
+    if(!g_UseDynamicResolution || gpu_time <= 0.0f){
+        return;
+    }
+
+    // the cost of the scaled passes grows with the number of pixels, the square of the scale
+    float desired = g_RenderScale * std::sqrt(g_TargetFrameTime * TARGET_HEADROOM / gpu_time);
+    float change = std::clamp(desired - g_RenderScale, -MAX_SCALE_STEP, MAX_SCALE_STEP);
+
+    if(std::abs(change) < MIN_SCALE_CHANGE){
+        return;
+    }
+
+    g_RenderScale = std::clamp(g_RenderScale + change, MIN_RENDER_SCALE, MAX_RENDER_SCALE);
+}
+
+void BeginDynamicResolutionFrame()
+{
+    // the oldest frames finish first, stop at the first one still running so the CPU never waits
+    while(g_PendingQueries > 0){
+        uint32_t query = (g_NextQuery + GPU_FRAME_QUERIES - g_PendingQueries) % GPU_FRAME_QUERIES;
+
+        GLint available = 0;
+        glGetQueryObjectiv(g_EndQueries[query], GL_QUERY_RESULT_AVAILABLE, &available);
+        if(!available){
+            break;
+        }
+
+        GLuint64 start, end;
+        glGetQueryObjectui64v(g_StartQueries[query], GL_QUERY_RESULT, &start);
+        glGetQueryObjectui64v(g_EndQueries[query], GL_QUERY_RESULT, &end);
+        g_PendingQueries--;
+
+        float gpu_time = (float)((end - start) / 1000000.0);
+        g_GPUFrameTime = (g_GPUFrameTime == 0.0f) ? gpu_time : g_GPUFrameTime + (gpu_time - g_GPUFrameTime) * FRAME_TIME_SMOOTHING;
+
+        UpdateRenderScale(g_GPUFrameTime);
+    }
+
+    // every query is in flight, this frame goes untimed
+    g_FrameTimed = g_PendingQueries < GPU_FRAME_QUERIES;
+    if(g_FrameTimed){
+        glQueryCounter(g_StartQueries[g_NextQuery], GL_TIMESTAMP);
+    }
+}
+
+void EndDynamicResolutionFrame()
+{
+    if(!g_FrameTimed){
+        return;
+    }
+
+    glQueryCounter(g_EndQueries[g_NextQuery], GL_TIMESTAMP);
+    g_NextQuery = (g_NextQuery + 1) % GPU_FRAME_QUERIES;
+    g_PendingQueries++;
+    g_FrameTimed = false;
+}
+
+void UseDynamicResolution(bool use)
+{
+    g_UseDynamicResolution = use;
+
+    if(!use){
+        g_RenderScale = MAX_RENDER_SCALE;
+    }
+}
+
+bool GetUseDynamicResolution()
+{
+    return g_UseDynamicResolution;
+}
+
+void SetTargetFrameTime(float milliseconds)
+{
+    g_TargetFrameTime = std::max(milliseconds, 1.0f);
+}
+
+float GetTargetFrameTime()
+{
+    return g_TargetFrameTime;
+}
+
+float GetRenderScale()
+{
+    return g_RenderScale;
+}
+
+int GetRenderWidth()
+{
+    return std::clamp((int)std::round(g_ScreenWidth * g_RenderScale), 1, std::max(g_ScreenWidth, 1));
+}
+
+int GetRenderHeight()
+{
+    return std::clamp((int)std::round(g_ScreenHeight * g_RenderScale), 1, std::max(g_ScreenHeight, 1));
+}
+
+float GetGPUFrameTime()
+{
+    return g_GPUFrameTime;
+}
+
+void SetRenderViewport()
+{
+    SetViewport(0, 0, GetRenderWidth(), GetRenderHeight());
+}
\ No newline at end of file
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+
+inline constexpr float MIN_RENDER_SCALE = 0.5f;
+inline constexpr float MAX_RENDER_SCALE = 1.0f;
+inline constexpr float DEFAULT_TARGET_FRAME_TIME = 1000.0f / 60.0f; // milliseconds
+inline constexpr uint32_t GPU_FRAME_QUERIES = 4; // frames the timestamps can be read behind
+
+/**
+ * \brief The scene is rendered in the bottom left corner of the G-buffer, deferred and bloom targets, scaled by a factor picked from the GPU frame time.
+ * The targets keep the size of the window so a scale change never reallocates them, the post-processing pass upscales the corner to the window
+ */
+extern void InitDynamicResolution();
+extern void DeinitDynamicResolution();
+
+/**
+ * \brief Read the GPU times of the finished frames, update the scale and start timing this frame. Call before the first draw of the frame
+ */
+extern void BeginDynamicResolutionFrame();
+/**
+ * \brief Stop timing this frame. Call after the last draw of the frame
+ */
+extern void EndDynamicResolutionFrame();
+
+/**
+ * \brief When disabled the scene is rendered at the size of the window. The GPU time is measured either way
+ */
+extern void UseDynamicResolution(bool use);
+extern bool GetUseDynamicResolution();
+
+extern void SetTargetFrameTime(float milliseconds);
+extern float GetTargetFrameTime();
+
+extern float GetRenderScale();
+extern int GetRenderWidth();
+extern int GetRenderHeight();
+/**
+ * \brief Smoothed GPU time of the last frames, in milliseconds
+ */
+extern float GetGPUFrameTime();
+
+/**
+ * \brief Set the viewport to the scaled area the scene is rendered in
+ */
+extern void SetRenderViewport();
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include <Framebuffer.hpp>
+#include <OpenGL.hpp>
 #include <Log.hpp>
 #include <Window.hpp>
 
@@ -13,22 +14,17 @@ Framebuffer::Framebuffer(int width, int height)
 void Framebuffer::Init(int width, int height)
 {
     glGenFramebuffers(1, &m_FBO);
-    glBindFramebuffer(GL_FRAMEBUFFER, m_FBO);
+    BindFramebuffer(GL_FRAMEBUFFER, m_FBO);
 
     glGenTextures(1, &m_ColorBufferTexture);
-    glBindTexture(GL_TEXTURE_2D, m_ColorBufferTexture);
+    BindTexture(m_ColorBufferTexture, 0);
 
     glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, width, height, 0, GL_RGBA, GL_FLOAT, nullptr);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
     glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_ColorBufferTexture, 0);
-
-    glGenRenderbuffers(1, &m_RBO);
-    glBindRenderbuffer(GL_RENDERBUFFER, m_RBO);
-
-    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
-    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, m_RBO);
+    m_DepthTexture = 0;
 
     CheckStatus();
 
@@ -37,9 +33,9 @@ void Framebuffer::Init(int width, int height)
 
 void Framebuffer::Deinit()
 {
-    glDeleteFramebuffers(1, &m_FBO);
-    glDeleteTextures(1, &m_ColorBufferTexture);
-    glDeleteRenderbuffers(1, &m_RBO);
+    DeleteFramebuffers(1, &m_FBO);
+    DeleteTextures(1, &m_ColorBufferTexture);
+    m_DepthTexture = 0;
 
     RemoveWindowResizeCallback(m_ResizeCallbackID);
     m_ResizeCallbackID = std::numeric_limits<uint32_t>::max();
@@ -54,12 +50,25 @@ void Framebuffer::CheckStatus()
 
 void Framebuffer::Bind() const
 {
-    glBindFramebuffer(GL_FRAMEBUFFER, m_FBO);
+    BindFramebuffer(GL_FRAMEBUFFER, m_FBO);
 }
 
 void Framebuffer::Unbind() const
 {
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    BindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void Framebuffer::SetDepthTexture(unsigned int depth_texture)
+{
+    if(depth_texture == m_DepthTexture){
+        return;
+    }
+
+    BindFramebuffer(GL_FRAMEBUFFER, m_FBO);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, depth_texture, 0);
+    m_DepthTexture = depth_texture;
+
+    CheckStatus();
 }
 
 void Framebuffer::Resize(int width, int height)
@@ -17,16 +17,22 @@ public:
 
     void Resize(int width, int height);
 
+    /**
+     * \brief Use a depth stencil texture owned by someone else, e.g. the depth of the G-buffer. It is attached only if it's not the attached one,
+     * and must be set again after a resize
+     */
+    void SetDepthTexture(unsigned int depth_texture);
+
     inline unsigned int GetColorBufferTexture() const { return m_ColorBufferTexture; }
     inline unsigned int GetFBO() const { return m_FBO; }
-    inline unsigned int GetRBO() const { return m_RBO; }
+    inline unsigned int GetDepthTexture() const { return m_DepthTexture; }
 
 private:
     void CheckStatus();
 
     unsigned int m_FBO;
     unsigned int m_ColorBufferTexture;
-    unsigned int m_RBO;
+    unsigned int m_DepthTexture = 0; // not owned
 
     uint32_t m_ResizeCallbackID = std::numeric_limits<uint32_t>::max();
 };
\ No newline at end of file
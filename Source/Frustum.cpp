@@ -1,9 +1,10 @@
 #include <Frustum.hpp>
-#include <Renderer.hpp>
+#include <DebugDraw.hpp>
 #include <Globals.hpp>
 #include <Log.hpp>
 
 #include <cmath>
+#include <algorithm>
 #include <glm.hpp>
 #include <gtc/matrix_transform.hpp>
 #include <gtc/type_ptr.hpp>
@@ -15,22 +16,22 @@ glm::vec3 g_FrustumCorners[8];
 void DrawFrustum(Frustum& frustum)
 {
     // Draw the far face
-    DrawLine3D(g_FrustumCorners[0], g_FrustumCorners[1], glm::vec4(0.0f, 1.0f, 0.0f, 1.0f));
-    DrawLine3D(g_FrustumCorners[1], g_FrustumCorners[2], glm::vec4(0.0f, 1.0f, 0.0f, 1.0f));
-    DrawLine3D(g_FrustumCorners[2], g_FrustumCorners[3], glm::vec4(0.0f, 1.0f, 0.0f, 1.0f));
-    DrawLine3D(g_FrustumCorners[3], g_FrustumCorners[0], glm::vec4(0.0f, 1.0f, 0.0f, 1.0f));
+    DebugLine(g_FrustumCorners[0], g_FrustumCorners[1], glm::vec4(0.0f, 1.0f, 0.0f, 1.0f));
+    DebugLine(g_FrustumCorners[1], g_FrustumCorners[2], glm::vec4(0.0f, 1.0f, 0.0f, 1.0f));
+    DebugLine(g_FrustumCorners[2], g_FrustumCorners[3], glm::vec4(0.0f, 1.0f, 0.0f, 1.0f));
+    DebugLine(g_FrustumCorners[3], g_FrustumCorners[0], glm::vec4(0.0f, 1.0f, 0.0f, 1.0f));
 
     // Draw the near face
-    DrawLine3D(g_FrustumCorners[4], g_FrustumCorners[5], glm::vec4(0.0f, 1.0f, 0.0f, 1.0f));
-    DrawLine3D(g_FrustumCorners[5], g_FrustumCorners[6], glm::vec4(0.0f, 1.0f, 0.0f, 1.0f));
-    DrawLine3D(g_FrustumCorners[6], g_FrustumCorners[7], glm::vec4(0.0f, 1.0f, 0.0f, 1.0f));
-    DrawLine3D(g_FrustumCorners[7], g_FrustumCorners[4], glm::vec4(0.0f, 1.0f, 0.0f, 1.0f));
+    DebugLine(g_FrustumCorners[4], g_FrustumCorners[5], glm::vec4(0.0f, 1.0f, 0.0f, 1.0f));
+    DebugLine(g_FrustumCorners[5], g_FrustumCorners[6], glm::vec4(0.0f, 1.0f, 0.0f, 1.0f));
+    DebugLine(g_FrustumCorners[6], g_FrustumCorners[7], glm::vec4(0.0f, 1.0f, 0.0f, 1.0f));
+    DebugLine(g_FrustumCorners[7], g_FrustumCorners[4], glm::vec4(0.0f, 1.0f, 0.0f, 1.0f));
 
     // Draw the edges connecting far and near faces
-    DrawLine3D(g_FrustumCorners[0], g_FrustumCorners[4], glm::vec4(0.0f, 1.0f, 0.0f, 1.0f));
-    DrawLine3D(g_FrustumCorners[1], g_FrustumCorners[5], glm::vec4(1.0f, 0.5f, 0.0f, 1.0f));
-    DrawLine3D(g_FrustumCorners[2], g_FrustumCorners[6], glm::vec4(1.0f, 0.5f, 0.0f, 1.0f));
-    DrawLine3D(g_FrustumCorners[3], g_FrustumCorners[7], glm::vec4(0.0f, 1.0f, 0.0f, 1.0f));
+    DebugLine(g_FrustumCorners[0], g_FrustumCorners[4], glm::vec4(0.0f, 1.0f, 0.0f, 1.0f));
+    DebugLine(g_FrustumCorners[1], g_FrustumCorners[5], glm::vec4(1.0f, 0.5f, 0.0f, 1.0f));
+    DebugLine(g_FrustumCorners[2], g_FrustumCorners[6], glm::vec4(1.0f, 0.5f, 0.0f, 1.0f));
+    DebugLine(g_FrustumCorners[3], g_FrustumCorners[7], glm::vec4(0.0f, 1.0f, 0.0f, 1.0f));
 }
 
 Plane PlaneFromCorners(glm::vec3 p1, glm::vec3 p2, glm::vec3 p3)
@@ -93,6 +94,30 @@ void ExtractFrustum(Frustum& frustum, const Camera& camera)
     frustum.Planes[LEFT] = PlaneFromCorners(ntl, nbl, fbl); 
 }
 
+void ExtractFrustum(Frustum& frustum, const glm::mat4& view_projection)
+{
+    // rows of the matrix. glm is column major
+    glm::vec4 row0 = glm::vec4(view_projection[0][0], view_projection[1][0], view_projection[2][0], view_projection[3][0]);
+    glm::vec4 row1 = glm::vec4(view_projection[0][1], view_projection[1][1], view_projection[2][1], view_projection[3][1]);
+    glm::vec4 row2 = glm::vec4(view_projection[0][2], view_projection[1][2], view_projection[2][2], view_projection[3][2]);
+    glm::vec4 row3 = glm::vec4(view_projection[0][3], view_projection[1][3], view_projection[2][3], view_projection[3][3]);
+
+    glm::vec4 planes[NUM_PLANES];
+    planes[NEAR] = row3 + row2;
+    planes[FAR] = row3 - row2;
+    planes[BOTTOM] = row3 + row1;
+    planes[TOP] = row3 - row1;
+    planes[RIGHT] = row3 - row0;
+    planes[LEFT] = row3 + row0;
+
+    for(int i = 0; i < NUM_PLANES; i++){
+        float length = glm::length(glm::vec3(planes[i]));
+
+        frustum.Planes[i].normal = glm::vec3(planes[i]) / length;
+        frustum.Planes[i].distance = -planes[i].w / length;
+    }
+}
+
 float SignedDistanceToPlane(const Plane& plane, glm::vec3 position)
 {
     return glm::dot(plane.normal, position) - plane.distance;
@@ -165,6 +190,35 @@ bool AABBInFrustum(Frustum& frustum, glm::vec3 min, glm::vec3 max)
     return true;
 }
 
+FrustumIntersection AABBFrustumIntersection(Frustum& frustum, glm::vec3 min, glm::vec3 max)
+{
+    FrustumIntersection result = FRUSTUM_INSIDE;
+
+    for(const Plane& plane : frustum.Planes){
+        glm::vec3 positiveVertex = min;
+        glm::vec3 negativeVertex = max;
+        if(plane.normal.x >= 0){
+            positiveVertex.x = max.x;
+            negativeVertex.x = min.x;
+        }
+        if(plane.normal.y >= 0){
+            positiveVertex.y = max.y;
+            negativeVertex.y = min.y;
+        }
+        if(plane.normal.z >= 0){
+            positiveVertex.z = max.z;
+            negativeVertex.z = min.z;
+        }
+        if(GetSignedDistanceToPlane(plane, positiveVertex) < 0){
+            return FRUSTUM_OUTSIDE;
+        }
+        if(GetSignedDistanceToPlane(plane, negativeVertex) < 0){
+            result = FRUSTUM_INTERSECT;
+        }
+    }
+    return result;
+}
+
 bool OBBInFrustum(Frustum& frustum, glm::vec3 center, glm::vec3 extents, glm::mat3 rotation)
 {
     glm::vec3 axisX = rotation[0];
@@ -182,4 +236,35 @@ bool OBBInFrustum(Frustum& frustum, glm::vec3 center, glm::vec3 extents, glm::ma
     }
 
     return true;
+}
+
+bool ShadowInFrustum(Frustum& frustum, glm::vec3 min, glm::vec3 max, const ShadowCasterLight& light)
+{
+    if(light.directional){
+        glm::vec3 offset = glm::normalize(light.direction) * light.range;
+        return AABBInFrustum(frustum, glm::min(min, min + offset), glm::max(max, max + offset));
+    }
+
+    // every point of the shadow is pos + t * (q - pos) with q in the box and 1 <= t <= range / distance(pos, q).
+    // scaling the corners by range / distance(pos, box) gives a box that contains all of them
+    float distance = glm::length(glm::max(min, glm::min(light.position, max)) - light.position);
+
+    if(distance <= 0.0f){ // the light is inside the box
+        return true;
+    }
+
+    float scale = std::max(light.range / distance, 1.0f);
+
+    glm::vec3 extruded_min = min;
+    glm::vec3 extruded_max = max;
+
+    for(int i = 0; i < 8; i++){
+        glm::vec3 corner((i & 1) ? max.x : min.x, (i & 2) ? max.y : min.y, (i & 4) ? max.z : min.z);
+        glm::vec3 extruded = light.position + (corner - light.position) * scale;
+
+        extruded_min = glm::min(extruded_min, extruded);
+        extruded_max = glm::max(extruded_max, extruded);
+    }
+
+    return AABBInFrustum(frustum, extruded_min, extruded_max);
 }
\ No newline at end of file
@@ -27,12 +27,40 @@ struct Frustum{
     Plane Planes[NUM_PLANES];
 };
 
+enum FrustumIntersection{
+    FRUSTUM_OUTSIDE = 0,
+    FRUSTUM_INTERSECT = 1,
+    FRUSTUM_INSIDE = 2
+};
+
+/**
+ * \brief The light of a shadow map, used to tell where the shadow of a caster can fall
+ */
+struct ShadowCasterLight{
+    glm::vec3 position; // eye of the shadow projection
+    glm::vec3 direction; // directional lights
+    float range; // how far from the caster the shadow can go (directional) or how far from the light (point and spot)
+    bool directional;
+};
+
 extern Frustum g_Frustum;
 
 extern void DrawFrustum(Frustum& frustum);
 
 extern void ExtractFrustum(Frustum& frustrum, const Camera& camera);
+/**
+ * \brief Extract the planes from a projection * view matrix (Gribb-Hartmann). Works for orthographic projections too
+ */
+extern void ExtractFrustum(Frustum& frustrum, const glm::mat4& view_projection);
 extern bool PointInFrustum(Frustum& frustrum, glm::vec3 position);
 extern bool SphereInFrustum(Frustum& frustrum, glm::vec3 position, float radius);
 extern bool AABBInFrustum(Frustum& frustrum, glm::vec3 min, glm::vec3 max);
-extern bool OBBInFrustum(Frustum& frustrum, glm::vec3 center, glm::vec3 extents, glm::mat3 rotation);
\ No newline at end of file
+/**
+ * \brief Like AABBInFrustum, but also tells if the box is completely inside the frustum
+ */
+extern FrustumIntersection AABBFrustumIntersection(Frustum& frustrum, glm::vec3 min, glm::vec3 max);
+extern bool OBBInFrustum(Frustum& frustrum, glm::vec3 center, glm::vec3 extents, glm::mat3 rotation);
+/**
+ * \brief Extrude the box away from the light and test it against the frustum. False if the shadow of the box can't be seen
+ */
+extern bool ShadowInFrustum(Frustum& frustrum, glm::vec3 min, glm::vec3 max, const ShadowCasterLight& light);
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include <GBuffer.hpp>
+#include <OpenGL.hpp>
 #include <Log.hpp>
 #include <Window.hpp>
 
@@ -12,49 +13,56 @@ GBuffer::GBuffer(int width, int height)
 void GBuffer::Init(int width, int height)
 {
     glGenFramebuffers(1, &m_FBO);
-    glBindFramebuffer(GL_FRAMEBUFFER, m_FBO);
-
-    glGenTextures(1, &m_PositionTexture);
-    glBindTexture(GL_TEXTURE_2D, m_PositionTexture);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, width, height, 0, GL_RGBA, GL_FLOAT, nullptr);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_PositionTexture, 0);
+    BindFramebuffer(GL_FRAMEBUFFER, m_FBO);
 
     glGenTextures(1, &m_NormalTexture);
-    glBindTexture(GL_TEXTURE_2D, m_NormalTexture);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, width, height, 0, GL_RGBA, GL_FLOAT, nullptr);
+    BindTexture(m_NormalTexture, 0);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RG16, width, height, 0, GL_RG, GL_UNSIGNED_SHORT, nullptr);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, m_NormalTexture, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_NormalTexture, 0);
 
     glGenTextures(1, &m_AlbedoTexture);
-    glBindTexture(GL_TEXTURE_2D, m_AlbedoTexture);
+    BindTexture(m_AlbedoTexture, 0);
     glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT2, GL_TEXTURE_2D, m_AlbedoTexture, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, m_AlbedoTexture, 0);
+
+    glGenTextures(1, &m_MaterialTexture);
+    BindTexture(m_MaterialTexture, 0);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RG8, width, height, 0, GL_RG, GL_UNSIGNED_BYTE, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT2, GL_TEXTURE_2D, m_MaterialTexture, 0);
 
     unsigned int attachments[3] = {GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2};
     glDrawBuffers(3, attachments);
 
-    glGenRenderbuffers(1, &m_RBO);
-    glBindRenderbuffer(GL_RENDERBUFFER, m_RBO);
-    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
-    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, m_RBO);
+    glGenTextures(1, &m_DepthTexture);
+    BindTexture(m_DepthTexture, 0);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH24_STENCIL8, width, height, 0, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_DEPTH_STENCIL_TEXTURE_MODE, GL_DEPTH_COMPONENT);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, m_DepthTexture, 0);
 
     CheckStatus();
 
+    LogMessage("G-buffer: %u bytes per pixel, %.1f MB at %dx%d", GBUFFER_BYTES_PER_PIXEL, (double)GBUFFER_BYTES_PER_PIXEL * width * height / (1024.0 * 1024.0), width, height);
+
     m_ResizeCallbackID = AddWindowResizeCallback(std::bind(&GBuffer::Resize, this, std::placeholders::_1, std::placeholders::_2));
 }
 
 void GBuffer::Deinit()
 {
-    glDeleteFramebuffers(1, &m_FBO);
-    glDeleteTextures(1, &m_PositionTexture);
-    glDeleteTextures(1, &m_NormalTexture);
-    glDeleteTextures(1, &m_AlbedoTexture);
-    glDeleteRenderbuffers(1, &m_RBO);
+    DeleteFramebuffers(1, &m_FBO);
+    DeleteTextures(1, &m_NormalTexture);
+    DeleteTextures(1, &m_AlbedoTexture);
+    DeleteTextures(1, &m_MaterialTexture);
+    DeleteTextures(1, &m_DepthTexture);
 
     RemoveWindowResizeCallback(m_ResizeCallbackID);
     m_ResizeCallbackID = std::numeric_limits<uint32_t>::max();
@@ -69,12 +77,12 @@ void GBuffer::CheckStatus()
 
 void GBuffer::Bind() const
 {
-    glBindFramebuffer(GL_FRAMEBUFFER, m_FBO);
+    BindFramebuffer(GL_FRAMEBUFFER, m_FBO);
 }
 
 void GBuffer::Unbind() const
 {
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    BindFramebuffer(GL_FRAMEBUFFER, 0);
 }
 
 void GBuffer::Resize(int width, int height)
@@ -3,6 +3,9 @@
 #include <cstdint>
 #include <limits>
 
+// bytes per pixel of the targets: RG16 normal, RGBA8 albedo, RG8 material and the 32 bit depth stencil
+inline constexpr uint32_t GBUFFER_BYTES_PER_PIXEL = 4 + 4 + 2 + 4;
+
 class GBuffer{
 public:
     GBuffer() = default;
@@ -15,12 +18,12 @@ public:
     void Bind() const;
     void Unbind() const;
 
-    inline unsigned int GetPositionTexture() const { return m_PositionTexture; }
     inline unsigned int GetNormalTexture() const { return m_NormalTexture; }
     inline unsigned int GetAlbedoTexture() const { return m_AlbedoTexture; }
+    inline unsigned int GetMaterialTexture() const { return m_MaterialTexture; }
 
     inline unsigned int GetFBO() const { return m_FBO; }
-    inline unsigned int GetRBO() const { return m_RBO; }
+    inline unsigned int GetDepthTexture() const { return m_DepthTexture; }
 
     void Resize(int width, int height);
 
@@ -28,12 +31,13 @@ private:
     void CheckStatus();
 
     unsigned int m_FBO;
-    unsigned int m_RBO;
+    // sampleable so the Hi-Z pyramid and the positions of the deferred pass can be built from it. Also the depth of the deferred pass framebuffer
+    unsigned int m_DepthTexture;
 
-    // maps packed to reduce memory usage
-    unsigned int m_PositionTexture; // .rgb = position, .a = roughness
-    unsigned int m_NormalTexture; // .rgb = normal, .a = metallic
+    // maps packed to reduce memory usage, the position is rebuilt from the depth
+    unsigned int m_NormalTexture; // .rg = octahedral encoded normal
     unsigned int m_AlbedoTexture; // .rgb = albedo, .a = ambient occlusion
+    unsigned int m_MaterialTexture; // .r = roughness, .g = metallic
 
     uint32_t m_ResizeCallbackID = std::numeric_limits<uint32_t>::max();
 };
\ No newline at end of file
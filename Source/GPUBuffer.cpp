@@ -1,4 +1,5 @@
 #include <GPUBuffer.hpp>
+#include <OpenGL.hpp>
 #include <Log.hpp>
 
 #include <glad/glad.h>
@@ -27,7 +28,7 @@ void GPUBuffer::Init(unsigned int num_vertices, unsigned int vertex_size, unsign
 {
     if(num_vertices > 0){
         glGenBuffers(1, &m_VBO);
-        glBindBuffer(GL_ARRAY_BUFFER ,m_VBO);
+        BindBuffer(GL_ARRAY_BUFFER ,m_VBO);
         glBufferData(GL_ARRAY_BUFFER, num_vertices * vertex_size, nullptr, GL_DYNAMIC_DRAW); 
     }
 
@@ -35,7 +36,7 @@ void GPUBuffer::Init(unsigned int num_vertices, unsigned int vertex_size, unsign
 
     if(num_indices > 0){
         glGenBuffers(1, &m_EBO);   
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_EBO);
+        BindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_EBO);
         glBufferData(GL_ELEMENT_ARRAY_BUFFER, num_indices * sizeof(unsigned int), nullptr, GL_DYNAMIC_DRAW); 
     }
 
@@ -46,9 +47,9 @@ void GPUBuffer::Init(unsigned int num_vertices, unsigned int vertex_size, unsign
 
 void GPUBuffer::Free()
 {
-    glDeleteBuffers(1, &m_VBO);
-    glDeleteBuffers(1, &m_EBO);
-    glDeleteVertexArrays(1, &m_VAO);
+    DeleteBuffers(1, &m_VBO);
+    DeleteBuffers(1, &m_EBO);
+    DeleteVertexArrays(1, &m_VAO);
 }
 
 void GPUBuffer::SetData(unsigned int start_index, const void* data, unsigned int num_vertices, unsigned int vertex_size) const
@@ -89,30 +90,30 @@ void GPUBuffer::AddAttributes(unsigned int* num_elements, unsigned int* types, u
 
 void GPUBuffer::BindVBO() const
 {
-    glBindBuffer(GL_ARRAY_BUFFER, m_VBO);
+    BindBuffer(GL_ARRAY_BUFFER, m_VBO);
 }
 
 void GPUBuffer::UnbindVBO() const
 {
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    BindBuffer(GL_ARRAY_BUFFER, 0);
 }
 
 void GPUBuffer::BindEBO() const
 {
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_EBO);
+    BindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_EBO);
 }
 
 void GPUBuffer::UnbindEBO() const
 {
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    BindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 }
 
 void GPUBuffer::BindVAO() const
 {
-    glBindVertexArray(m_VAO);
+    BindVertexArray(m_VAO);
 }
 
 void GPUBuffer::UnbindVAO() const
 {
-    glBindVertexArray(0);
+    BindVertexArray(0);
 }
\ No newline at end of file
@@ -0,0 +1,418 @@
+#include <GPUCulling.hpp>
+#include <OpenGL.hpp>
+#include <ComputeShader.hpp>
+#include <ResourceManager.hpp>
+#include <Renderer.hpp>
+#include <Camera.hpp>
+#include <HiZ.hpp>
+#include <DynamicResolution.hpp>
+#include <Globals.hpp>
+
+#include <glad/glad.h>
+
+#include <vector>
+#include <limits>
+#include <algorithm>
+
+static constexpr UniformHandle IS_PLAYING("isPlaying");
+static constexpr UniformHandle LIGHT_SPACE_MATRIX("lightSpaceMatrix");
+
+struct InstanceBounds{
+    glm::vec4 center;
+    glm::vec4 extents;
+    glm::vec4 axisX;
+    glm::vec4 axisY;
+    glm::vec4 axisZ;
+};
+
+struct DrawBatch{
+    const Mesh* mesh;
+    Animator* animator; // nullptr for static models
+};
+
+// must match GPUCulling.comp
+enum CullingPhase{
+    PHASE_FRUSTUM = 0,
+    PHASE_OCCLUSION = 1,
+    PHASE_RETEST = 2,
+    PHASE_SHADOW = 3
+};
+
+static bool g_UseGPUCulling = false;
+static bool g_UseOcclusionCulling = false;
+static bool g_GPUSceneDirty = true;
+static uint32_t g_NumInstances = 0;
+static uint32_t g_InstanceCapacity = 0;
+static uint32_t g_CommandCapacity = 0;
+
+static ComputeShader g_CullingShader;
+
+static unsigned int g_InstanceBuffer = std::numeric_limits<unsigned int>::max(); // binding 0
+static unsigned int g_VisibleBuffer = std::numeric_limits<unsigned int>::max(); // binding 1, the InstanceData of the visible instances, read as instance attributes
+static unsigned int g_BoundsBuffer = std::numeric_limits<unsigned int>::max(); // binding 2
+static unsigned int g_CommandBuffer = std::numeric_limits<unsigned int>::max(); // binding 3, also the indirect buffer
+static unsigned int g_InstanceCommandBuffer = std::numeric_limits<unsigned int>::max(); // binding 4
+static unsigned int g_CommandTemplateBuffer = std::numeric_limits<unsigned int>::max(); // commands with instanceCount = 0, copied before each culling pass
+static unsigned int g_RetestBuffer = std::numeric_limits<unsigned int>::max(); // binding 5, instances occluded in the first phase
+static unsigned int g_CounterBuffer = std::numeric_limits<unsigned int>::max(); // binding 6, number of drawn instances
+
+// the retest phase has its own visible list and commands, so it doesn't overwrite what the first phase is drawing
+static unsigned int g_RetestVisibleBuffer = std::numeric_limits<unsigned int>::max();
+static unsigned int g_RetestCommandBuffer = std::numeric_limits<unsigned int>::max();
+
+// one batch for each command
+static std::vector<DrawBatch> g_Batches;
+
+static std::vector<InstanceData> g_Instances;
+static std::vector<InstanceBounds> g_Bounds;
+static std::vector<uint32_t> g_InstanceCommands;
+static std::vector<DrawElementsIndirectCommand> g_Commands;
+
+void InitGPUCulling()
+{
+    g_CullingShader.Load("Resources/Shaders/GPUCulling.comp");
+
+    unsigned int buffers[10];
+    glGenBuffers(10, buffers);
+
+    g_InstanceBuffer = buffers[0];
+    g_VisibleBuffer = buffers[1];
+    g_BoundsBuffer = buffers[2];
+    g_CommandBuffer = buffers[3];
+    g_InstanceCommandBuffer = buffers[4];
+    g_CommandTemplateBuffer = buffers[5];
+    g_RetestBuffer = buffers[6];
+    g_CounterBuffer = buffers[7];
+    g_RetestVisibleBuffer = buffers[8];
+    g_RetestCommandBuffer = buffers[9];
+
+    uint32_t zero = 0;
+    BindBuffer(GL_SHADER_STORAGE_BUFFER, g_CounterBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(uint32_t), &zero, GL_DYNAMIC_READ);
+    BindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    g_InstanceCapacity = 0;
+    g_CommandCapacity = 0;
+    g_GPUSceneDirty = true;
+
+    InitHiZ();
+}
+
+void DeinitGPUCulling()
+{
+    unsigned int buffers[10] = {g_InstanceBuffer, g_VisibleBuffer, g_BoundsBuffer, g_CommandBuffer, g_InstanceCommandBuffer,
+                                g_CommandTemplateBuffer, g_RetestBuffer, g_CounterBuffer, g_RetestVisibleBuffer, g_RetestCommandBuffer};
+    DeleteBuffers(10, buffers);
+
+    g_CullingShader.Unload();
+
+    g_Batches.clear();
+
+    DeinitHiZ();
+}
+
+void UseGPUCulling(bool use)
+{
+    g_UseGPUCulling = use;
+    g_GPUSceneDirty = true;
+}
+
+bool GetUseGPUCulling()
+{
+    return g_UseGPUCulling;
+}
+
+void UseOcclusionCulling(bool use)
+{
+    g_UseOcclusionCulling = use;
+    InvalidateHiZ(); // the pyramid wasn't kept up to date while occlusion culling was disabled
+}
+
+bool GetUseOcclusionCulling()
+{
+    return g_UseOcclusionCulling;
+}
+
+void MarkGPUSceneDirty()
+{
+    g_GPUSceneDirty = true;
+}
+
+static void AddMeshInstances(Model& model, uint32_t mesh_index, Animator* animator)
+{
+    const Mesh& mesh = model.GetMeshes()[mesh_index];
+    const GeometryRange& geometry = mesh.GetGeometry();
+
+    g_Commands.push_back({geometry.index_count, 0, geometry.first_index, (int32_t)geometry.base_vertex, (uint32_t)g_Instances.size()});
+    g_Batches.push_back({&mesh, animator});
+
+    for(uint32_t i = 0; i < model.GetTransforms().size(); i++){
+        const OBB& obb = model.GetWorldOBB(i, mesh_index);
+
+        g_Instances.push_back(model.GetInstanceData(i));
+        g_Bounds.push_back({glm::vec4(obb.center, 0.0f), glm::vec4(obb.extents, 0.0f),
+                            glm::vec4(obb.rotation[0], 0.0f), glm::vec4(obb.rotation[1], 0.0f), glm::vec4(obb.rotation[2], 0.0f)});
+        g_InstanceCommands.push_back(g_Commands.size() - 1);
+    }
+}
+
+static void UploadBuffer(unsigned int buffer, const void* data, size_t size, size_t capacity)
+{
+    BindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+
+    if(size > capacity){
+        glBufferData(GL_SHADER_STORAGE_BUFFER, size, data, GL_DYNAMIC_DRAW);
+    }else if(size > 0 && data){
+        glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, size, data);
+    }
+}
+
+/**
+ * \brief Rebuild the instance buffers from the models of the resource manager. The bounds must be up to date
+ */
+static void UpdateGPUScene()
+{
+    g_Batches.clear();
+    g_Instances.clear();
+    g_Bounds.clear();
+    g_InstanceCommands.clear();
+    g_Commands.clear();
+
+    // static models first, so the bones are uploaded only for the skinned ones.
+    // Sorted by chunk, so the shadow passes draw the static meshes of a chunk with one multi draw
+    std::vector<std::pair<Model*, uint32_t>> static_meshes;
+    for(auto& [id, model] : GetModels()){
+        if(model.GetTransforms().empty()){
+            continue;
+        }
+
+        for(uint32_t j = 0; j < model.GetMeshes().size(); j++){
+            static_meshes.push_back({&model, j});
+        }
+    }
+
+    std::stable_sort(static_meshes.begin(), static_meshes.end(), [](const std::pair<Model*, uint32_t>& a, const std::pair<Model*, uint32_t>& b){
+        return a.first->GetMeshes()[a.second].GetGeometry().chunk < b.first->GetMeshes()[b.second].GetGeometry().chunk;
+    });
+
+    for(auto& [model, mesh_index] : static_meshes){
+        AddMeshInstances(*model, mesh_index, nullptr);
+    }
+
+    for(auto& [id, skinned_model] : GetSkinnedModels()){
+        if(skinned_model.model.GetTransforms().empty()){
+            continue;
+        }
+
+        for(uint32_t j = 0; j < skinned_model.model.GetMeshes().size(); j++){
+            AddMeshInstances(skinned_model.model, j, &skinned_model.animator);
+        }
+    }
+
+    g_NumInstances = g_Instances.size();
+
+    UploadBuffer(g_InstanceBuffer, g_Instances.data(), g_Instances.size() * sizeof(InstanceData), g_InstanceCapacity * sizeof(InstanceData));
+    UploadBuffer(g_BoundsBuffer, g_Bounds.data(), g_Bounds.size() * sizeof(InstanceBounds), g_InstanceCapacity * sizeof(InstanceBounds));
+    UploadBuffer(g_InstanceCommandBuffer, g_InstanceCommands.data(), g_InstanceCommands.size() * sizeof(uint32_t), g_InstanceCapacity * sizeof(uint32_t));
+    if(g_NumInstances > g_InstanceCapacity){
+        UploadBuffer(g_VisibleBuffer, nullptr, g_NumInstances * sizeof(InstanceData), 0);
+        UploadBuffer(g_RetestVisibleBuffer, nullptr, g_NumInstances * sizeof(InstanceData), 0);
+        UploadBuffer(g_RetestBuffer, nullptr, g_NumInstances * sizeof(uint32_t), 0);
+        g_InstanceCapacity = g_NumInstances;
+    }
+
+    UploadBuffer(g_CommandTemplateBuffer, g_Commands.data(), g_Commands.size() * sizeof(DrawElementsIndirectCommand), g_CommandCapacity * sizeof(DrawElementsIndirectCommand));
+    if(g_Commands.size() > g_CommandCapacity){
+        UploadBuffer(g_CommandBuffer, nullptr, g_Commands.size() * sizeof(DrawElementsIndirectCommand), 0);
+        UploadBuffer(g_RetestCommandBuffer, nullptr, g_Commands.size() * sizeof(DrawElementsIndirectCommand), 0);
+        g_CommandCapacity = g_Commands.size();
+    }
+
+    BindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    g_GPUSceneDirty = false;
+}
+
+/**
+ * \brief Fill the commands and the visible list with the instances that pass the test of the given phase
+ * \param count_drawn add the visible instances to the counter buffer
+ */
+static void CullInstances(Frustum& frustum, CullingPhase phase, unsigned int visible_buffer, unsigned int command_buffer, bool count_drawn)
+{
+    // reset the instance counts
+    BindBuffer(GL_COPY_READ_BUFFER, g_CommandTemplateBuffer);
+    BindBuffer(GL_COPY_WRITE_BUFFER, command_buffer);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, g_Commands.size() * sizeof(DrawElementsIndirectCommand));
+
+    glm::vec4 planes[NUM_PLANES];
+    for(int i = 0; i < NUM_PLANES; i++){
+        planes[i] = glm::vec4(frustum.Planes[i].normal, frustum.Planes[i].distance);
+    }
+
+    g_CullingShader.Bind();
+    g_CullingShader.SetUniform4fv("planes", planes[0], NUM_PLANES);
+    g_CullingShader.SetUniform1ui("numInstances", g_NumInstances);
+    g_CullingShader.SetUniform1ui("phase", phase);
+    g_CullingShader.SetUniform1i("countDrawn", count_drawn);
+
+    if(phase == PHASE_OCCLUSION || phase == PHASE_RETEST){
+        BindTexture(GetHiZTexture(), 11);
+        g_CullingShader.SetUniform1i("hiz", 11);
+        g_CullingShader.SetUniformMat4fv("hizViewProjection", GetHiZViewProjection());
+        g_CullingShader.SetUniform2f("hizSize", GetHiZSize().x, GetHiZSize().y);
+        g_CullingShader.SetUniform1i("hizLevels", GetHiZLevels());
+    }
+
+    BindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, g_InstanceBuffer);
+    BindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, visible_buffer);
+    BindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, g_BoundsBuffer);
+    BindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, command_buffer);
+    BindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, g_InstanceCommandBuffer);
+    BindBufferBase(GL_SHADER_STORAGE_BUFFER, 5, g_RetestBuffer);
+    BindBufferBase(GL_SHADER_STORAGE_BUFFER, 6, g_CounterBuffer);
+
+    g_CullingShader.Dispatch((g_NumInstances + 63) / 64, 1, 1);
+
+    glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+
+    BindBuffer(GL_DRAW_INDIRECT_BUFFER, command_buffer);
+}
+
+/**
+ * \brief Upload the pose of a skinned batch, or turn the skinning off for a static one.
+ * The program keeps isPlaying from the last skinned batch, also into the next pass
+ */
+static void SetBatchAnimator(Shader& shader, Animator* animator)
+{
+    if(animator){
+        animator->UploadFinalBoneMatrices(shader);
+    }else{
+        shader.SetUniform1i(IS_PLAYING, 0);
+    }
+}
+
+static void DrawBatches(Shader& shader, unsigned int visible_buffer)
+{
+    shader.Bind();
+
+    // one indirect draw for each mesh, because each binds its own textures. The shadow passes bind none and use multi draws
+    for(uint32_t i = 0; i < g_Batches.size(); i++){
+        if(i == 0 || g_Batches[i].animator != g_Batches[i - 1].animator){
+            SetBatchAnimator(shader, g_Batches[i].animator);
+        }
+
+        g_Batches[i].mesh->DrawIndirect(shader, visible_buffer, i * sizeof(DrawElementsIndirectCommand));
+    }
+}
+
+void DrawModelsGPU(Shader& shader, glm::mat4 view, Frustum& frustum)
+{
+    if(g_GPUSceneDirty){
+        UpdateGPUScene();
+    }
+
+    if(g_NumInstances == 0){
+        return;
+    }
+
+    #ifdef DEBUG
+        uint32_t zero = 0;
+        BindBuffer(GL_SHADER_STORAGE_BUFFER, g_CounterBuffer);
+        glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(uint32_t), &zero);
+    #endif
+
+    // first phase: what was visible from last frame's point of view
+    bool had_pyramid = g_UseOcclusionCulling && IsHiZValid();
+    CullInstances(frustum, had_pyramid ? PHASE_OCCLUSION : PHASE_FRUSTUM, g_VisibleBuffer, g_CommandBuffer, true);
+    DrawBatches(shader, g_VisibleBuffer);
+
+    if(g_UseOcclusionCulling){
+        BuildHiZ(GetGBuffer().GetDepthTexture(), GetRenderWidth(), GetRenderHeight(), GetCamera().GetProjectionMatrix() * view);
+
+        // second phase: draw the instances that were wrongly rejected by the old pyramid
+        if(had_pyramid){
+            CullInstances(frustum, PHASE_RETEST, g_RetestVisibleBuffer, g_RetestCommandBuffer, true);
+            DrawBatches(shader, g_RetestVisibleBuffer);
+        }
+    }
+
+    BindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
+    #ifdef DEBUG
+        uint32_t drawn_instances = 0;
+        BindBuffer(GL_SHADER_STORAGE_BUFFER, g_CounterBuffer);
+        glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(uint32_t), &drawn_instances);
+        BindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+        drawn += drawn_instances;
+        culled += g_NumInstances - drawn_instances;
+    #endif
+}
+
+uint32_t DrawModelsShadowsGPU(Shader& shader, glm::mat4 light_space_matrix, Frustum& light_frustum, const ShadowCasterLight& light)
+{
+    if(g_GPUSceneDirty){
+        UpdateGPUScene();
+    }
+
+    if(g_NumInstances == 0){
+        return 0;
+    }
+
+    #ifdef DEBUG
+        uint32_t zero = 0;
+        BindBuffer(GL_SHADER_STORAGE_BUFFER, g_CounterBuffer);
+        glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(uint32_t), &zero);
+    #endif
+
+    glm::vec4 camera_planes[NUM_PLANES];
+    for(int i = 0; i < NUM_PLANES; i++){
+        camera_planes[i] = glm::vec4(g_Frustum.Planes[i].normal, g_Frustum.Planes[i].distance);
+    }
+
+    g_CullingShader.Bind();
+    g_CullingShader.SetUniform4fv("cameraPlanes", camera_planes[0], NUM_PLANES);
+    g_CullingShader.SetUniform4fv("shadowLight", glm::vec4(light.directional ? light.direction : light.position, light.range));
+    g_CullingShader.SetUniform1i("shadowDirectional", light.directional);
+
+    #ifdef DEBUG
+        CullInstances(light_frustum, PHASE_SHADOW, g_VisibleBuffer, g_CommandBuffer, true);
+    #else
+        CullInstances(light_frustum, PHASE_SHADOW, g_VisibleBuffer, g_CommandBuffer, false);
+    #endif
+
+    shader.Bind();
+    shader.SetUniformMat4fv(LIGHT_SPACE_MATRIX, light_space_matrix);
+
+    // one multi draw for each run of batches with the same animator and chunk: a chunk of static meshes, or a skinned model
+    uint32_t first = 0;
+    while(first < g_Batches.size()){
+        Animator* animator = g_Batches[first].animator;
+        uint32_t chunk = g_Batches[first].mesh->GetGeometry().chunk;
+
+        uint32_t last = first + 1;
+        while(last < g_Batches.size() && g_Batches[last].animator == animator && g_Batches[last].mesh->GetGeometry().chunk == chunk){
+            last++;
+        }
+
+        if(first == 0 || animator != g_Batches[first - 1].animator){
+            SetBatchAnimator(shader, animator);
+        }
+
+        Mesh::MultiDrawIndirect(chunk, g_VisibleBuffer, first * sizeof(DrawElementsIndirectCommand), last - first);
+
+        first = last;
+    }
+
+    BindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
+    uint32_t casters = 0;
+
+    #ifdef DEBUG
+        BindBuffer(GL_SHADER_STORAGE_BUFFER, g_CounterBuffer);
+        glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(uint32_t), &casters);
+        BindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    #endif
+
+    return casters;
+}
\ No newline at end of file
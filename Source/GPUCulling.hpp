@@ -0,0 +1,48 @@
+#pragma once
+
+#include <Frustum.hpp>
+#include <Shader.hpp>
+
+#include <glm.hpp>
+
+#include <cstdint>
+
+/**
+ * \brief Layout expected by glDrawElementsIndirect
+ */
+struct DrawElementsIndirectCommand{
+    uint32_t count;
+    uint32_t instanceCount;
+    uint32_t firstIndex;
+    int32_t baseVertex;
+    uint32_t baseInstance;
+};
+
+extern void InitGPUCulling();
+extern void DeinitGPUCulling();
+
+extern void UseGPUCulling(bool use);
+extern bool GetUseGPUCulling();
+
+/**
+ * \brief Test the instances against a Hi-Z pyramid of the previous frame. Only used by the GPU culling path
+ */
+extern void UseOcclusionCulling(bool use);
+extern bool GetUseOcclusionCulling();
+
+/**
+ * \brief Ask for the instance buffers to be rebuilt before the next culling pass. Call it when instances were added, removed or moved
+ */
+extern void MarkGPUSceneDirty();
+
+/**
+ * \brief Cull every model instance against the frustum with a compute shader, then draw the visible ones for the G-buffer.
+ * With occlusion culling, the instances hidden in last frame's pyramid are skipped, then retested against the pyramid built from this frame's depth
+ */
+extern void DrawModelsGPU(Shader& shader, glm::mat4 view, Frustum& frustum);
+
+/**
+ * \brief Same as DrawModelsGPU, for the shadow passes. The casters must be inside the light frustum and their shadow must reach the camera frustum
+ * \return the number of casters drawn in DEBUG builds (read back from the GPU), 0 otherwise
+ */
+extern uint32_t DrawModelsShadowsGPU(Shader& shader, glm::mat4 light_space_matrix, Frustum& light_frustum, const ShadowCasterLight& light);
\ No newline at end of file
@@ -0,0 +1,330 @@
+#include <GeometryArena.hpp>
+#include <OpenGL.hpp>
+#include <Mesh.hpp>
+#include <VertexFormat.hpp>
+#include <Log.hpp>
+
+#include <glad/glad.h>
+
+#include <map>
+#include <algorithm>
+#include <cstddef>
+
+static constexpr uint32_t CHUNK_VERTICES = 1 << 19; // 12 MB of static vertices, 6 MB more of skin vertices
+static constexpr uint32_t CHUNK_INDICES = 1 << 21; // 8 MB of indices
+
+/**
+ * \brief First fit allocator over a range of elements. The free blocks are kept sorted by offset and merged with their neighbours
+ */
+class FreeList{
+public:
+    void Init(uint32_t size)
+    {
+        m_Free.clear();
+        m_Free[0] = size;
+    }
+
+    bool Allocate(uint32_t size, uint32_t& offset)
+    {
+        for(auto it = m_Free.begin(); it != m_Free.end(); ++it){
+            if(it->second >= size){
+                offset = it->first;
+                uint32_t remaining = it->second - size;
+                m_Free.erase(it);
+
+                if(remaining > 0){
+                    m_Free[offset + size] = remaining;
+                }
+
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    void Free(uint32_t offset, uint32_t size)
+    {
+        if(size == 0 || IsFree(offset)){
+            return;
+        }
+
+        auto next = m_Free.lower_bound(offset);
+
+        if(next != m_Free.end() && offset + size == next->first){
+            size += next->second;
+            next = m_Free.erase(next);
+        }
+
+        if(next != m_Free.begin()){
+            auto prev = std::prev(next);
+            if(prev->first + prev->second == offset){
+                prev->second += size;
+                return;
+            }
+        }
+
+        m_Free[offset] = size;
+    }
+
+private:
+    bool IsFree(uint32_t offset) const
+    {
+        auto it = m_Free.upper_bound(offset);
+
+        if(it == m_Free.begin()){
+            return false;
+        }
+
+        --it;
+        return offset < it->first + it->second;
+    }
+
+    std::map<uint32_t, uint32_t> m_Free; // offset, size
+};
+
+struct GeometryChunk{
+    unsigned int vbo; // StaticVertex stream
+    unsigned int skin_vbo; // SkinVertex stream, 0 for the chunks of static meshes
+    unsigned int ebo;
+    FreeList vertices;
+    FreeList indices;
+
+    inline bool IsSkinned() const { return skin_vbo != 0; }
+};
+
+enum GeometryFormat{
+    GEOMETRY_STATIC = 0,
+    GEOMETRY_SKINNED = 1,
+    NUM_GEOMETRY_FORMATS
+};
+
+static std::vector<GeometryChunk> g_Chunks;
+static unsigned int g_VAOs[NUM_GEOMETRY_FORMATS] = {0};
+static uint32_t g_AttachedChunks[NUM_GEOMETRY_FORMATS] = {INVALID_GEOMETRY_CHUNK, INVALID_GEOMETRY_CHUNK};
+
+static void InitInstanceAttributes()
+{
+    // the instance buffer is bound before each draw, so copies of a mesh can be drawn from different buffers
+    for(unsigned int i = 0; i < 4; i++){
+        glEnableVertexAttribArray(INSTANCE_MODEL_LOCATION + i);
+        glVertexAttribFormat(INSTANCE_MODEL_LOCATION + i, 4, GL_FLOAT, GL_FALSE, offsetof(InstanceData, model) + i * sizeof(glm::vec4));
+        glVertexAttribBinding(INSTANCE_MODEL_LOCATION + i, INSTANCE_BUFFER_BINDING);
+    }
+
+    for(unsigned int i = 0; i < 3; i++){
+        glEnableVertexAttribArray(INSTANCE_NORMAL_LOCATION + i);
+        glVertexAttribFormat(INSTANCE_NORMAL_LOCATION + i, 3, GL_FLOAT, GL_FALSE, offsetof(InstanceData, normal) + i * sizeof(glm::vec4));
+        glVertexAttribBinding(INSTANCE_NORMAL_LOCATION + i, INSTANCE_BUFFER_BINDING);
+    }
+
+    glEnableVertexAttribArray(INSTANCE_LAYER_LOCATION);
+    glVertexAttribFormat(INSTANCE_LAYER_LOCATION, 1, GL_FLOAT, GL_FALSE, offsetof(InstanceData, normal) + 3 * sizeof(glm::vec4));
+    glVertexAttribBinding(INSTANCE_LAYER_LOCATION, INSTANCE_BUFFER_BINDING);
+
+    glVertexBindingDivisor(INSTANCE_BUFFER_BINDING, 1);
+}
+
+void InitGeometryArena()
+{
+    glGenVertexArrays(NUM_GEOMETRY_FORMATS, g_VAOs);
+
+    BindVertexArray(g_VAOs[GEOMETRY_STATIC]);
+    ApplyVertexLayout(STATIC_VERTEX_LAYOUT);
+    InitInstanceAttributes();
+
+    BindVertexArray(g_VAOs[GEOMETRY_SKINNED]);
+    ApplyVertexLayout(STATIC_VERTEX_LAYOUT);
+    ApplyVertexLayout(SKIN_VERTEX_LAYOUT);
+    InitInstanceAttributes();
+
+    BindVertexArray(0);
+
+    // the bone attributes are disabled in the static VAO, the shaders read these values instead: no bones
+    glVertexAttribI4ui(SKIN_VERTEX_ATTRIBUTES[0].location, NO_BONE, NO_BONE, NO_BONE, NO_BONE);
+    glVertexAttrib4f(SKIN_VERTEX_ATTRIBUTES[1].location, 0.0f, 0.0f, 0.0f, 0.0f);
+
+    g_AttachedChunks[GEOMETRY_STATIC] = g_AttachedChunks[GEOMETRY_SKINNED] = INVALID_GEOMETRY_CHUNK;
+}
+
+void DeinitGeometryArena()
+{
+    for(GeometryChunk& chunk : g_Chunks){
+        DeleteBuffers(1, &chunk.vbo);
+        DeleteBuffers(1, &chunk.ebo);
+
+        if(chunk.IsSkinned()){
+            DeleteBuffers(1, &chunk.skin_vbo);
+        }
+    }
+
+    g_Chunks.clear();
+
+    DeleteVertexArrays(NUM_GEOMETRY_FORMATS, g_VAOs);
+    g_VAOs[GEOMETRY_STATIC] = g_VAOs[GEOMETRY_SKINNED] = 0;
+    g_AttachedChunks[GEOMETRY_STATIC] = g_AttachedChunks[GEOMETRY_SKINNED] = INVALID_GEOMETRY_CHUNK;
+}
+
+static uint32_t CreateChunk(uint32_t num_vertices, uint32_t num_indices, bool skinned)
+{
+    GeometryChunk chunk;
+    chunk.skin_vbo = 0;
+
+    num_vertices = std::max(num_vertices, CHUNK_VERTICES);
+    num_indices = std::max(num_indices, CHUNK_INDICES);
+
+    // immutable storage, written only with glBufferSubData when a mesh is loaded
+    glGenBuffers(1, &chunk.vbo);
+    BindBuffer(GL_COPY_WRITE_BUFFER, chunk.vbo);
+    glBufferStorage(GL_COPY_WRITE_BUFFER, (size_t)num_vertices * sizeof(StaticVertex), nullptr, GL_DYNAMIC_STORAGE_BIT);
+
+    if(skinned){
+        glGenBuffers(1, &chunk.skin_vbo);
+        BindBuffer(GL_COPY_WRITE_BUFFER, chunk.skin_vbo);
+        glBufferStorage(GL_COPY_WRITE_BUFFER, (size_t)num_vertices * sizeof(SkinVertex), nullptr, GL_DYNAMIC_STORAGE_BIT);
+    }
+
+    glGenBuffers(1, &chunk.ebo);
+    BindBuffer(GL_COPY_WRITE_BUFFER, chunk.ebo);
+    glBufferStorage(GL_COPY_WRITE_BUFFER, (size_t)num_indices * sizeof(unsigned int), nullptr, GL_DYNAMIC_STORAGE_BIT);
+
+    BindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    chunk.vertices.Init(num_vertices);
+    chunk.indices.Init(num_indices);
+
+    g_Chunks.push_back(chunk);
+
+    #ifdef DEBUG
+        LogMessage("Geometry chunk %zu created: %u %s vertices, %u indices", g_Chunks.size() - 1, num_vertices, skinned ? "skinned" : "static", num_indices);
+    #endif
+
+    return g_Chunks.size() - 1;
+}
+
+static bool AllocateInChunk(uint32_t chunk_index, uint32_t num_vertices, uint32_t num_indices, GeometryRange& range)
+{
+    GeometryChunk& chunk = g_Chunks[chunk_index];
+    uint32_t base_vertex, first_index;
+
+    if(!chunk.vertices.Allocate(num_vertices, base_vertex)){
+        return false;
+    }
+
+    if(!chunk.indices.Allocate(num_indices, first_index)){
+        chunk.vertices.Free(base_vertex, num_vertices);
+        return false;
+    }
+
+    range.chunk = chunk_index;
+    range.base_vertex = base_vertex;
+    range.vertex_count = num_vertices;
+    range.first_index = first_index;
+    range.allocated_indices = num_indices;
+    range.vertex_size = sizeof(StaticVertex) + (chunk.IsSkinned() ? sizeof(SkinVertex) : 0);
+    return true;
+}
+
+GeometryRange AllocateGeometry(const std::vector<Vertex>& vertices, const std::vector<std::vector<unsigned int>>& lods)
+{
+    GeometryRange range;
+
+    if(vertices.empty() || lods.empty() || lods[0].empty()){
+        LogWarning("Mesh without geometry");
+        return range;
+    }
+
+    uint32_t lod_count = std::min<uint32_t>(lods.size(), MAX_MESH_LODS);
+    uint32_t num_indices = 0;
+
+    for(uint32_t i = 0; i < lod_count; i++){
+        num_indices += lods[i].size();
+    }
+
+    bool skinned = HasBoneInfluences(vertices);
+    bool allocated = false;
+
+    for(uint32_t i = 0; i < g_Chunks.size() && !allocated; i++){
+        if(g_Chunks[i].IsSkinned() == skinned){
+            allocated = AllocateInChunk(i, vertices.size(), num_indices, range);
+        }
+    }
+
+    if(!allocated){
+        allocated = AllocateInChunk(CreateChunk(vertices.size(), num_indices, skinned), vertices.size(), num_indices, range);
+    }
+
+    // the LODs one after the other, so one free gives them all back
+    uint32_t first_index = range.first_index;
+    for(uint32_t i = 0; i < lod_count; i++){
+        range.lods[i] = {first_index, (uint32_t)lods[i].size()};
+        first_index += lods[i].size();
+    }
+
+    range.lod_count = lod_count;
+    range.index_count = range.lods[0].index_count;
+
+    const GeometryChunk& chunk = g_Chunks[range.chunk];
+
+    std::vector<StaticVertex> static_vertices(vertices.size());
+    for(size_t i = 0; i < vertices.size(); i++){
+        static_vertices[i] = EncodeStaticVertex(vertices[i]);
+    }
+
+    BindBuffer(GL_COPY_WRITE_BUFFER, chunk.vbo);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, (size_t)range.base_vertex * sizeof(StaticVertex), static_vertices.size() * sizeof(StaticVertex), static_vertices.data());
+
+    if(skinned){
+        std::vector<SkinVertex> skin_vertices(vertices.size());
+        for(size_t i = 0; i < vertices.size(); i++){
+            skin_vertices[i] = EncodeSkinVertex(vertices[i]);
+        }
+
+        BindBuffer(GL_COPY_WRITE_BUFFER, chunk.skin_vbo);
+        glBufferSubData(GL_COPY_WRITE_BUFFER, (size_t)range.base_vertex * sizeof(SkinVertex), skin_vertices.size() * sizeof(SkinVertex), skin_vertices.data());
+    }
+
+    BindBuffer(GL_COPY_WRITE_BUFFER, chunk.ebo);
+    for(uint32_t i = 0; i < lod_count; i++){
+        glBufferSubData(GL_COPY_WRITE_BUFFER, (size_t)range.lods[i].first_index * sizeof(unsigned int), lods[i].size() * sizeof(unsigned int), lods[i].data());
+    }
+    BindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    return range;
+}
+
+void FreeGeometry(const GeometryRange& range)
+{
+    if(range.chunk >= g_Chunks.size()){
+        return;
+    }
+
+    g_Chunks[range.chunk].vertices.Free(range.base_vertex, range.vertex_count);
+    g_Chunks[range.chunk].indices.Free(range.first_index, range.allocated_indices);
+}
+
+void BindGeometryChunk(uint32_t chunk)
+{
+    if(chunk >= g_Chunks.size()){
+        BindVertexArray(g_VAOs[GEOMETRY_STATIC]);
+        return;
+    }
+
+    const GeometryChunk& geometry_chunk = g_Chunks[chunk];
+    GeometryFormat format = geometry_chunk.IsSkinned() ? GEOMETRY_SKINNED : GEOMETRY_STATIC;
+
+    BindVertexArray(g_VAOs[format]);
+
+    if(chunk == g_AttachedChunks[format]){
+        return;
+    }
+
+    glBindVertexBuffer(STATIC_VERTEX_BUFFER_BINDING, geometry_chunk.vbo, 0, sizeof(StaticVertex));
+
+    if(geometry_chunk.IsSkinned()){
+        glBindVertexBuffer(SKIN_VERTEX_BUFFER_BINDING, geometry_chunk.skin_vbo, 0, sizeof(SkinVertex));
+    }
+
+    BindBuffer(GL_ELEMENT_ARRAY_BUFFER, geometry_chunk.ebo); // part of the VAO state
+    g_AttachedChunks[format] = chunk;
+}
\ No newline at end of file
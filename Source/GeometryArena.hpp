@@ -0,0 +1,59 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <limits>
+
+struct Vertex;
+
+inline constexpr uint32_t INVALID_GEOMETRY_CHUNK = std::numeric_limits<uint32_t>::max();
+inline constexpr uint32_t MAX_MESH_LODS = 4;
+
+/**
+ * \brief The indices of one level of detail of a mesh. All the LODs share the vertices of the range
+ */
+struct GeometryLOD{
+    uint32_t first_index = 0;
+    uint32_t index_count = 0;
+};
+
+/**
+ * \brief Where the vertices and indices of a mesh are stored in the arena. The indices are relative to base_vertex.
+ * first_index and index_count are the full detail mesh, the same as lods[0]
+ */
+struct GeometryRange{
+    uint32_t chunk = INVALID_GEOMETRY_CHUNK;
+    uint32_t base_vertex = 0;
+    uint32_t vertex_count = 0;
+    uint32_t first_index = 0;
+    uint32_t index_count = 0;
+    uint32_t vertex_size = 0; // bytes read for each vertex, summed over the streams
+
+    GeometryLOD lods[MAX_MESH_LODS];
+    uint32_t lod_count = 0;
+    uint32_t allocated_indices = 0; // the indices of all the LODs, stored one after the other from first_index
+};
+
+/**
+ * \brief Mesh geometry sub-allocated from a few large immutable vertex and index buffers (the chunks).
+ * The vertices are stored in the compact formats of VertexFormat.hpp: every chunk has a StaticVertex stream, the chunks of skinned meshes a SkinVertex stream too.
+ * One VAO for each format describes the vertex and instance attributes, only the buffers of the chunk change between meshes
+ */
+extern void InitGeometryArena();
+extern void DeinitGeometryArena();
+
+/**
+ * \brief Encode the vertices and copy them with the indices to the first chunk of the right format with room for them, a new chunk is created if none has.
+ * Meshes with bone influences go to the skinned chunks
+ * \param lods the index buffers of the levels of detail, from the full mesh to the coarsest. At most MAX_MESH_LODS are stored
+ */
+extern GeometryRange AllocateGeometry(const std::vector<Vertex>& vertices, const std::vector<std::vector<unsigned int>>& lods);
+/**
+ * \brief Give the range back to its chunk. Freeing a range twice (e.g. by two copies of a mesh) does nothing
+ */
+extern void FreeGeometry(const GeometryRange& range);
+
+/**
+ * \brief Bind the VAO of the format of the chunk. The buffers of the chunk are attached to it only if another chunk was attached
+ */
+extern void BindGeometryChunk(uint32_t chunk);
\ No newline at end of file
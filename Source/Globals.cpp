@@ -3,6 +3,15 @@ bool g_DrawBoundingBoxes = false;
 #ifdef DEBUG
     unsigned int drawn = 0;
     unsigned int culled = 0;
+    unsigned int bounds_rebuilt = 0;
+    unsigned int state_changes = 0;
+    unsigned int state_changes_unsorted = 0;
+    unsigned int gl_calls_issued = 0;
+    unsigned int gl_calls_elided = 0;
+    unsigned int triangles = 0;
+    unsigned int shadow_views = 0;
+    unsigned int shadow_views_rendered = 0;
+    unsigned int shadow_caches_rendered = 0;
 #endif
 
 int g_ScreenWidth = 1280;
@@ -9,11 +9,20 @@ inline constexpr float g_Near = 0.1f;
 inline constexpr float g_Far = 40.0f;
 inline constexpr const char* g_WindowTitle = "OpenglFPS";
 
-inline constexpr unsigned int MAX_LIGHTS = 10;
+inline constexpr unsigned int MAX_SHADOWED_LIGHTS = 10; // shadow maps of each light type, the other lights are drawn without shadows
 
 extern bool g_DrawBoundingBoxes;
 
 #ifdef DEBUG
     extern unsigned int drawn;
     extern unsigned int culled;
+    extern unsigned int bounds_rebuilt;
+    extern unsigned int state_changes; // shader, animator, material and geometry changes of the sorted render queues
+    extern unsigned int state_changes_unsorted; // the same changes if the queues weren't sorted
+    extern unsigned int gl_calls_issued; // binding and enable calls that reached OpenGL
+    extern unsigned int gl_calls_elided; // the ones dropped by the state cache because they wouldn't change anything
+    extern unsigned int triangles; // submitted by the render queues, at the LOD they were drawn with
+    extern unsigned int shadow_views; // shadow maps and cube map faces of the frame
+    extern unsigned int shadow_views_rendered; // the ones drawn again because their light or casters changed
+    extern unsigned int shadow_caches_rendered; // the ones whose static cache was drawn again too
 #endif
\ No newline at end of file
@@ -0,0 +1,135 @@
+#include <HiZ.hpp>
+#include <OpenGL.hpp>
+#include <ComputeShader.hpp>
+#include <Globals.hpp>
+#include <Window.hpp>
+
+#include <glad/glad.h>
+
+#include <limits>
+#include <algorithm>
+#include <cmath>
+
+static unsigned int g_HiZTexture = std::numeric_limits<unsigned int>::max();
+static int g_HiZWidth = 0;
+static int g_HiZHeight = 0;
+static int g_HiZLevels = 0;
+static bool g_HiZValid = false;
+static glm::mat4 g_HiZViewProjection = glm::mat4(1.0f);
+static uint32_t g_ResizeCallbackID = std::numeric_limits<uint32_t>::max();
+
+static ComputeShader g_HiZCopyShader;
+static ComputeShader g_HiZDownsampleShader;
+
+static void CreateHiZTexture(int width, int height)
+{
+    g_HiZWidth = std::max(width, 1);
+    g_HiZHeight = std::max(height, 1);
+    g_HiZLevels = (int)std::floor(std::log2((float)std::max(g_HiZWidth, g_HiZHeight))) + 1;
+
+    glGenTextures(1, &g_HiZTexture);
+    BindTexture(g_HiZTexture, 0);
+    glTexStorage2D(GL_TEXTURE_2D, g_HiZLevels, GL_R32F, g_HiZWidth, g_HiZHeight);
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    g_HiZValid = false;
+}
+
+static void ResizeHiZ(int width, int height)
+{
+    DeleteTextures(1, &g_HiZTexture);
+    CreateHiZTexture(width, height);
+}
+
+void InitHiZ()
+{
+    CreateHiZTexture(g_ScreenWidth, g_ScreenHeight);
+
+    g_HiZCopyShader.Load("Resources/Shaders/HiZCopy.comp");
+    g_HiZDownsampleShader.Load("Resources/Shaders/HiZDownsample.comp");
+
+    g_ResizeCallbackID = AddWindowResizeCallback(ResizeHiZ);
+}
+
+void DeinitHiZ()
+{
+    DeleteTextures(1, &g_HiZTexture);
+
+    g_HiZCopyShader.Unload();
+    g_HiZDownsampleShader.Unload();
+
+    RemoveWindowResizeCallback(g_ResizeCallbackID);
+    g_ResizeCallbackID = std::numeric_limits<uint32_t>::max();
+    g_HiZValid = false;
+}
+
+void BuildHiZ(unsigned int depth_texture, int depth_width, int depth_height, const glm::mat4& view_projection)
+{
+    // level 0 is a copy of the depth buffer
+    g_HiZCopyShader.Bind();
+    BindTexture(depth_texture, 11);
+    g_HiZCopyShader.SetUniform1i("depthTexture", 11);
+    g_HiZCopyShader.SetUniform2i("depthSize", depth_width, depth_height);
+    g_HiZCopyShader.SetUniform2f("depthScale", (float)depth_width / g_HiZWidth, (float)depth_height / g_HiZHeight);
+    glBindImageTexture(0, g_HiZTexture, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+
+    g_HiZCopyShader.Dispatch((g_HiZWidth + 15) / 16, (g_HiZHeight + 15) / 16, 1);
+    glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+
+    g_HiZDownsampleShader.Bind();
+
+    int width = g_HiZWidth;
+    int height = g_HiZHeight;
+
+    for(int level = 1; level < g_HiZLevels; level++){
+        g_HiZDownsampleShader.SetUniform2i("srcSize", width, height);
+
+        width = std::max(width / 2, 1);
+        height = std::max(height / 2, 1);
+
+        glBindImageTexture(0, g_HiZTexture, level - 1, GL_FALSE, 0, GL_READ_ONLY, GL_R32F);
+        glBindImageTexture(1, g_HiZTexture, level, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+
+        g_HiZDownsampleShader.Dispatch((width + 15) / 16, (height + 15) / 16, 1);
+        glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+    }
+
+    glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+
+    g_HiZViewProjection = view_projection;
+    g_HiZValid = true;
+}
+
+void InvalidateHiZ()
+{
+    g_HiZValid = false;
+}
+
+bool IsHiZValid()
+{
+    return g_HiZValid;
+}
+
+unsigned int GetHiZTexture()
+{
+    return g_HiZTexture;
+}
+
+int GetHiZLevels()
+{
+    return g_HiZLevels;
+}
+
+glm::vec2 GetHiZSize()
+{
+    return glm::vec2(g_HiZWidth, g_HiZHeight);
+}
+
+const glm::mat4& GetHiZViewProjection()
+{
+    return g_HiZViewProjection;
+}
\ No newline at end of file
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <glm.hpp>
+
+/**
+ * \brief Depth pyramid used for occlusion culling. Every texel of a level holds the farthest depth of the texels it covers in the level above
+ */
+extern void InitHiZ();
+extern void DeinitHiZ();
+
+/**
+ * \brief Build the pyramid from a depth texture. The pyramid keeps the size of the window, a depth rendered at a lower resolution is stretched over it
+ * \param depth_width, depth_height the part of the depth texture that was rendered, from its bottom left corner
+ * \param view_projection the matrix used to render the depth texture. It is stored to test bounds against the pyramid in the next frames
+ */
+extern void BuildHiZ(unsigned int depth_texture, int depth_width, int depth_height, const glm::mat4& view_projection);
+
+/**
+ * \brief Forget the current pyramid, e.g. after a resize. Nothing is occluded until the next BuildHiZ
+ */
+extern void InvalidateHiZ();
+
+extern bool IsHiZValid();
+extern unsigned int GetHiZTexture();
+extern int GetHiZLevels();
+extern glm::vec2 GetHiZSize();
+extern const glm::mat4& GetHiZViewProjection();
\ No newline at end of file
@@ -0,0 +1,144 @@
+#include <JobSystem.hpp>
+#include <Timer.hpp>
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <cstdio>
+
+static std::vector<std::thread> g_Workers;
+static std::mutex g_Mutex;
+static std::condition_variable g_WorkAvailable;
+static std::condition_variable g_WorkDone;
+
+// the batch being run, all guarded by g_Mutex except g_NextJob
+static std::vector<Job>* g_Jobs = nullptr;
+static std::atomic<uint32_t> g_NextJob = 0;
+static uint32_t g_CompletedJobs = 0;
+static uint32_t g_BusyWorkers = 0; // workers that took the batch, it can't be freed before they let it go
+static uint64_t g_Generation = 0;
+static bool g_Quit = false;
+
+/**
+ * \brief Take jobs from the batch until none is left
+ * \returns the number of jobs run
+ */
+static uint32_t ExecuteJobs(std::vector<Job>& jobs, uint32_t thread)
+{
+    uint32_t executed = 0;
+
+    for(uint32_t i = g_NextJob.fetch_add(1); i < jobs.size(); i = g_NextJob.fetch_add(1)){
+        auto start = std::chrono::high_resolution_clock::now();
+        jobs[i].function();
+        auto end = std::chrono::high_resolution_clock::now();
+
+        jobs[i].milliseconds = std::chrono::duration<double, std::milli>(end - start).count();
+        jobs[i].thread = thread;
+        executed++;
+    }
+
+    return executed;
+}
+
+static void WorkerLoop(uint32_t thread)
+{
+    uint64_t generation = 0;
+
+    while(true){
+        std::vector<Job>* jobs;
+
+        {
+            std::unique_lock<std::mutex> lock(g_Mutex);
+            g_WorkAvailable.wait(lock, [&]{ return g_Quit || (g_Jobs && g_Generation != generation); });
+
+            if(g_Quit){
+                return;
+            }
+
+            generation = g_Generation;
+            jobs = g_Jobs;
+            g_BusyWorkers++;
+        }
+
+        uint32_t executed = ExecuteJobs(*jobs, thread);
+
+        {
+            std::lock_guard<std::mutex> lock(g_Mutex);
+            g_CompletedJobs += executed;
+            g_BusyWorkers--;
+        }
+
+        g_WorkDone.notify_one();
+    }
+}
+
+void InitJobSystem(uint32_t num_workers)
+{
+    if(num_workers == 0){
+        num_workers = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+    }
+
+    g_Quit = false;
+
+    for(uint32_t i = 0; i < num_workers; i++){
+        g_Workers.emplace_back(WorkerLoop, i + 1);
+    }
+}
+
+void DeinitJobSystem()
+{
+    {
+        std::lock_guard<std::mutex> lock(g_Mutex);
+        g_Quit = true;
+    }
+
+    g_WorkAvailable.notify_all();
+
+    for(std::thread& worker : g_Workers){
+        worker.join();
+    }
+
+    g_Workers.clear();
+}
+
+void RunJobs(std::vector<Job>& jobs)
+{
+    if(jobs.empty()){
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(g_Mutex);
+        g_Jobs = &jobs;
+        g_NextJob = 0;
+        g_CompletedJobs = 0;
+        g_Generation++;
+    }
+
+    g_WorkAvailable.notify_all();
+
+    uint32_t executed = ExecuteJobs(jobs, 0);
+
+    {
+        std::unique_lock<std::mutex> lock(g_Mutex);
+        g_CompletedJobs += executed;
+        g_WorkDone.wait(lock, [&]{ return g_CompletedJobs == jobs.size() && g_BusyWorkers == 0; });
+        g_Jobs = nullptr;
+    }
+
+    #if defined(DEBUG) || defined(PROFILE)
+        if(GetShouldDisplayTimers()){
+            for(const Job& job : jobs){
+                printf("JOB: %s took %f ms (thread %u)\n", job.name, job.milliseconds, job.thread);
+            }
+        }
+    #endif
+}
+
+uint32_t GetWorkerCount()
+{
+    return (uint32_t)g_Workers.size();
+}
\ No newline at end of file
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <functional>
+#include <vector>
+#include <cstdint>
+
+/**
+ * \brief Work run by RunJobs. A job can run on any thread, so it must not call OpenGL: only the main thread owns the context
+ */
+struct Job{
+    const char* name;
+    std::function<void()> function;
+
+    // written by RunJobs
+    double milliseconds = 0.0;
+    uint32_t thread = 0; // 0 is the thread that called RunJobs, the workers start from 1
+};
+
+/**
+ * \brief Start the worker threads
+ * \param num_workers 0 for one less than the hardware threads, the thread calling RunJobs works too
+ */
+extern void InitJobSystem(uint32_t num_workers = 0);
+extern void DeinitJobSystem();
+
+/**
+ * \brief Run the jobs on the workers and on the calling thread, in any order. Returns when all of them are done.
+ * The time each job took is written in the job and printed with the other timers
+ */
+extern void RunJobs(std::vector<Job>& jobs);
+
+extern uint32_t GetWorkerCount();
\ No newline at end of file
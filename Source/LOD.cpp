@@ -0,0 +1,65 @@
+#include <LOD.hpp>
+#include <Globals.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+static uint32_t g_ShadowLODBias = 1;
+static bool g_ShowLODs = false;
+
+LODSelection GetLODSelection(glm::vec3 eye, uint32_t bias, bool hysteresis)
+{
+    return {eye, 1.0f / std::tan(glm::radians(g_FOV) * 0.5f), bias, hysteresis};
+}
+
+float GetProjectedSize(const OBB& obb, glm::vec3 eye, float projection_scale)
+{
+    float radius = glm::length(obb.extents);
+    float distance = glm::length(obb.center - eye);
+
+    if(distance <= radius){ // the camera is inside the sphere
+        return std::numeric_limits<float>::max();
+    }
+
+    return radius * projection_scale / distance;
+}
+
+uint32_t SelectLOD(float projected_size, uint32_t lod_count, int previous)
+{
+    uint32_t lod = 0;
+
+    while(lod + 1 < lod_count && projected_size < LOD_SCREEN_SIZES[lod]){
+        lod++;
+    }
+
+    if(previous >= 0 && std::abs((int)lod - previous) == 1){
+        float threshold = LOD_SCREEN_SIZES[std::min<int>(lod, previous)];
+
+        if(std::abs(projected_size - threshold) < threshold * LOD_HYSTERESIS){
+            return previous;
+        }
+    }
+
+    return lod;
+}
+
+void SetShadowLODBias(uint32_t bias)
+{
+    g_ShadowLODBias = std::min(bias, MAX_MESH_LODS - 1);
+}
+
+uint32_t GetShadowLODBias()
+{
+    return g_ShadowLODBias;
+}
+
+void SetShowLODs(bool show)
+{
+    g_ShowLODs = show;
+}
+
+bool GetShowLODs()
+{
+    return g_ShowLODs;
+}
\ No newline at end of file
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <GeometryArena.hpp>
+#include <BoundingBox.hpp>
+
+#include <glm.hpp>
+#include <cstdint>
+
+// projected size under which the next LOD is used, in half screen heights covered by the bounding sphere
+inline constexpr float LOD_SCREEN_SIZES[MAX_MESH_LODS - 1] = {0.25f, 0.12f, 0.05f};
+inline constexpr float LOD_HYSTERESIS = 0.15f; // fraction of a threshold the size must pass before the LOD changes back
+
+/**
+ * \brief How the LODs of a draw list are chosen
+ */
+struct LODSelection{
+    glm::vec3 eye; // the projected size is measured from the camera, shadow lists too unless their maps are cached
+    float projection_scale; // 1 / tan(fov / 2)
+    uint32_t bias; // LODs added after the selection
+    bool hysteresis; // read and update the LOD stored in the model for each instance, only one list may do it
+};
+
+extern LODSelection GetLODSelection(glm::vec3 eye, uint32_t bias, bool hysteresis);
+
+/**
+ * \returns the radius of the bounding sphere of the OBB projected on the screen, in half screen heights
+ */
+extern float GetProjectedSize(const OBB& obb, glm::vec3 eye, float projection_scale);
+/**
+ * \param previous the LOD of the last frame, -1 if none. A LOD next to it is only taken once the size is past the threshold by LOD_HYSTERESIS
+ */
+extern uint32_t SelectLOD(float projected_size, uint32_t lod_count, int previous = -1);
+
+/**
+ * \brief LODs added in the shadow passes, their details are hardly visible in the shadow maps
+ */
+extern void SetShadowLODBias(uint32_t bias);
+extern uint32_t GetShadowLODBias();
+
+/**
+ * \brief Tint the meshes in the G-buffer by the LOD they are drawn with
+ */
+extern void SetShowLODs(bool show);
+extern bool GetShowLODs();
\ No newline at end of file
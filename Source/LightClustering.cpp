@@ -0,0 +1,55 @@
+#include <LightClustering.hpp>
+#include <OpenGL.hpp>
+#include <ComputeShader.hpp>
+
+#include <glad/glad.h>
+
+#include <limits>
+
+inline constexpr uint32_t CLUSTERING_GROUP_SIZE = 64; // must match LightClustering.comp
+
+static_assert(NUM_CLUSTERS % CLUSTERING_GROUP_SIZE == 0, "every invocation must have a cluster");
+
+static ComputeShader g_ClusteringShader;
+
+static unsigned int g_ClusterLightsBuffer = std::numeric_limits<unsigned int>::max();
+static unsigned int g_ClusterLightIndicesBuffer = std::numeric_limits<unsigned int>::max();
+
+void InitLightClustering()
+{
+    g_ClusteringShader.Load("Resources/Shaders/LightClustering.comp");
+
+    unsigned int buffers[2];
+    glGenBuffers(2, buffers);
+
+    g_ClusterLightsBuffer = buffers[0];
+    g_ClusterLightIndicesBuffer = buffers[1];
+
+    // written only by the compute shader
+    BindBuffer(GL_SHADER_STORAGE_BUFFER, g_ClusterLightsBuffer);
+    glBufferStorage(GL_SHADER_STORAGE_BUFFER, NUM_CLUSTERS * 2 * sizeof(uint32_t), nullptr, 0);
+    BindBuffer(GL_SHADER_STORAGE_BUFFER, g_ClusterLightIndicesBuffer);
+    glBufferStorage(GL_SHADER_STORAGE_BUFFER, NUM_CLUSTERS * MAX_LIGHTS_PER_CLUSTER * sizeof(uint32_t), nullptr, 0);
+    BindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+void DeinitLightClustering()
+{
+    unsigned int buffers[2] = {g_ClusterLightsBuffer, g_ClusterLightIndicesBuffer};
+    DeleteBuffers(2, buffers);
+
+    g_ClusteringShader.Unload();
+}
+
+void AssignLightsToClusters()
+{
+    g_ClusteringShader.Bind();
+
+    BindBufferBase(GL_SHADER_STORAGE_BUFFER, CLUSTER_LIGHTS_BINDING, g_ClusterLightsBuffer);
+    BindBufferBase(GL_SHADER_STORAGE_BUFFER, CLUSTER_LIGHT_INDICES_BINDING, g_ClusterLightIndicesBuffer);
+
+    // one invocation for each cluster
+    g_ClusteringShader.Dispatch(NUM_CLUSTERS / CLUSTERING_GROUP_SIZE, 1, 1);
+
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+}
\ No newline at end of file
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstdint>
+
+// froxel grid of the camera view: screen tiles, and depth slices spaced exponentially between the near and far planes
+inline constexpr uint32_t CLUSTER_GRID_X = 16;
+inline constexpr uint32_t CLUSTER_GRID_Y = 9;
+inline constexpr uint32_t CLUSTER_GRID_Z = 24;
+inline constexpr uint32_t NUM_CLUSTERS = CLUSTER_GRID_X * CLUSTER_GRID_Y * CLUSTER_GRID_Z;
+inline constexpr uint32_t MAX_LIGHTS_PER_CLUSTER = 128; // point and spot lights together, the ones past it are dropped
+
+// storage buffer bindings, after the glyphs of the text
+inline constexpr unsigned int CLUSTER_LIGHTS_BINDING = 11; // number of point and spot lights of each cluster
+inline constexpr unsigned int CLUSTER_LIGHT_INDICES_BINDING = 12; // MAX_LIGHTS_PER_CLUSTER slots for each cluster, the point lights first
+
+extern void InitLightClustering();
+extern void DeinitLightClustering();
+
+/**
+ * \brief Find the point and spot lights reaching each cluster with a compute shader and bind the cluster buffers for the deferred pass.
+ * Call after the light blocks and the camera block of the frame are written
+ */
+extern void AssignLightsToClusters();
\ No newline at end of file
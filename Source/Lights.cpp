@@ -1,6 +1,12 @@
 #include <Lights.hpp>
 #include <ResourceManager.hpp>
 #include <Globals.hpp>
+#include <UniformBlocks.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+static constexpr float SHADOW_CASCADE_BIAS_TEXELS = 2.0f; // depth bias of the cascades, in the size of their texels
 
 static unsigned int g_PointLightsCount = 0;
 static unsigned int g_SpotLightsCount = 0;
@@ -12,78 +18,213 @@ void ResetLightsCounters()
     g_SpotLightsCount = 0;
     g_DirectionalLightsCount = 0;
 
-    GetDeferredShader().Bind();
-    GetDeferredShader().SetUniform1i("numPointLights", 0);
-    GetDeferredShader().SetUniform1i("numSpotLights", 0);
-    GetDeferredShader().SetUniform1i("numDirectionalLights", 0);
+    BeginLightBlocks();
+}
+
+float GetLightRange(const glm::vec3& color)
+{
+    float max_component = std::max(color.x, std::max(color.y, color.z));
+
+    return std::sqrt(std::max(max_component, 0.0f) / LIGHT_RADIANCE_CUTOFF);
 }
 
 void SetPointLight(const PointLight& pl)
 {
-    if(g_PointLightsCount < MAX_LIGHTS){
-        GetDeferredShader().Bind();
-        GetDeferredShader().SetUniform3fv("pointLights[" + std::to_string(g_PointLightsCount) + "].position", pl.pos);
-        GetDeferredShader().SetUniform3fv("pointLights[" + std::to_string(g_PointLightsCount) + "].color", pl.color);
-        for(unsigned int i = 0; i < MAX_LIGHTS; i++){
-            GetDeferredShader().SetUniform1i("pointLights[" + std::to_string(i) + "].shadowMapIndex", pl.shadowMap.GetShadowMapIndex());
-        }
-        g_PointLightsCount++;
-        GetDeferredShader().SetUniform1i("numPointLights", g_PointLightsCount);
-    }
+    PointLightData data = {};
+    data.position = glm::vec4(pl.pos, 1.0f);
+    data.color = glm::vec4(pl.color, 1.0f);
+    data.shadowMapIndex = (int)pl.shadowMap.GetShadowMapIndex();
+    data.range = GetLightRange(pl.color);
+
+    WritePointLight(g_PointLightsCount++, data);
 }
 
 void SetDirectionalLight(const DirectionalLight& dl)
 {
-    if(g_DirectionalLightsCount < MAX_LIGHTS){
-        GetDeferredShader().Bind();
-        GetDeferredShader().SetUniform3fv("directionalLights[" + std::to_string(g_DirectionalLightsCount) + "].direction", dl.dir);
-        GetDeferredShader().SetUniform3fv("directionalLights[" + std::to_string(g_DirectionalLightsCount) + "].color", dl.color);
-        GetDeferredShader().SetUniform1i("directionalLights[" + std::to_string(g_DirectionalLightsCount) + "].shadowMapIndex", dl.shadowMap.GetShadowMapIndex());
-        GetDeferredShader().SetUniformMat4fv("directionalLights[" + std::to_string(g_DirectionalLightsCount) + "].lightSpaceMatrix", dl.lightSpaceMatrix);
-        g_DirectionalLightsCount++;
-        GetDeferredShader().SetUniform1i("numDirectionalLights", g_DirectionalLightsCount);
+    DirectionalLightData data = {};
+    data.direction = glm::vec4(dl.dir, 0.0f);
+    data.color = glm::vec4(dl.color, 1.0f);
+    data.shadowMapIndex = (int)dl.shadowMap.GetShadowMapIndex();
+
+    for(unsigned int i = 0; i < SHADOW_CASCADE_COUNT; i++){
+        float radius = dl.cascadeSpheres[i].w;
+
+        data.lightSpaceMatrices[i] = dl.lightSpaceMatrix[i];
+        data.cascadeSplits[i] = dl.cascadeSplits[i];
+        // the depth of a cascade spans its sphere and the casters in front of it
+        data.cascadeBiases[i] = SHADOW_CASCADE_BIAS_TEXELS * (2.0f * radius / SHADOW_CASCADE_SIZE) / (2.0f * radius + DIRECTIONAL_LIGHT_SHADOW_FAR);
     }
+
+    WriteDirectionalLight(g_DirectionalLightsCount++, data);
 }
 
 void SetSpotLight(const SpotLight& dl)
 {
-    if(g_SpotLightsCount < MAX_LIGHTS){
-        GetDeferredShader().Bind();
-        GetDeferredShader().SetUniform3fv("spotLights[" + std::to_string(g_SpotLightsCount) + "].position", dl.pos);
-        GetDeferredShader().SetUniform3fv("spotLights[" + std::to_string(g_SpotLightsCount) + "].direction", dl.dir);
-        GetDeferredShader().SetUniform3fv("spotLights[" + std::to_string(g_SpotLightsCount) + "].color", dl.color);
-        GetDeferredShader().SetUniform1f("spotLights[" + std::to_string(g_SpotLightsCount) + "].cutOff", dl.cutOff);
-        GetDeferredShader().SetUniform1f("spotLights[" + std::to_string(g_SpotLightsCount) + "].outerCutOff", dl.outerCutOff);
-        GetDeferredShader().SetUniform1i("spotLights[" + std::to_string(g_SpotLightsCount) + "].shadowMapIndex", dl.shadowMap.GetShadowMapIndex());
-        GetDeferredShader().SetUniformMat4fv("spotLights[" + std::to_string(g_SpotLightsCount) + "].lightSpaceMatrix", dl.lightSpaceMatrix);
-        g_SpotLightsCount++;
-        GetDeferredShader().SetUniform1i("numSpotLights", g_SpotLightsCount);
+    SpotLightData data = {};
+    data.position = glm::vec4(dl.pos, 1.0f);
+    data.direction = glm::vec4(dl.dir, 0.0f);
+    data.color = glm::vec4(dl.color, 1.0f);
+    data.lightSpaceMatrix = dl.lightSpaceMatrix;
+    data.cutOff = dl.cutOff;
+    data.outerCutOff = dl.outerCutOff;
+    data.shadowMapIndex = (int)dl.shadowMap.GetShadowMapIndex();
+    data.range = GetLightRange(dl.color);
+
+    WriteSpotLight(g_SpotLightsCount++, data);
+}
+
+void UploadLightsCounters()
+{
+    EndLightBlocks(g_PointLightsCount, g_DirectionalLightsCount, g_SpotLightsCount);
+}
+
+void UpdateShadowCascades(DirectionalLight& light, const glm::mat4& view, const glm::mat4& projection)
+{
+    // the corners of the near plane in view space. the corners at distance d are on the same rays, scaled by d / near_plane
+    glm::mat4 inverse_projection = glm::inverse(projection);
+    glm::vec3 near_corners[4];
+
+    for(int i = 0; i < 4; i++){
+        glm::vec4 corner = inverse_projection * glm::vec4((i & 1) ? 1.0f : -1.0f, (i & 2) ? 1.0f : -1.0f, -1.0f, 1.0f);
+        near_corners[i] = glm::vec3(corner) / corner.w;
+    }
+
+    glm::vec4 far_corner = inverse_projection * glm::vec4(1.0f, 1.0f, 1.0f, 1.0f);
+    float near_plane = -near_corners[0].z;
+    float shadow_distance = std::min(-far_corner.z / far_corner.w, DIRECTIONAL_LIGHT_SHADOW_DISTANCE);
+
+    // practical split scheme: the logarithmic splits keep the texels per pixel even, the uniform ones keep the first cascade from being tiny
+    float splits[SHADOW_CASCADE_COUNT + 1];
+    splits[0] = near_plane;
+
+    for(unsigned int i = 1; i <= SHADOW_CASCADE_COUNT; i++){
+        float t = (float)i / SHADOW_CASCADE_COUNT;
+        float log_split = near_plane * std::pow(shadow_distance / near_plane, t);
+        float uniform_split = near_plane + (shadow_distance - near_plane) * t;
+        splits[i] = SHADOW_CASCADE_SPLIT_LAMBDA * log_split + (1.0f - SHADOW_CASCADE_SPLIT_LAMBDA) * uniform_split;
     }
+
+    glm::vec3 dir = glm::normalize(light.dir);
+    glm::vec3 up = std::abs(dir.y) > 0.99f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+    glm::mat4 light_view = glm::lookAt(glm::vec3(0.0f), dir, up);
+    glm::mat4 inverse_light_view = glm::inverse(light_view);
+    glm::mat4 inverse_view = glm::inverse(view);
+
+    for(unsigned int i = 0; i < SHADOW_CASCADE_COUNT; i++){
+        glm::vec3 corners[8];
+        glm::vec3 center(0.0f);
+
+        for(int j = 0; j < 4; j++){
+            corners[j] = near_corners[j] * (splits[i] / near_plane);
+            corners[j + 4] = near_corners[j] * (splits[i + 1] / near_plane);
+            center += corners[j] + corners[j + 4];
+        }
+
+        // fitted in view space, so the sphere moves with the camera but doesn't change when it turns
+        center /= 8.0f;
+        float radius = 0.0f;
+
+        for(const glm::vec3& corner : corners){
+            radius = std::max(radius, glm::length(corner - center));
+        }
+
+        // rounded up, or the rounding errors would change the size of the texels from frame to frame
+        radius = std::ceil(radius * 16.0f) / 16.0f;
+
+        // moving the projection by whole texels keeps the texels of the shadows on the same spots of the world
+        float texel = 2.0f * radius / SHADOW_CASCADE_SIZE;
+        glm::vec3 light_center = glm::vec3(light_view * inverse_view * glm::vec4(center, 1.0f));
+        light_center = glm::floor(light_center / texel) * texel;
+
+        // the near plane is pulled towards the light, so the casters outside of the sphere still cast into it
+        glm::mat4 light_projection = glm::ortho(light_center.x - radius, light_center.x + radius, light_center.y - radius, light_center.y + radius,
+                                                -light_center.z - radius - DIRECTIONAL_LIGHT_SHADOW_FAR, -light_center.z + radius);
+
+        light.lightSpaceMatrix[i] = light_projection * light_view;
+        light.cascadeSpheres[i] = glm::vec4(glm::vec3(inverse_light_view * glm::vec4(light_center, 1.0f)), radius);
+        light.cascadeSplits[i] = splits[i + 1];
+
+        // the camera projection with the near and far planes of the slice (a glm::perspective matrix)
+        glm::mat4 slice_projection = projection;
+        slice_projection[2][2] = -(splits[i + 1] + splits[i]) / (splits[i + 1] - splits[i]);
+        slice_projection[3][2] = -2.0f * splits[i + 1] * splits[i] / (splits[i + 1] - splits[i]);
+        ExtractFrustum(light.cascadeReceivers[i], slice_projection * view);
+    }
+}
+
+ShadowCasterLight GetShadowCasterLight(const DirectionalLight& light, unsigned int cascade)
+{
+    // the eye is on the near plane of the cascade, the shadows reach its far plane
+    glm::vec3 dir = glm::normalize(light.dir);
+    glm::vec3 center = glm::vec3(light.cascadeSpheres[cascade]);
+    float radius = light.cascadeSpheres[cascade].w;
+
+    return {center - dir * (radius + DIRECTIONAL_LIGHT_SHADOW_FAR), dir, 2.0f * radius + DIRECTIONAL_LIGHT_SHADOW_FAR, true};
 }
 
-void DrawShadowMap(const DirectionalLight& light)
+ShadowCasterLight GetShadowCasterLight(const PointLight& light)
 {
-    light.shadowMap.Bind(); 
-    DrawModelsShadows(GetShadowMapShader(), light.lightSpaceMatrix);
-    light.shadowMap.Unbind();
+    return {light.pos, glm::vec3(0.0f), POINT_LIGHT_SHADOW_FAR, false};
 }
 
-void DrawShadowMap(const SpotLight& light)
+ShadowCasterLight GetShadowCasterLight(const SpotLight& light)
 {
-    light.shadowMap.Bind();
-    DrawModelsShadows(GetShadowMapShader(), light.lightSpaceMatrix);
-    light.shadowMap.Unbind();
+    return {light.pos, light.dir, SPOT_LIGHT_SHADOW_FAR, false};
 }
 
-void DrawShadowMap(const PointLight& light)
+uint32_t DrawShadowMap(const DirectionalLight& light, bool time_cascades)
 {
+    if(!light.shadowMap.HasShadowMap()){ // past MAX_SHADOWED_LIGHTS
+        return 0;
+    }
+
+    uint32_t casters = 0;
+
+    if(time_cascades){
+        BeginShadowCascadeTimers();
+    }
+
+    // each cascade is culled with its own frustum
+    for(unsigned int i = 0; i < SHADOW_CASCADE_COUNT; i++){
+        if(time_cascades){
+            TimeShadowCascade(i);
+        }
+
+        casters += DrawModelsShadows(GetShadowMapShader(), light.lightSpaceMatrix[i], GetShadowCasterLight(light, i), light.shadowMap.GetCascadeLayer(i));
+    }
+
+    if(time_cascades){
+        EndShadowCascadeTimers();
+    }
+
+    return casters;
+}
+
+uint32_t DrawShadowMap(const SpotLight& light)
+{
+    if(!light.shadowMap.HasShadowMap()){ // past MAX_SHADOWED_LIGHTS
+        return 0;
+    }
+
+    return DrawModelsShadows(GetShadowMapShader(), light.lightSpaceMatrix, GetShadowCasterLight(light), light.shadowMap.GetLayer());
+}
+
+uint32_t DrawShadowMap(const PointLight& light)
+{
+    if(!light.shadowMap.HasShadowMap()){ // past MAX_SHADOWED_LIGHTS
+        return 0;
+    }
+
+    ShadowCasterLight caster_light = GetShadowCasterLight(light);
+    uint32_t casters = 0;
+
     GetPointLightShadowMapShader().Bind();
     GetPointLightShadowMapShader().SetUniform3fv("lightPos", light.pos);
 
+    // each face is culled with its own frustum
     for(int i = 0; i < 6; i++){
-        light.shadowMap.Bind(i);
-        DrawModelsShadows(GetPointLightShadowMapShader(), light.lightSpaceMatrix[i]);
+        casters += DrawModelsShadows(GetPointLightShadowMapShader(), light.lightSpaceMatrix[i], caster_light, light.shadowMap.GetLayer(i));
     }
 
-    light.shadowMap.Unbind();
+    return casters;
 }
\ No newline at end of file
@@ -5,6 +5,18 @@
 
 #include <Shader.hpp>
 #include <ShadowMap.hpp>
+#include <Frustum.hpp>
+
+// far planes of the shadow projections, also how far the shadows can reach
+inline constexpr float POINT_LIGHT_SHADOW_FAR = 25.0f;
+inline constexpr float SPOT_LIGHT_SHADOW_FAR = 20.0f;
+inline constexpr float DIRECTIONAL_LIGHT_SHADOW_FAR = 50.0f; // how far from the cascades the casters can be
+// view distance covered by the cascades of the directional lights, farther fragments are lit without shadows
+inline constexpr float DIRECTIONAL_LIGHT_SHADOW_DISTANCE = 40.0f;
+// blend of the logarithmic and uniform cascade splits, 1 is fully logarithmic
+inline constexpr float SHADOW_CASCADE_SPLIT_LAMBDA = 0.75f;
+// radiance where the point and spot lights are cut off, their light is windowed to reach 0 there
+inline constexpr float LIGHT_RADIANCE_CUTOFF = 0.02f;
 
 struct PointLight{
     glm::vec3 pos;
@@ -16,12 +28,12 @@ struct PointLight{
     PointLight(const glm::vec3& pos, const glm::vec3& color)
         : pos(pos), color(color)
     {
-        lightSpaceMatrix[0] = glm::perspective(glm::radians(90.0f), 1.0f, 0.1f, 25.0f) * glm::lookAt(pos, pos + glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f));
-        lightSpaceMatrix[1] = glm::perspective(glm::radians(90.0f), 1.0f, 0.1f, 25.0f) * glm::lookAt(pos, pos + glm::vec3(-1.0f, 0.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f));
-        lightSpaceMatrix[2] = glm::perspective(glm::radians(90.0f), 1.0f, 0.1f, 25.0f) * glm::lookAt(pos, pos + glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f));
-        lightSpaceMatrix[3] = glm::perspective(glm::radians(90.0f), 1.0f, 0.1f, 25.0f) * glm::lookAt(pos, pos + glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(0.0f, 0.0f, -1.0f));
-        lightSpaceMatrix[4] = glm::perspective(glm::radians(90.0f), 1.0f, 0.1f, 25.0f) * glm::lookAt(pos, pos + glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, -1.0f, 0.0f));
-        lightSpaceMatrix[5] = glm::perspective(glm::radians(90.0f), 1.0f, 0.1f, 25.0f) * glm::lookAt(pos, pos + glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, -1.0f, 0.0f));
+        lightSpaceMatrix[0] = glm::perspective(glm::radians(90.0f), 1.0f, 0.1f, POINT_LIGHT_SHADOW_FAR) * glm::lookAt(pos, pos + glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f));
+        lightSpaceMatrix[1] = glm::perspective(glm::radians(90.0f), 1.0f, 0.1f, POINT_LIGHT_SHADOW_FAR) * glm::lookAt(pos, pos + glm::vec3(-1.0f, 0.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f));
+        lightSpaceMatrix[2] = glm::perspective(glm::radians(90.0f), 1.0f, 0.1f, POINT_LIGHT_SHADOW_FAR) * glm::lookAt(pos, pos + glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+        lightSpaceMatrix[3] = glm::perspective(glm::radians(90.0f), 1.0f, 0.1f, POINT_LIGHT_SHADOW_FAR) * glm::lookAt(pos, pos + glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(0.0f, 0.0f, -1.0f));
+        lightSpaceMatrix[4] = glm::perspective(glm::radians(90.0f), 1.0f, 0.1f, POINT_LIGHT_SHADOW_FAR) * glm::lookAt(pos, pos + glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, -1.0f, 0.0f));
+        lightSpaceMatrix[5] = glm::perspective(glm::radians(90.0f), 1.0f, 0.1f, POINT_LIGHT_SHADOW_FAR) * glm::lookAt(pos, pos + glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, -1.0f, 0.0f));
     
         shadowMap.Init();
     }
@@ -35,18 +47,22 @@ struct PointLight{
     }
 };
 
+/**
+ * \brief The cascades follow the camera, their matrices are set by UpdateShadowCascades every frame
+ */
 struct DirectionalLight{
     glm::vec3 dir;
     glm::vec3 color;
-    ShadowMap shadowMap;
-    glm::mat4 lightSpaceMatrix;
+    ShadowMap shadowMap; // one layer, a quadrant for each cascade
+    glm::mat4 lightSpaceMatrix[SHADOW_CASCADE_COUNT];
+    glm::vec4 cascadeSpheres[SHADOW_CASCADE_COUNT] = {}; // xyz center, w radius of the bounds of each cascade, snapped to its texels
+    float cascadeSplits[SHADOW_CASCADE_COUNT] = {}; // view distance where each cascade ends
+    Frustum cascadeReceivers[SHADOW_CASCADE_COUNT]; // the slice of the camera frustum each cascade is sampled in
 
     DirectionalLight() = default;
     DirectionalLight(const glm::vec3& dir, const glm::vec3& color)
         : dir(dir), color(color)
     {
-        lightSpaceMatrix = glm::ortho(-40.0f, 40.0f, -40.0f, 40.0f, 1.0f, 50.0f) * glm::lookAt(-dir * 20.0f, glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
-    
         shadowMap.Init();
     }
 
@@ -72,7 +88,7 @@ struct SpotLight{
     SpotLight(const glm::vec3& pos, const glm::vec3& dir, const glm::vec3& color, float cutOff, float outerCutOff)
         : pos(pos), dir(dir), color(color), cutOff(glm::cos(glm::radians(cutOff))), outerCutOff(glm::cos(glm::radians(outerCutOff)))
     {
-        lightSpaceMatrix = glm::perspective(glm::radians(outerCutOff * 2), 1.0f, 0.1f, 20.0f) * glm::lookAt(pos, pos + dir, glm::vec3(0.0f, 1.0f, 0.0f));
+        lightSpaceMatrix = glm::perspective(glm::radians(outerCutOff * 2), 1.0f, 0.1f, SPOT_LIGHT_SHADOW_FAR) * glm::lookAt(pos, pos + dir, glm::vec3(0.0f, 1.0f, 0.0f));
     
         shadowMap.Init();
     }
@@ -86,11 +102,45 @@ struct SpotLight{
     }
 };
 
+/**
+ * \brief Distance where the inverse square falloff of the brightest channel of the color drops to LIGHT_RADIANCE_CUTOFF.
+ * The light clustering assigns the light only to the clusters within it
+ */
+extern float GetLightRange(const glm::vec3& color);
+
+/**
+ * \brief Store the light in the next slot of its light block. The slot is uploaded only if the light changed
+ */
 extern void SetPointLight(const PointLight& pl);
 extern void SetDirectionalLight(const DirectionalLight& dl);
 extern void SetSpotLight(const SpotLight& dl);
+/**
+ * \brief Start a new frame of lights, call before the Set*Light functions
+ */
 extern void ResetLightsCounters();
-
-extern void DrawShadowMap(const DirectionalLight& light);
-extern void DrawShadowMap(const PointLight& light);
-extern void DrawShadowMap(const SpotLight& light);
\ No newline at end of file
+/**
+ * \brief Store the number of lights set since ResetLightsCounters and bind the light blocks
+ */
+extern void UploadLightsCounters();
+
+/**
+ * \brief Split the view distance up to DIRECTIONAL_LIGHT_SHADOW_DISTANCE between the cascades and fit an orthographic projection to each slice of the camera frustum.
+ * Each projection bounds a sphere around its slice, so its size doesn't change when the camera turns, and moves in whole texels, so the shadow edges don't shimmer
+ * when the camera moves. Call once per frame before the shadow maps are culled and drawn
+ */
+extern void UpdateShadowCascades(DirectionalLight& light, const glm::mat4& view, const glm::mat4& projection);
+
+/**
+ * \brief The light as seen by the shadow caster culling
+ */
+extern ShadowCasterLight GetShadowCasterLight(const DirectionalLight& light, unsigned int cascade);
+extern ShadowCasterLight GetShadowCasterLight(const PointLight& light);
+extern ShadowCasterLight GetShadowCasterLight(const SpotLight& light);
+
+/**
+ * \brief Draw the shadow casters of the light into its shadow map. With the shadow caching only the maps whose light or casters changed are drawn
+ * \return the number of casters drawn, summed over the six faces for point lights and over the cascades for directional lights
+ */
+extern uint32_t DrawShadowMap(const DirectionalLight& light, bool time_cascades = false);
+extern uint32_t DrawShadowMap(const PointLight& light);
+extern uint32_t DrawShadowMap(const SpotLight& light);
\ No newline at end of file
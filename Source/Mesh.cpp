@@ -1,10 +1,16 @@
 #include <Mesh.hpp>
 #include <Globals.hpp>
 #include <ResourceManager.hpp>
+#include <MeshSimplifier.hpp>
 
 #include <glad/glad.h>
 #include <string>
 
+static constexpr UniformHandle HAS_TEXTURES[NUM_TEXTURE_TYPES] = {
+    UniformHandle::Indexed("hasTextures[", ALBEDO), UniformHandle::Indexed("hasTextures[", NORMAL), UniformHandle::Indexed("hasTextures[", ROUGHNESS),
+    UniformHandle::Indexed("hasTextures[", METALLIC), UniformHandle::Indexed("hasTextures[", AO)
+};
+
 Mesh::Mesh(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices, const std::vector<uint32_t>& textures, const AABB& aabb)
 {
     InitMesh(vertices, indices, textures, aabb);
@@ -22,17 +28,7 @@ void Mesh::InitMesh(const std::vector<Vertex>& vertices, const std::vector<unsig
     m_Textures = textures;
     m_AABB = aabb;
 
-    m_GPUBuffer.Init(vertices.size(), sizeof(Vertex), indices.size());
-
-    m_GPUBuffer.SetData(0, (void*)vertices.data(), vertices.size(), sizeof(Vertex));
-    m_GPUBuffer.SetIndices(indices.data(), indices.size());
-
-    m_GPUBuffer.AddAttribute(3, GL_FLOAT, sizeof(Vertex));
-    m_GPUBuffer.AddAttribute(3, GL_FLOAT, sizeof(Vertex));
-    m_GPUBuffer.AddAttribute(2, GL_FLOAT, sizeof(Vertex));
-    m_GPUBuffer.AddAttribute(3, GL_FLOAT, sizeof(Vertex));
-    m_GPUBuffer.AddAttribute(4, GL_INT, sizeof(Vertex));
-    m_GPUBuffer.AddAttribute(4, GL_FLOAT, sizeof(Vertex));
+    m_Geometry = AllocateGeometry(vertices, GenerateLODs(vertices, indices, MAX_MESH_LODS));
 }
 
 void Mesh::InitMesh(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices, const AABB& aabb)
@@ -41,22 +37,12 @@ void Mesh::InitMesh(const std::vector<Vertex>& vertices, const std::vector<unsig
     m_Indices = indices;
     m_AABB = aabb;
 
-    m_GPUBuffer.Init(vertices.size(), sizeof(Vertex), indices.size());
-
-    m_GPUBuffer.SetData(0, (void*)vertices.data(), vertices.size(), sizeof(Vertex));
-    m_GPUBuffer.SetIndices(indices.data(), indices.size());
-
-    m_GPUBuffer.AddAttribute(3, GL_FLOAT, sizeof(Vertex));
-    m_GPUBuffer.AddAttribute(3, GL_FLOAT, sizeof(Vertex));
-    m_GPUBuffer.AddAttribute(2, GL_FLOAT, sizeof(Vertex));
-    m_GPUBuffer.AddAttribute(3, GL_FLOAT, sizeof(Vertex));
-    m_GPUBuffer.AddAttribute(4, GL_INT, sizeof(Vertex));
-    m_GPUBuffer.AddAttribute(4, GL_FLOAT, sizeof(Vertex));
+    m_Geometry = AllocateGeometry(vertices, GenerateLODs(vertices, indices, MAX_MESH_LODS));
 }
 
 void Mesh::Free()
 {
-    m_GPUBuffer.Free();
+    FreeGeometry(m_Geometry);
 }
 
 void Mesh::SetMaterial(const Material& material)
@@ -64,73 +50,74 @@ void Mesh::SetMaterial(const Material& material)
     m_Textures = material.GetTextures();
 }
 
-void Mesh::Draw(Shader& shader, glm::mat4 view, glm::mat4 model) const
+void Mesh::BindTextures(Shader& shader) const
 {
-    OBB obb = OBBFromAABB(m_AABB, model); // Get the OBB so the model can also be rotated
-
-    if(!OBBInFrustum(g_Frustum, obb.center, obb.extents, obb.rotation)){
-        #ifdef DEBUG
-            culled++;
-        #endif
-        return;
-    } 
-
-    #ifdef DEBUG
-        drawn++;
-    #endif
-    
-    shader.Bind();
-
     for(int i = 0; i < m_Textures.size(); i++){
-        std::string number;
-        std::string name = GetTexture(m_Textures[i])->GetType();
+        Texture* texture = GetTexture(m_Textures[i]);
 
-        shader.SetUniform1i(name.c_str(), i);
+        shader.SetUniform1i(texture->GetTypeUniform(), i);
 
-        GetTexture(m_Textures[i])->Bind(i);
+        texture->Bind(i);
     }
 
     for(int i = 0; i < NUM_TEXTURE_TYPES; i++){
         if(i == 4){ // AO not used. skip it so opengl doesn't complain
             continue;
         }
-        shader.SetUniform1i(("hasTextures[" + std::to_string(i) + "]"), m_HasTexture[i]);
+        shader.SetUniform1i(HAS_TEXTURES[i], m_HasTexture[i]);
     }
+}
 
-    m_GPUBuffer.BindVAO();
-    m_GPUBuffer.BindEBO();
-    m_GPUBuffer.BindVBO();
+void Mesh::BindInstanceBuffer(unsigned int instance_buffer, uint32_t first_instance)
+{
+    glBindVertexBuffer(INSTANCE_BUFFER_BINDING, instance_buffer, first_instance * sizeof(InstanceData), sizeof(InstanceData));
+}
 
-    shader.SetUniformMat4fv("view", view, 1);
-    shader.SetUniformMat4fv("model", model, 1);
-    
-    glDrawElements(GL_TRIANGLES, m_Indices.size(), GL_UNSIGNED_INT, 0);
+void Mesh::BindGeometry() const
+{
+    BindGeometryChunk(m_Geometry.chunk);
 }
 
-void Mesh::DrawShadows(Shader& shader, glm::mat4 light_space_matrix, glm::mat4 model) const
+void Mesh::DrawInstances(unsigned int instance_buffer, uint32_t first_instance, uint32_t instance_count, uint32_t lod) const
 {
-    shader.Bind();
+    BindInstanceBuffer(instance_buffer, first_instance);
 
-    m_GPUBuffer.BindVAO();
-    m_GPUBuffer.BindEBO();
-    m_GPUBuffer.BindVBO();
+    const GeometryLOD& geometry_lod = GetLOD(lod);
+    glDrawElementsInstancedBaseVertex(GL_TRIANGLES, geometry_lod.index_count, GL_UNSIGNED_INT, (const void*)(geometry_lod.first_index * sizeof(unsigned int)), instance_count, m_Geometry.base_vertex);
+}
+
+uint64_t Mesh::GetMaterialHash() const
+{
+    // FNV-1a over the texture ids and the flags
+    uint64_t hash = 14695981039346656037ull;
 
-    shader.SetUniformMat4fv("lightSpaceMatrix", light_space_matrix, 1);
-    shader.SetUniformMat4fv("model", model, 1);
+    for(uint32_t texture : m_Textures){
+        hash = (hash ^ texture) * 1099511628211ull;
+    }
 
-    glDrawElements(GL_TRIANGLES, m_Indices.size(), GL_UNSIGNED_INT, 0);
+    for(int i = 0; i < NUM_TEXTURE_TYPES; i++){
+        hash = (hash ^ (uint64_t)m_HasTexture[i]) * 1099511628211ull;
+    }
+
+    return hash;
 }
 
-void Mesh::DrawDepth(Shader& shader, glm::mat4 view, glm::mat4 model) const
+void Mesh::DrawIndirect(Shader& shader, unsigned int instance_buffer, size_t command_offset) const
 {
     shader.Bind();
 
-    m_GPUBuffer.BindVAO();
-    m_GPUBuffer.BindEBO();
-    m_GPUBuffer.BindVBO();
+    BindTextures(shader);
+
+    BindGeometryChunk(m_Geometry.chunk);
+    BindInstanceBuffer(instance_buffer, 0); // the base instance of the command selects the first instance, its firstIndex and baseVertex the range of the arena
 
-    shader.SetUniformMat4fv("view", view, 1);
-    shader.SetUniformMat4fv("model", model, 1);
+    glDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, (const void*)command_offset);
+}
+
+void Mesh::MultiDrawIndirect(uint32_t chunk, unsigned int instance_buffer, size_t command_offset, uint32_t draw_count)
+{
+    BindGeometryChunk(chunk);
+    BindInstanceBuffer(instance_buffer, 0);
 
-    glDrawElements(GL_TRIANGLES, m_Indices.size(), GL_UNSIGNED_INT, 0);
+    glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, (const void*)command_offset, draw_count, 0);
 }
\ No newline at end of file
@@ -1,18 +1,25 @@
 #pragma once
 
 #include <Frustum.hpp>
-#include <GPUBuffer.hpp>
+#include <GeometryArena.hpp>
 #include <Texture.hpp>
 #include <Shader.hpp>
 #include <BoundingBox.hpp>
 #include <Material.hpp>
 
 #include <vector>
+#include <algorithm>
 #include <glm.hpp>
 
 inline constexpr unsigned int MAX_BONE_INFLUENCE = 4;
 inline constexpr unsigned int MAX_BONES = 100;
 
+// per instance vertex attributes, read from the buffer bound to INSTANCE_BUFFER_BINDING
+inline constexpr unsigned int INSTANCE_MODEL_LOCATION = 6; // mat4, locations 6 to 9
+inline constexpr unsigned int INSTANCE_NORMAL_LOCATION = 10; // mat3, locations 10 to 12
+inline constexpr unsigned int INSTANCE_LAYER_LOCATION = 13; // float, the view of a layered shadow pass the instance is drawn into
+inline constexpr unsigned int INSTANCE_BUFFER_BINDING = 6;
+
 enum TextureType{
     ALBEDO,
     NORMAL,
@@ -54,6 +61,15 @@ struct Vertex{
     }
 };
 
+/**
+ * \brief The data of one instance in an instance buffer. The normal matrix is stored in a mat4 so the layout is the same in std430 buffers,
+ * its fourth column isn't part of the matrix: the render queues store the shadow layer of the instance in its x
+ */
+struct InstanceData{
+    glm::mat4 model;
+    glm::mat4 normal;
+};
+
 class Mesh{
 public:
     Mesh() = default;
@@ -67,14 +83,43 @@ public:
 
     void SetMaterial(const Material& material);
 
-    void Draw(Shader& shader, glm::mat4 view, glm::mat4 model) const;
-    void DrawShadows(Shader& shader, glm::mat4 light_space_matrix, glm::mat4 model) const;
-    void DrawDepth(Shader& shader, glm::mat4 view, glm::mat4 model) const;
+    /**
+     * \brief Bind the textures and set the material uniforms of the bound shader
+     */
+    void BindTextures(Shader& shader) const;
+    void BindGeometry() const;
+    /**
+     * \brief Draw instance_count instances, reading their InstanceData from instance_buffer starting at first_instance.
+     * Uses the bound shader, textures and geometry
+     * \param lod the level of detail, clamped to the coarsest the mesh has
+     */
+    void DrawInstances(unsigned int instance_buffer, uint32_t first_instance, uint32_t instance_count, uint32_t lod = 0) const;
+
+
+    /**
+     * \brief Draw the instances listed by a DrawElementsIndirectCommand. The indirect buffer must be bound
+     * \param instance_buffer the InstanceData of the instances, indexed with the base instance of the command
+     * \param command_offset offset in bytes of the command in the indirect buffer
+     */
+    void DrawIndirect(Shader& shader, unsigned int instance_buffer, size_t command_offset) const;
+    /**
+     * \brief Draw consecutive DrawElementsIndirectCommands of meshes stored in the same geometry chunk with a single call.
+     * Uses the bound shader, binds no textures. The indirect buffer must be bound
+     * \param command_offset offset in bytes of the first command in the indirect buffer
+     */
+    static void MultiDrawIndirect(uint32_t chunk, unsigned int instance_buffer, size_t command_offset, uint32_t draw_count);
 
     inline const std::vector<Vertex>& GetVertices() const { return m_Vertices; }
     inline const std::vector<unsigned int>& GetIndices() const { return m_Indices; }
     inline const std::vector<uint32_t>& GetTextures() const { return m_Textures; }
     inline const AABB& GetAABB() const { return m_AABB; }
+    inline const GeometryRange& GetGeometry() const { return m_Geometry; }
+    inline uint32_t GetLODCount() const { return std::max(m_Geometry.lod_count, 1u); }
+    inline const GeometryLOD& GetLOD(uint32_t lod) const { return m_Geometry.lods[std::min(lod, GetLODCount() - 1)]; }
+    /**
+     * \brief Same value for meshes that use the same textures
+     */
+    uint64_t GetMaterialHash() const;
 
     inline void SetVertices(const std::vector<Vertex>& vertices) { m_Vertices = vertices; }
     inline void SetIndices(const std::vector<unsigned int>& indices) { m_Indices = indices; }
@@ -84,11 +129,12 @@ public:
     inline void SetHasTexture(int index, bool value) { m_HasTexture[index] = value; }
 
 private:
+    static void BindInstanceBuffer(unsigned int instance_buffer, uint32_t first_instance);
 
     std::vector<Vertex> m_Vertices;
     std::vector<unsigned int> m_Indices;
     std::vector<uint32_t> m_Textures;
-    GPUBuffer m_GPUBuffer;
+    GeometryRange m_Geometry; // where the vertices and indices are stored in the geometry arena
     bool m_HasTexture[NUM_TEXTURE_TYPES] = {false};
 
     AABB m_AABB;
@@ -0,0 +1,319 @@
+#include <MeshOptimizer.hpp>
+#include <Mesh.hpp>
+
+#include <algorithm>
+#include <numeric>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+// scoring of Tom Forsyth's "Linear-Speed Vertex Cache Optimisation"
+static constexpr int FORSYTH_CACHE_SIZE = 32;
+static constexpr float FORSYTH_LAST_TRIANGLE_SCORE = 0.75f;
+static constexpr float FORSYTH_CACHE_DECAY_POWER = 1.5f;
+static constexpr float FORSYTH_VALENCE_BOOST_SCALE = 2.0f;
+static constexpr float FORSYTH_VALENCE_BOOST_POWER = 0.5f;
+
+VertexCacheStatistics AnalyzeVertexCache(const std::vector<unsigned int>& indices, size_t vertex_count, unsigned int cache_size)
+{
+    VertexCacheStatistics statistics;
+
+    if(indices.size() < 3 || vertex_count == 0){
+        return statistics;
+    }
+
+    // FIFO cache: a vertex is only pushed on a miss, so its age is the number of misses since then
+    std::vector<uint32_t> cached_at(vertex_count, 0);
+    std::vector<uint8_t> used(vertex_count, false);
+    uint32_t misses = 0;
+    size_t used_vertices = 0;
+
+    for(unsigned int index : indices){
+        if(!used[index]){
+            used[index] = true;
+            used_vertices++;
+        }
+
+        if(cached_at[index] == 0 || misses + 1 - cached_at[index] > cache_size){
+            misses++;
+            cached_at[index] = misses;
+        }
+    }
+
+    statistics.acmr = (float)misses / (indices.size() / 3);
+    statistics.atvr = (float)misses / used_vertices;
+
+    return statistics;
+}
+
+static float ForsythVertexScore(int cache_position, uint32_t remaining_triangles)
+{
+    if(remaining_triangles == 0){
+        return -1.0f;
+    }
+
+    float score = 0.0f;
+
+    if(cache_position >= 0){
+        if(cache_position < 3){ // the vertices of the last triangle, a fixed score so strips aren't favoured over fans
+            score = FORSYTH_LAST_TRIANGLE_SCORE;
+        }else{
+            score = std::pow(1.0f - (float)(cache_position - 3) / (FORSYTH_CACHE_SIZE - 3), FORSYTH_CACHE_DECAY_POWER);
+        }
+    }
+
+    // vertices with few triangles left are finished first, so they don't stay behind
+    return score + FORSYTH_VALENCE_BOOST_SCALE * std::pow((float)remaining_triangles, -FORSYTH_VALENCE_BOOST_POWER);
+}
+
+std::vector<unsigned int> OptimizeVertexCache(const std::vector<unsigned int>& indices, size_t vertex_count)
+{
+    size_t num_triangles = indices.size() / 3;
+
+    std::vector<unsigned int> result;
+    result.reserve(num_triangles * 3);
+
+    if(num_triangles == 0){
+        return result;
+    }
+
+    // triangles of each vertex. the ones still to emit are kept at the front of the range of the vertex
+    std::vector<uint32_t> remaining(vertex_count, 0);
+    for(size_t i = 0; i < num_triangles * 3; i++){
+        remaining[indices[i]]++;
+    }
+
+    std::vector<uint32_t> offsets(vertex_count + 1, 0);
+    for(size_t i = 0; i < vertex_count; i++){
+        offsets[i + 1] = offsets[i] + remaining[i];
+    }
+
+    std::vector<uint32_t> vertex_triangles(num_triangles * 3);
+    std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+    for(size_t i = 0; i < num_triangles * 3; i++){
+        vertex_triangles[fill[indices[i]]++] = i / 3;
+    }
+
+    std::vector<int> cache_positions(vertex_count, -1);
+    std::vector<float> vertex_scores(vertex_count);
+    for(size_t i = 0; i < vertex_count; i++){
+        vertex_scores[i] = ForsythVertexScore(-1, remaining[i]);
+    }
+
+    std::vector<float> triangle_scores(num_triangles);
+    std::vector<uint8_t> emitted(num_triangles, false);
+    int64_t best = -1;
+    float best_score = -1.0f;
+
+    for(size_t i = 0; i < num_triangles; i++){
+        triangle_scores[i] = vertex_scores[indices[i * 3]] + vertex_scores[indices[i * 3 + 1]] + vertex_scores[indices[i * 3 + 2]];
+
+        if(triangle_scores[i] > best_score){
+            best_score = triangle_scores[i];
+            best = i;
+        }
+    }
+
+    std::vector<unsigned int> cache, new_cache;
+    size_t next_unemitted = 0;
+
+    for(size_t emitted_count = 0; emitted_count < num_triangles; emitted_count++){
+        if(best < 0){
+            // nothing in the cache has triangles left, restart from the first triangle not emitted yet
+            while(emitted[next_unemitted]){
+                next_unemitted++;
+            }
+            best = next_unemitted;
+        }
+
+        const unsigned int* triangle = &indices[best * 3];
+        emitted[best] = true;
+        result.insert(result.end(), triangle, triangle + 3);
+
+        for(int k = 0; k < 3; k++){
+            unsigned int vertex = triangle[k];
+            uint32_t first = offsets[vertex];
+            uint32_t last = first + remaining[vertex] - 1;
+
+            for(uint32_t t = first; t <= last; t++){
+                if(vertex_triangles[t] == best){
+                    std::swap(vertex_triangles[t], vertex_triangles[last]);
+                    break;
+                }
+            }
+
+            remaining[vertex]--;
+        }
+
+        // the vertices of the triangle move to the front of the LRU cache
+        new_cache.assign(triangle, triangle + 3);
+        for(unsigned int vertex : cache){
+            if(vertex != triangle[0] && vertex != triangle[1] && vertex != triangle[2]){
+                new_cache.push_back(vertex);
+            }
+        }
+
+        for(size_t i = 0; i < new_cache.size(); i++){
+            cache_positions[new_cache[i]] = (i < FORSYTH_CACHE_SIZE) ? (int)i : -1;
+        }
+
+        best = -1;
+        best_score = -1.0f;
+
+        for(unsigned int vertex : new_cache){
+            vertex_scores[vertex] = ForsythVertexScore(cache_positions[vertex], remaining[vertex]);
+        }
+
+        for(unsigned int vertex : new_cache){
+            for(uint32_t t = offsets[vertex]; t < offsets[vertex] + remaining[vertex]; t++){
+                uint32_t triangle_index = vertex_triangles[t];
+                const unsigned int* v = &indices[triangle_index * 3];
+
+                triangle_scores[triangle_index] = vertex_scores[v[0]] + vertex_scores[v[1]] + vertex_scores[v[2]];
+
+                if(triangle_scores[triangle_index] > best_score){
+                    best_score = triangle_scores[triangle_index];
+                    best = triangle_index;
+                }
+            }
+        }
+
+        if(new_cache.size() > FORSYTH_CACHE_SIZE){
+            new_cache.resize(FORSYTH_CACHE_SIZE);
+        }
+
+        std::swap(cache, new_cache);
+    }
+
+    return result;
+}
+
+std::vector<unsigned int> OptimizeOverdraw(const std::vector<unsigned int>& indices, const std::vector<Vertex>& vertices, float threshold)
+{
+    size_t num_triangles = indices.size() / 3;
+
+    if(num_triangles < 2){
+        return indices;
+    }
+
+    // misses of each triangle in the current order
+    std::vector<uint32_t> cached_at(vertices.size(), 0);
+    std::vector<uint8_t> triangle_misses(num_triangles, 0);
+    uint32_t misses = 0;
+
+    for(size_t i = 0; i < num_triangles * 3; i++){
+        unsigned int index = indices[i];
+
+        if(cached_at[index] == 0 || misses + 1 - cached_at[index] > VERTEX_CACHE_SIZE){
+            misses++;
+            cached_at[index] = misses;
+            triangle_misses[i / 3]++;
+        }
+    }
+
+    float cluster_threshold = threshold * (float)misses / num_triangles;
+
+    // a new cluster starts where the cache is cold anyway (three misses), or where the cluster so far is good enough that a cold start costs little
+    std::vector<uint32_t> clusters;
+    uint32_t cluster_misses = 0;
+    uint32_t cluster_triangles = 0;
+
+    for(size_t i = 0; i < num_triangles; i++){
+        bool hard_boundary = triangle_misses[i] == 3;
+        bool soft_boundary = cluster_triangles > 0 && triangle_misses[i] >= 2 && (float)cluster_misses / cluster_triangles <= cluster_threshold;
+
+        if(i == 0 || hard_boundary || soft_boundary){
+            clusters.push_back(i);
+            cluster_misses = 0;
+            cluster_triangles = 0;
+        }
+
+        cluster_misses += triangle_misses[i];
+        cluster_triangles++;
+    }
+
+    clusters.push_back(num_triangles);
+    size_t num_clusters = clusters.size() - 1;
+
+    // area weighted centroid and normal of each cluster and of the mesh
+    std::vector<glm::vec3> centroids(num_clusters, glm::vec3(0.0f));
+    std::vector<glm::vec3> normals(num_clusters, glm::vec3(0.0f));
+    glm::vec3 mesh_centroid(0.0f);
+    float mesh_area = 0.0f;
+
+    for(size_t c = 0; c < num_clusters; c++){
+        float area = 0.0f;
+
+        for(uint32_t i = clusters[c]; i < clusters[c + 1]; i++){
+            glm::vec3 p0 = vertices[indices[i * 3]].Position;
+            glm::vec3 p1 = vertices[indices[i * 3 + 1]].Position;
+            glm::vec3 p2 = vertices[indices[i * 3 + 2]].Position;
+
+            glm::vec3 cross = glm::cross(p1 - p0, p2 - p0);
+            float triangle_area = glm::length(cross) * 0.5f;
+
+            centroids[c] += (p0 + p1 + p2) * (triangle_area / 3.0f);
+            normals[c] += cross;
+            area += triangle_area;
+        }
+
+        mesh_centroid += centroids[c];
+        mesh_area += area;
+        centroids[c] = (area > 0.0f) ? centroids[c] / area : vertices[indices[clusters[c] * 3]].Position;
+    }
+
+    mesh_centroid = (mesh_area > 0.0f) ? mesh_centroid / mesh_area : glm::vec3(0.0f);
+
+    std::vector<float> sort_keys(num_clusters);
+    for(size_t c = 0; c < num_clusters; c++){
+        float length = glm::length(normals[c]);
+        sort_keys[c] = (length > 0.0f) ? glm::dot(centroids[c] - mesh_centroid, normals[c] / length) : 0.0f;
+    }
+
+    std::vector<uint32_t> order(num_clusters);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&sort_keys](uint32_t a, uint32_t b){ return sort_keys[a] > sort_keys[b]; });
+
+    std::vector<unsigned int> result;
+    result.reserve(num_triangles * 3);
+
+    for(uint32_t c : order){
+        result.insert(result.end(), indices.begin() + clusters[c] * 3, indices.begin() + clusters[c + 1] * 3);
+    }
+
+    return result;
+}
+
+void OptimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices)
+{
+    constexpr unsigned int UNUSED = std::numeric_limits<unsigned int>::max();
+
+    std::vector<unsigned int> remap(vertices.size(), UNUSED);
+    std::vector<Vertex> reordered;
+    reordered.reserve(vertices.size());
+
+    for(unsigned int& index : indices){
+        if(remap[index] == UNUSED){
+            remap[index] = reordered.size();
+            reordered.push_back(vertices[index]);
+        }
+
+        index = remap[index];
+    }
+
+    vertices = std::move(reordered);
+}
+
+MeshOptimizationStatistics OptimizeMesh(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices)
+{
+    MeshOptimizationStatistics statistics;
+    statistics.before = AnalyzeVertexCache(indices, vertices.size());
+
+    indices = OptimizeVertexCache(indices, vertices.size());
+    indices = OptimizeOverdraw(indices, vertices);
+    OptimizeVertexFetch(vertices, indices);
+
+    statistics.after = AnalyzeVertexCache(indices, vertices.size());
+
+    return statistics;
+}
\ No newline at end of file
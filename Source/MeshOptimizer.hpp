@@ -0,0 +1,45 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+
+struct Vertex;
+
+inline constexpr unsigned int VERTEX_CACHE_SIZE = 16; // FIFO post-transform cache used for the statistics and the overdraw clusters
+inline constexpr float OVERDRAW_THRESHOLD = 1.05f; // the overdraw order may make the ACMR up to 5% worse
+
+struct VertexCacheStatistics{
+    float acmr = 0.0f; // average cache miss ratio: vertex shader invocations per triangle, 0.5 at best
+    float atvr = 0.0f; // average transformed vertex ratio: invocations per vertex, 1.0 at best
+};
+
+struct MeshOptimizationStatistics{
+    VertexCacheStatistics before;
+    VertexCacheStatistics after;
+};
+
+/**
+ * \brief Simulate a FIFO post-transform vertex cache over the triangles
+ */
+extern VertexCacheStatistics AnalyzeVertexCache(const std::vector<unsigned int>& indices, size_t vertex_count, unsigned int cache_size = VERTEX_CACHE_SIZE);
+
+/**
+ * \brief Reorder the triangles for the post-transform vertex cache (Tom Forsyth's linear-speed algorithm)
+ */
+extern std::vector<unsigned int> OptimizeVertexCache(const std::vector<unsigned int>& indices, size_t vertex_count);
+/**
+ * \brief Split the triangles in clusters where the vertex cache restarts anyway, or where it costs less than threshold in ACMR,
+ * then sort the clusters so the ones facing out from the center of the mesh are drawn first and occlude the others (Tipsify).
+ * Expects indices already optimized for the vertex cache
+ */
+extern std::vector<unsigned int> OptimizeOverdraw(const std::vector<unsigned int>& indices, const std::vector<Vertex>& vertices, float threshold = OVERDRAW_THRESHOLD);
+/**
+ * \brief Reorder the vertices in the order the triangles first use them and remap the indices. The bone ids and weights are part of Vertex, so they follow.
+ * Vertices no triangle uses are dropped
+ */
+extern void OptimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices);
+
+/**
+ * \brief Vertex cache, overdraw and vertex fetch optimization of an imported mesh. Runs on the CPU only and always gives the same result for the same mesh
+ */
+extern MeshOptimizationStatistics OptimizeMesh(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices);
\ No newline at end of file
@@ -0,0 +1,291 @@
+#include <MeshSimplifier.hpp>
+#include <MeshOptimizer.hpp>
+#include <Mesh.hpp>
+
+#include <unordered_map>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+static constexpr size_t LOD_MIN_TRIANGLES = 256; // smaller meshes aren't worth more index buffers
+static constexpr float LOD_MIN_REDUCTION = 0.8f; // a LOD must have at most this fraction of the indices of the previous one
+static constexpr float LOD_MAX_ERROR = 0.05f;
+static constexpr int MAX_SIMPLIFY_PASSES = 64;
+
+/**
+ * \brief Symmetric 4x4 matrix: the sum of the squared distances from a set of planes
+ */
+struct Quadric{
+    double a2, ab, ac, ad, b2, bc, bd, c2, cd, d2;
+
+    Quadric& operator+=(const Quadric& q)
+    {
+        a2 += q.a2; ab += q.ab; ac += q.ac; ad += q.ad;
+        b2 += q.b2; bc += q.bc; bd += q.bd;
+        c2 += q.c2; cd += q.cd;
+        d2 += q.d2;
+        return *this;
+    }
+};
+
+static Quadric PlaneQuadric(glm::dvec3 n, double d, double weight)
+{
+    return {
+        n.x * n.x * weight, n.x * n.y * weight, n.x * n.z * weight, n.x * d * weight,
+        n.y * n.y * weight, n.y * n.z * weight, n.y * d * weight,
+        n.z * n.z * weight, n.z * d * weight,
+        d * d * weight
+    };
+}
+
+static double EvaluateQuadric(const Quadric& q, glm::dvec3 p)
+{
+    double error = q.a2 * p.x * p.x + 2.0 * q.ab * p.x * p.y + 2.0 * q.ac * p.x * p.z + 2.0 * q.ad * p.x
+                 + q.b2 * p.y * p.y + 2.0 * q.bc * p.y * p.z + 2.0 * q.bd * p.y
+                 + q.c2 * p.z * p.z + 2.0 * q.cd * p.z
+                 + q.d2;
+
+    return std::max(error, 0.0);
+}
+
+static inline uint64_t EdgeKey(unsigned int a, unsigned int b)
+{
+    return a < b ? ((uint64_t)a << 32) | b : ((uint64_t)b << 32) | a;
+}
+
+struct Collapse{
+    unsigned int from;
+    unsigned int to;
+    double cost;
+};
+
+std::vector<unsigned int> SimplifyMesh(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices, size_t target_index_count,
+                                       float max_error, float* result_error)
+{
+    std::vector<unsigned int> result = indices;
+    size_t num_vertices = vertices.size();
+
+    if(result_error){
+        *result_error = 0.0f;
+    }
+
+    if(result.size() <= target_index_count || num_vertices == 0){
+        return result;
+    }
+
+    // positions scaled to a unit box, so the error doesn't depend on the size of the mesh
+    glm::dvec3 min(vertices[0].Position), max(vertices[0].Position);
+    for(const Vertex& vertex : vertices){
+        min = glm::min(min, glm::dvec3(vertex.Position));
+        max = glm::max(max, glm::dvec3(vertex.Position));
+    }
+
+    glm::dvec3 size = max - min;
+    double scale = 1.0 / std::max({size.x, size.y, size.z, 1e-12});
+
+    std::vector<glm::dvec3> positions(num_vertices);
+    for(size_t i = 0; i < num_vertices; i++){
+        positions[i] = (glm::dvec3(vertices[i].Position) - min) * scale;
+    }
+
+    // a quadric for each vertex from the planes of its triangles, weighted by area so small triangles don't dominate
+    std::vector<Quadric> quadrics(num_vertices, Quadric{});
+    std::unordered_map<uint64_t, uint32_t> edge_uses;
+
+    for(size_t i = 0; i + 2 < result.size(); i += 3){
+        unsigned int v[3] = {result[i], result[i + 1], result[i + 2]};
+        glm::dvec3 cross = glm::cross(positions[v[1]] - positions[v[0]], positions[v[2]] - positions[v[0]]);
+        double length = glm::length(cross);
+
+        if(length > 0.0){
+            glm::dvec3 normal = cross / length;
+            Quadric q = PlaneQuadric(normal, -glm::dot(normal, positions[v[0]]), length * 0.5);
+
+            for(unsigned int vertex : v){
+                quadrics[vertex] += q;
+            }
+        }
+
+        for(int e = 0; e < 3; e++){
+            edge_uses[EdgeKey(v[e], v[(e + 1) % 3])]++;
+        }
+    }
+
+    // open edges: the border of the mesh and the seams, where the same position is split in different vertices
+    std::vector<uint8_t> locked(num_vertices, false);
+    for(const auto& [key, uses] : edge_uses){
+        if(uses == 1){
+            locked[key >> 32] = true;
+            locked[key & 0xFFFFFFFF] = true;
+        }
+    }
+
+    double max_cost = (double)max_error * max_error;
+    double worst_cost = 0.0;
+
+    std::vector<Collapse> collapses;
+    std::vector<unsigned int> remap(num_vertices);
+    std::vector<uint8_t> touched(num_vertices);
+    std::vector<uint32_t> triangle_offsets(num_vertices + 1);
+    std::vector<uint32_t> vertex_triangles;
+
+    for(int pass = 0; pass < MAX_SIMPLIFY_PASSES && result.size() > target_index_count; pass++){
+        size_t num_triangles = result.size() / 3;
+
+        // triangles around each vertex, for the flip test
+        std::fill(triangle_offsets.begin(), triangle_offsets.end(), 0);
+        for(unsigned int index : result){
+            triangle_offsets[index + 1]++;
+        }
+        for(size_t i = 0; i < num_vertices; i++){
+            triangle_offsets[i + 1] += triangle_offsets[i];
+        }
+
+        vertex_triangles.resize(result.size());
+        std::vector<uint32_t> fill(triangle_offsets.begin(), triangle_offsets.end() - 1);
+        for(size_t i = 0; i < result.size(); i++){
+            vertex_triangles[fill[result[i]]++] = i / 3;
+        }
+
+        // the cheapest direction of every edge
+        collapses.clear();
+        for(size_t i = 0; i < result.size(); i += 3){
+            for(int e = 0; e < 3; e++){
+                unsigned int a = result[i + e];
+                unsigned int b = result[i + (e + 1) % 3];
+
+                if(a > b){ // each interior edge is seen twice, once in each direction
+                    continue;
+                }
+
+                Quadric q = quadrics[a];
+                q += quadrics[b];
+
+                double cost_ab = locked[a] ? INFINITY : EvaluateQuadric(q, positions[b]);
+                double cost_ba = locked[b] ? INFINITY : EvaluateQuadric(q, positions[a]);
+
+                if(cost_ab <= cost_ba && cost_ab <= max_cost){
+                    collapses.push_back({a, b, cost_ab});
+                }else if(cost_ba < cost_ab && cost_ba <= max_cost){
+                    collapses.push_back({b, a, cost_ba});
+                }
+            }
+        }
+
+        if(collapses.empty()){
+            break;
+        }
+
+        std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b){ return a.cost < b.cost; });
+
+        for(size_t i = 0; i < num_vertices; i++){
+            remap[i] = i;
+        }
+        std::fill(touched.begin(), touched.end(), false);
+
+        size_t remaining_indices = result.size();
+        bool collapsed = false;
+
+        for(const Collapse& collapse : collapses){
+            if(remaining_indices <= target_index_count){
+                break;
+            }
+
+            if(touched[collapse.from] || touched[collapse.to]){
+                continue;
+            }
+
+            // moving "from" onto "to" must not flip any of the triangles that survive
+            bool flips = false;
+            uint32_t removed_triangles = 0;
+
+            for(uint32_t t = triangle_offsets[collapse.from]; t < triangle_offsets[collapse.from + 1] && !flips; t++){
+                const unsigned int* triangle = &result[vertex_triangles[t] * 3];
+
+                if(triangle[0] == collapse.to || triangle[1] == collapse.to || triangle[2] == collapse.to){
+                    removed_triangles++;
+                    continue;
+                }
+
+                glm::dvec3 p[3], moved[3];
+                for(int k = 0; k < 3; k++){
+                    p[k] = positions[triangle[k]];
+                    moved[k] = (triangle[k] == collapse.from) ? positions[collapse.to] : p[k];
+                }
+
+                glm::dvec3 before = glm::cross(p[1] - p[0], p[2] - p[0]);
+                glm::dvec3 after = glm::cross(moved[1] - moved[0], moved[2] - moved[0]);
+
+                flips = glm::dot(before, after) <= 0.0;
+            }
+
+            if(flips){
+                continue;
+            }
+
+            remap[collapse.from] = collapse.to;
+            quadrics[collapse.to] += quadrics[collapse.from];
+            worst_cost = std::max(worst_cost, collapse.cost);
+            remaining_indices -= removed_triangles * 3;
+            collapsed = true;
+
+            // the neighbourhood changed, its collapses are evaluated again in the next pass
+            for(uint32_t t = triangle_offsets[collapse.from]; t < triangle_offsets[collapse.from + 1]; t++){
+                const unsigned int* triangle = &result[vertex_triangles[t] * 3];
+                touched[triangle[0]] = touched[triangle[1]] = touched[triangle[2]] = true;
+            }
+        }
+
+        if(!collapsed){
+            break;
+        }
+
+        // apply the collapses and drop the triangles that became degenerate
+        size_t write = 0;
+        for(size_t i = 0; i < num_triangles; i++){
+            unsigned int a = remap[result[i * 3]];
+            unsigned int b = remap[result[i * 3 + 1]];
+            unsigned int c = remap[result[i * 3 + 2]];
+
+            if(a != b && b != c && a != c){
+                result[write++] = a;
+                result[write++] = b;
+                result[write++] = c;
+            }
+        }
+
+        result.resize(write);
+    }
+
+    if(result_error){
+        *result_error = (float)std::sqrt(worst_cost);
+    }
+
+    return result;
+}
+
+std::vector<std::vector<unsigned int>> GenerateLODs(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices, unsigned int max_lods)
+{
+    std::vector<std::vector<unsigned int>> lods;
+    lods.push_back(indices);
+
+    if(indices.size() / 3 < LOD_MIN_TRIANGLES){
+        return lods;
+    }
+
+    while(lods.size() < max_lods){
+        const std::vector<unsigned int>& previous = lods.back();
+        size_t target = (previous.size() / 6) * 3; // half the triangles
+
+        std::vector<unsigned int> lod = SimplifyMesh(vertices, previous, target, LOD_MAX_ERROR);
+
+        if(lod.empty() || lod.size() > previous.size() * LOD_MIN_REDUCTION){
+            break;
+        }
+
+        // the collapses scatter the triangles, restore the cache locality of the base mesh
+        lods.push_back(OptimizeVertexCache(lod, vertices.size()));
+    }
+
+    return lods;
+}
\ No newline at end of file
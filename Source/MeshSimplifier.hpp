@@ -0,0 +1,22 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+
+struct Vertex;
+
+/**
+ * \brief Quadric error metric simplification (Garland-Heckbert) with half-edge collapses. A vertex is only ever replaced by one of its neighbours,
+ * so the result indexes the same vertex buffer. Vertices on open edges (borders and attribute seams) are locked, so the outline and the seams don't crack
+ * \param target_index_count stop once the index count is at or below this
+ * \param max_error stop before a collapse that would move the surface more than this, relative to the size of the mesh
+ * \param result_error if not nullptr, the largest error of the collapses done
+ */
+extern std::vector<unsigned int> SimplifyMesh(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices, size_t target_index_count,
+                                              float max_error, float* result_error = nullptr);
+
+/**
+ * \brief The index buffers of the LODs of a mesh, starting with indices itself. Each LOD has about half the triangles of the previous one,
+ * the chain stops early when the simplifier can't reduce the mesh enough or the mesh is too small to bother. The LODs are reordered for the vertex cache
+ */
+extern std::vector<std::vector<unsigned int>> GenerateLODs(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices, unsigned int max_lods);
\ No newline at end of file
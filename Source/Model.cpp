@@ -3,13 +3,17 @@
 #include <Log.hpp>
 #include <ResourceManager.hpp>
 #include <Utils.hpp>
+#include <Globals.hpp>
+#include <MeshOptimizer.hpp>
 
 #include <assimp/Importer.hpp>
 #include <assimp/postprocess.h>
+#include <glad/glad.h>
 #include <glm.hpp>
 
 #include <cstdio>
 #include <limits>
+#include <algorithm>
 #include <stack>
 
 static std::deque<std::string>* g_Logs = nullptr;
@@ -46,6 +50,40 @@ void Model::Load(const std::string& path, bool gamma)
     m_Directory = m_Directory.substr(0, m_Directory.find_last_of('/'));
 
     ProcessNode(scene->mRootNode, scene);
+
+    LogVertexMemory();
+}
+
+void Model::LogVertexMemory() const
+{
+    size_t num_vertices = 0;
+    size_t full_size = 0;
+    size_t compact_size = 0;
+
+    for(const Mesh& mesh : m_Meshes){
+        const GeometryRange& geometry = mesh.GetGeometry();
+        num_vertices += geometry.vertex_count;
+        full_size += (size_t)geometry.vertex_count * sizeof(Vertex);
+        compact_size += (size_t)geometry.vertex_count * geometry.vertex_size;
+    }
+
+    if(num_vertices == 0){
+        return;
+    }
+
+    // the G-buffer pass fetches every attribute of every stream, so its vertex bandwidth shrinks like the memory
+    char message[256];
+    snprintf(message, sizeof(message), "Vertex data of %s: %zu vertices, %.2f MB instead of %.2f MB (%.1f bytes per vertex instead of %zu, %.0f%% less G-buffer vertex fetch)",
+             m_Path.c_str(), num_vertices, compact_size / (1024.0 * 1024.0), full_size / (1024.0 * 1024.0), (double)compact_size / num_vertices, sizeof(Vertex),
+             100.0 * (1.0 - (double)compact_size / full_size));
+
+    if(!g_Logs){
+        LogMessage("%s", message);
+    }else{
+        g_LogsMutex->lock();
+        g_Logs->push_back(std::string(message) + "\n");
+        g_LogsMutex->unlock();
+    }
 }
 
 void Model::Load(const std::vector<Mesh>& meshes, const std::string& model_name, bool gamma)
@@ -64,61 +102,227 @@ void Model::Unload()
         mesh.Free();
     }
 
+    ReleaseProxies();
+
     m_Meshes.clear();
     m_Transforms.clear();
+    m_WorldOBBs.clear();
+    m_SelectedLODs.clear();
+    m_DirtyTransforms.clear();
+    m_TransformRevisions.clear();
+    m_InstanceData.clear();
     m_LoadedTextures.clear();
 }
 
 void Model::SetMeshes(const std::vector<Mesh>& meshes)
 {
+    ReleaseProxies(); // the layout of the bounds depends on the number of meshes
+
     m_Meshes = meshes;
+    m_DirtyTransforms.assign(m_Transforms.size(), true);
+    m_BoundsDirty = true;
 }
 
 void Model::SetTransforms(const std::vector<glm::mat4>& transforms)
 {
+    if(transforms.size() != m_Transforms.size()){
+        ReleaseProxies();
+    }
+
     m_Transforms = transforms;
+    m_DirtyTransforms.assign(m_Transforms.size(), true);
+    m_BoundsDirty = true;
 }
 
 void Model::SetTransform(uint32_t index, const glm::mat4& transform)
 {
     while(m_Transforms.size() <= index){
         m_Transforms.push_back(glm::mat4(1.0f));
+        m_DirtyTransforms.push_back(true);
     }
 
     m_Transforms[index] = transform;
+    MarkTransformDirty(index);
 }
 
 void Model::AddTransform(const glm::mat4& transform)
 {
+    // the BVH proxies of the new instance are inserted by the next UpdateBounds
     m_Transforms.push_back(transform);
+    m_DirtyTransforms.push_back(true);
+    m_BoundsDirty = true;
 }
 
 void Model::RemoveTransform(uint32_t index)
 {
     if(index < m_Transforms.size()){
+        const size_t num_meshes = m_Meshes.size();
+
         m_Transforms.erase(m_Transforms.begin() + index);
+
+        if(m_DirtyTransforms.size() == m_Transforms.size() + 1 && m_WorldOBBs.size() == m_DirtyTransforms.size() * num_meshes &&
+           m_ProxyIds.size() == m_WorldOBBs.size()){
+            // keep the cached bounds of the other transforms
+            BVH& tree = GetSceneTree();
+
+            for(size_t i = index * num_meshes; i < (index + 1) * num_meshes; i++){
+                if(m_ProxyIds[i] != BVH_NULL_NODE){
+                    tree.DestroyProxy(m_ProxyIds[i]);
+                }
+            }
+
+            m_DirtyTransforms.erase(m_DirtyTransforms.begin() + index);
+            if(index < m_TransformRevisions.size()){
+                m_TransformRevisions.erase(m_TransformRevisions.begin() + index);
+            }
+            if(index < m_InstanceData.size()){
+                m_InstanceData.erase(m_InstanceData.begin() + index);
+            }
+            m_WorldOBBs.erase(m_WorldOBBs.begin() + index * num_meshes, m_WorldOBBs.begin() + (index + 1) * num_meshes);
+            m_ProxyIds.erase(m_ProxyIds.begin() + index * num_meshes, m_ProxyIds.begin() + (index + 1) * num_meshes);
+            if(m_SelectedLODs.size() == m_ProxyIds.size() + num_meshes){
+                m_SelectedLODs.erase(m_SelectedLODs.begin() + index * num_meshes, m_SelectedLODs.begin() + (index + 1) * num_meshes);
+            }
+
+            // the following transforms were shifted down by one
+            for(size_t i = index * num_meshes; i < m_ProxyIds.size(); i++){
+                if(m_ProxyIds[i] != BVH_NULL_NODE){
+                    BVHProxy data = tree.GetProxyData(m_ProxyIds[i]);
+                    data.transform_index--;
+                    tree.SetProxyData(m_ProxyIds[i], data);
+                }
+            }
+        }else{
+            ReleaseProxies();
+            m_DirtyTransforms.assign(m_Transforms.size(), true);
+            m_BoundsDirty = true;
+        }
     }
 }
 
-void Model::Draw(Shader& shader, glm::mat4 view, glm::mat4 model)
+void Model::ClearTransforms()
 {
-    for(int i = 0; i < m_Meshes.size(); i++){
-        m_Meshes[i].Draw(shader, view, model);
+    ReleaseProxies();
+
+    m_Transforms.clear();
+    m_WorldOBBs.clear();
+    m_SelectedLODs.clear();
+    m_DirtyTransforms.clear();
+    m_TransformRevisions.clear();
+    m_InstanceData.clear();
+}
+
+void Model::MarkTransformDirty(uint32_t index)
+{
+    if(index < m_DirtyTransforms.size()){
+        m_DirtyTransforms[index] = true;
+        m_BoundsDirty = true;
     }
 }
 
-void Model::DrawShadows(Shader& shader, glm::mat4 light_space_matrix, glm::mat4 model)
+void Model::ReleaseProxies()
 {
-    for(int i = 0; i < m_Meshes.size(); i++){
-        m_Meshes[i].DrawShadows(shader, light_space_matrix, model);
+    if(!m_ProxyIds.empty()){
+        BVH& tree = GetSceneTree();
+
+        for(int proxy_id : m_ProxyIds){
+            if(proxy_id != BVH_NULL_NODE){
+                tree.DestroyProxy(proxy_id);
+            }
+        }
     }
+
+    m_ProxyIds.clear();
+    m_WorldOBBs.clear();
 }
 
-void Model::DrawDepth(Shader& shader, glm::mat4 view, glm::mat4 model)
+uint32_t Model::UpdateBounds(Animator* animator, uint32_t revision)
 {
-    for(int i = 0; i < m_Meshes.size(); i++){
-        m_Meshes[i].DrawDepth(shader, view, model);
+    const size_t num_meshes = m_Meshes.size();
+    const size_t num_bounds = m_Transforms.size() * num_meshes;
+
+    if(m_DirtyTransforms.size() != m_Transforms.size()){ // transforms were added or removed directly through GetTransforms
+        m_DirtyTransforms.assign(m_Transforms.size(), true);
+        m_BoundsDirty = true;
     }
+
+    if(m_ProxyIds.size() > num_bounds){
+        for(size_t i = num_bounds; i < m_ProxyIds.size(); i++){
+            if(m_ProxyIds[i] != BVH_NULL_NODE){
+                GetSceneTree().DestroyProxy(m_ProxyIds[i]);
+            }
+        }
+    }
+
+    if(m_WorldOBBs.size() != num_bounds || m_ProxyIds.size() != num_bounds){
+        size_t first_new = std::min(m_WorldOBBs.size(), m_ProxyIds.size());
+
+        m_WorldOBBs.resize(num_bounds);
+        m_ProxyIds.resize(num_bounds, BVH_NULL_NODE);
+
+        for(size_t i = first_new / std::max<size_t>(num_meshes, 1); i < m_Transforms.size(); i++){
+            m_DirtyTransforms[i] = true;
+            m_BoundsDirty = true;
+        }
+    }
+
+    if(m_SelectedLODs.size() != num_bounds){
+        m_SelectedLODs.resize(num_bounds, 0);
+    }
+
+    if(m_InstanceData.size() != m_Transforms.size()){
+        for(size_t i = m_InstanceData.size(); i < m_Transforms.size(); i++){
+            m_DirtyTransforms[i] = true;
+            m_BoundsDirty = true;
+        }
+
+        m_InstanceData.resize(m_Transforms.size());
+    }
+
+    if(m_TransformRevisions.size() != m_Transforms.size()){
+        m_TransformRevisions.resize(m_Transforms.size(), revision);
+    }
+
+    if(!m_BoundsDirty){
+        return 0;
+    }
+
+    BVH& tree = GetSceneTree();
+    uint32_t rebuilt = 0;
+
+    for(uint32_t i = 0; i < m_Transforms.size(); i++){
+        if(!m_DirtyTransforms[i]){
+            continue;
+        }
+
+        m_InstanceData[i].model = m_Transforms[i];
+        m_InstanceData[i].normal = glm::mat4(glm::transpose(glm::inverse(glm::mat3(m_Transforms[i]))));
+
+        for(uint32_t j = 0; j < num_meshes; j++){
+            const size_t index = i * num_meshes + j;
+
+            m_WorldOBBs[index] = OBBFromAABB(m_Meshes[j].GetAABB(), m_Transforms[i]); // Get the OBB so the model can also be rotated
+            AABB aabb = AABBFromOBB(m_WorldOBBs[index]);
+
+            if(m_ProxyIds[index] == BVH_NULL_NODE){
+                m_ProxyIds[index] = tree.CreateProxy(aabb, {this, animator, i, j});
+            }else{
+                tree.MoveProxy(m_ProxyIds[index], aabb);
+            }
+        }
+
+        m_DirtyTransforms[i] = false;
+        m_TransformRevisions[i] = revision;
+        rebuilt += num_meshes;
+    }
+
+    m_BoundsDirty = false;
+
+    #ifdef DEBUG
+        bounds_rebuilt += rebuilt;
+    #endif
+
+    return rebuilt;
 }
 
 void Model::ProcessNode(aiNode* node, const aiScene* scene, glm::mat4 parent_transform)
@@ -222,6 +426,21 @@ Mesh Model::ProcessMesh(aiMesh* mesh, const aiScene* scene, glm::mat4 parent_tra
         }
     }
 
+    // after the bone weights: they are stored in the vertices, so the vertex reordering moves them too
+    MeshOptimizationStatistics statistics = OptimizeMesh(vertices, indices);
+
+    char message[256];
+    snprintf(message, sizeof(message), "Mesh %s: ACMR %.3f -> %.3f, ATVR %.3f -> %.3f", mesh->mName.C_Str(),
+             statistics.before.acmr, statistics.after.acmr, statistics.before.atvr, statistics.after.atvr);
+
+    if(!g_Logs){
+        LogMessage("%s", message);
+    }else{
+        g_LogsMutex->lock();
+        g_Logs->push_back(std::string(message) + "\n");
+        g_LogsMutex->unlock();
+    }
+
     aiMaterial* material = scene->mMaterials[mesh->mMaterialIndex];
 
     Mesh mesh_obj(vertices, indices, AABB(aabb_min, aabb_max));
@@ -2,6 +2,8 @@
 
 #include <Mesh.hpp>
 #include <Texture.hpp>
+#include <BoundingBox.hpp>
+#include <BVH.hpp>
 
 #include <vector>
 #include <map>
@@ -9,11 +11,14 @@
 #include <string>
 #include <deque>
 #include <mutex>
+#include <limits>
 #include <assimp/scene.h>
 #include <glm.hpp>
 
 extern glm::mat4 g_DummyTransform;
 
+class Animator;
+
 struct BoneInfo{
     int id;
     glm::mat4 offset;
@@ -24,6 +29,10 @@ public:
     Model() = default;
     ~Model() = default;
 
+    // the BVH proxies point to the model and are released by it, a copy would share them
+    Model(const Model&) = delete;
+    Model& operator=(const Model&) = delete;
+
     void Load(const std::string& path, bool gamma = false);
     void Load(const std::vector<Mesh>& meshes, const std::string& model_name, bool gamma = false);
     void Unload();
@@ -35,14 +44,43 @@ public:
     void AddTransform(const glm::mat4& transform);
     void RemoveTransform(uint32_t index);
 
-    void Draw(Shader& shader, glm::mat4 view, glm::mat4 model);
-    void DrawShadows(Shader& shader, glm::mat4 light_space_matrix, glm::mat4 model);
-    void DrawDepth(Shader& shader, glm::mat4 view, glm::mat4 model);
+    /**
+     * \brief Must be called after writing a matrix through GetTransform/GetTransforms, so its bounds get recomputed
+     */
+    void MarkTransformDirty(uint32_t index);
+
+    /**
+     * \brief Recompute the world space bounds of the dirty transforms and refit them in the scene BVH
+     * \param animator stored in the BVH proxies of skinned models
+     * \param revision stored for the transforms that were rebuilt, e.g. the frame number, so a cache can tell which instances moved and when
+     * \returns the number of (transform, mesh) bounds that were rebuilt
+     */
+    uint32_t UpdateBounds(Animator* animator = nullptr, uint32_t revision = 0);
 
     inline std::vector<Mesh>& GetMeshes() { return m_Meshes; }
     inline std::vector<glm::mat4>& GetTransforms() { return m_Transforms; }
     inline glm::mat4& GetTransform(uint32_t index) { return (index < m_Transforms.size()) ? m_Transforms[index] : g_DummyTransform; }
-    inline void ClearTransforms() { m_Transforms.clear(); }
+    void ClearTransforms();
+    /**
+     * \brief Valid only after UpdateBounds
+     */
+    inline const OBB& GetWorldOBB(uint32_t transform_index, uint32_t mesh_index) const { return m_WorldOBBs[transform_index * m_Meshes.size() + mesh_index]; }
+    /**
+     * \brief Valid only after UpdateBounds
+     */
+    inline const InstanceData& GetInstanceData(uint32_t transform_index) const { return m_InstanceData[transform_index]; }
+    /**
+     * \brief The LOD the (transform, mesh) was drawn with in the last frame, kept for the hysteresis. Valid only after UpdateBounds
+     */
+    inline uint8_t& GetSelectedLOD(uint32_t transform_index, uint32_t mesh_index) { return m_SelectedLODs[transform_index * m_Meshes.size() + mesh_index]; }
+    /**
+     * \brief The revision passed to the last UpdateBounds that rebuilt the transform. Valid only after UpdateBounds
+     */
+    inline uint32_t GetTransformRevision(uint32_t transform_index) const { return m_TransformRevisions[transform_index]; }
+    /**
+     * \brief Number of transforms with bounds and instance data, valid only after UpdateBounds
+     */
+    inline uint32_t GetInstanceCount() const { return (uint32_t)m_InstanceData.size(); }
     inline const std::string& GetDirectory() const { return m_Directory; }
     inline bool GetGammaCorrection() { return m_GammaCorrection; }
     inline const std::string& GetPath() const { return m_Path; }
@@ -60,10 +98,23 @@ public:
 private:
     void ProcessNode(aiNode* node, const aiScene* scene, glm::mat4 parent_transform = glm::mat4(1.0f));
     Mesh ProcessMesh(aiMesh* mesh, const aiScene* scene, glm::mat4 parent_transform = glm::mat4(1.0f));
+    void ReleaseProxies();
+    /**
+     * \brief Log the memory of the vertices in the compact formats of the geometry arena, against the size of Vertex
+     */
+    void LogVertexMemory() const;
     std::vector<uint32_t> LoadMaterialTextures(aiMaterial* mat, const aiScene* scene, aiTextureType type, const std::string& typeName);
 
     std::vector<Mesh> m_Meshes;
     std::vector<glm::mat4> m_Transforms;
+    std::vector<OBB> m_WorldOBBs; // one for each (transform, mesh), indexed by transform * meshes + mesh
+    std::vector<int> m_ProxyIds; // BVH proxy of each (transform, mesh), same layout as m_WorldOBBs
+    std::vector<uint8_t> m_SelectedLODs; // same layout as m_WorldOBBs, written only by the camera draw list
+    std::vector<uint8_t> m_DirtyTransforms;
+    std::vector<uint32_t> m_TransformRevisions; // one for each transform, set when its bounds are rebuilt
+    bool m_BoundsDirty = true;
+
+    std::vector<InstanceData> m_InstanceData; // one for each transform, updated with the bounds
     std::unordered_map<std::string, uint32_t> m_LoadedTextures;
     std::string m_Directory;
 
@@ -1,4 +1,5 @@
 #include <Globals.hpp>
+#include <OpenGL.hpp>
 #include <Log.hpp>
 #include <ResourceManager.hpp>
 
@@ -12,10 +13,10 @@ static uint32_t g_MousePickingShader;
 void InitMousePicking()
 {
     glGenFramebuffers(1, &g_FBO);
-    glBindFramebuffer(GL_FRAMEBUFFER, g_FBO);
+    BindFramebuffer(GL_FRAMEBUFFER, g_FBO);
 
     glGenTextures(1, &g_ColorTexture);
-    glBindTexture(GL_TEXTURE_2D, g_ColorTexture);
+    BindTexture(g_ColorTexture, 0);
     glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB16UI, g_ScreenWidth, g_ScreenHeight, 0, GL_RGB_INTEGER, GL_UNSIGNED_SHORT, nullptr);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
@@ -30,7 +31,7 @@ void InitMousePicking()
         LogError("Mouse picking framebuffer is not complete!");
     }
 
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    BindFramebuffer(GL_FRAMEBUFFER, 0);
 
     g_MousePickingShader = LoadShader("Resources/Shaders/MousePicking.vert", "Resources/Shaders/MousePicking.frag");
     GetShader(g_MousePickingShader)->Bind();
@@ -40,55 +41,37 @@ void InitMousePicking()
 
 void DeinitMousePicking()
 {
-    glDeleteFramebuffers(1, &g_FBO);
-    glDeleteTextures(1, &g_ColorTexture);
+    DeleteFramebuffers(1, &g_FBO);
+    DeleteTextures(1, &g_ColorTexture);
     glDeleteRenderbuffers(1, &g_DepthBuffer);
 }
 
+Shader& GetMousePickingShader()
+{
+    return *GetShader(g_MousePickingShader);
+}
+
 void UpdateMousePicking()
 {
-    glBindFramebuffer(GL_FRAMEBUFFER, g_FBO);
+    BindFramebuffer(GL_FRAMEBUFFER, g_FBO);
+    SetViewport(0, 0, g_ScreenWidth, g_ScreenHeight); // picked at the mouse position, never at the dynamic resolution
     glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-    GetShader(g_MousePickingShader)->Bind();
-
-    auto& models = GetModels();
-
-    for(auto& [id, model] : models){
-        GetShader(g_MousePickingShader)->SetUniform1ui("id", id);
-
-        auto& transforms = model.GetTransforms();
-        for(unsigned int i = 0; i < transforms.size(); i++){
-            GetShader(g_MousePickingShader)->SetUniform1ui("transform_index", i);
-            model.DrawDepth(*GetShader(g_MousePickingShader), GetCamera().GetViewMatrix(), transforms[i]);
-        }
-    }
-
-    auto& skinned_models = GetSkinnedModels();
-
-    for(auto& [id, skinned_model] : skinned_models){
-        GetShader(g_MousePickingShader)->SetUniform1ui("id", id);
-
-        auto& transforms = skinned_model.model.GetTransforms();
-        for(unsigned int i = 0; i < transforms.size(); i++){
-            GetShader(g_MousePickingShader)->SetUniform1ui("transform_index", i);
-            skinned_model.animator.UploadFinalBoneMatrices(*GetShader(g_MousePickingShader));
-            skinned_model.model.DrawDepth(*GetShader(g_MousePickingShader), GetCamera().GetViewMatrix(), transforms[i]);
-        }
-    }
+    // built by BuildDrawLists at the start of the frame
+    DrawPickingList(GetCamera().GetViewMatrix());
 
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    BindFramebuffer(GL_FRAMEBUFFER, 0);
 }
 
 std::pair<uint32_t, unsigned int> GetSelectedModel(glm::vec2 mousePos)
 {
-    glBindFramebuffer(GL_FRAMEBUFFER, g_FBO);
+    BindFramebuffer(GL_FRAMEBUFFER, g_FBO);
 
     unsigned short pixel[3];
     glReadPixels(mousePos.x, mousePos.y, 1, 1, GL_RGB_INTEGER, GL_UNSIGNED_SHORT, pixel);
 
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    BindFramebuffer(GL_FRAMEBUFFER, 0);
 
     if(pixel[0] == 0 && pixel[1] == 0 && pixel[2] == 0){
         return {std::numeric_limits<uint32_t>::max(), 0};
@@ -3,9 +3,15 @@
 #include <glm.hpp>
 #include <cstdint>
 
+class Shader;
+
 extern void InitMousePicking();
 extern void UpdateMousePicking();
 extern void DeinitMousePicking();
+/**
+ * \brief Used by ResourceManager::BuildDrawLists to build the picking draw list
+ */
+extern Shader& GetMousePickingShader();
 
 /**
  * \returns a pair containing the id of the selected model and the index of the selected transform
@@ -1,6 +1,129 @@
 #include <OpenGL.hpp>
+#include <Globals.hpp>
 #include <Log.hpp>
 
+#include <cstdint>
+#include <cstring>
+
+static constexpr unsigned int UNKNOWN_BINDING = ~0u; // the next bind is always issued
+static constexpr int MAX_CACHED_TEXTURE_UNITS = 32;
+
+static constexpr GLenum CACHED_BUFFER_TARGETS[] = {
+    GL_ARRAY_BUFFER, GL_ELEMENT_ARRAY_BUFFER, GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, GL_DRAW_INDIRECT_BUFFER, GL_DISPATCH_INDIRECT_BUFFER,
+    GL_SHADER_STORAGE_BUFFER, GL_UNIFORM_BUFFER, GL_PIXEL_PACK_BUFFER, GL_PIXEL_UNPACK_BUFFER, GL_PARAMETER_BUFFER, GL_ATOMIC_COUNTER_BUFFER
+};
+static constexpr int NUM_CACHED_BUFFER_TARGETS = sizeof(CACHED_BUFFER_TARGETS) / sizeof(GLenum);
+
+static constexpr GLenum CACHED_TEXTURE_TARGETS[] = {
+    GL_TEXTURE_2D, GL_TEXTURE_2D_ARRAY, GL_TEXTURE_CUBE_MAP, GL_TEXTURE_CUBE_MAP_ARRAY, GL_TEXTURE_3D
+};
+static constexpr int NUM_CACHED_TEXTURE_TARGETS = sizeof(CACHED_TEXTURE_TARGETS) / sizeof(GLenum);
+
+/**
+ * \brief What the cache believes is bound. UNKNOWN_BINDING (or -1 for the flags) until the first call
+ */
+struct GLState{
+    unsigned int program;
+    unsigned int vao;
+    unsigned int buffers[NUM_CACHED_BUFFER_TARGETS];
+    unsigned int textures[MAX_CACHED_TEXTURE_UNITS][NUM_CACHED_TEXTURE_TARGETS];
+    unsigned int active_texture;
+    unsigned int read_framebuffer;
+    unsigned int draw_framebuffer;
+    int viewport[4];
+    int8_t depth_test;
+    int8_t blend;
+    int8_t cull_face;
+    int cull_mode;
+    int winding_order;
+    int depth_func;
+    int8_t depth_mask;
+    int8_t color_mask;
+    bool blend_func_set;
+};
+
+static GLState g_State;
+
+/**
+ * \brief Counts the call as issued or elided
+ * \returns true if the cached value differs and the call must be issued. The cache is updated
+ */
+template<typename T>
+static bool Changes(T& cached, T value)
+{
+    if(cached == value){
+        #ifdef DEBUG
+            gl_calls_elided++;
+        #endif
+        return false;
+    }
+
+    #ifdef DEBUG
+        gl_calls_issued++;
+    #endif
+    cached = value;
+    return true;
+}
+
+static int BufferTargetIndex(GLenum target)
+{
+    for(int i = 0; i < NUM_CACHED_BUFFER_TARGETS; i++){
+        if(CACHED_BUFFER_TARGETS[i] == target){
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+static int TextureTargetIndex(GLenum target)
+{
+    for(int i = 0; i < NUM_CACHED_TEXTURE_TARGETS; i++){
+        if(CACHED_TEXTURE_TARGETS[i] == target){
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+static void SetCapability(int8_t& cached, GLenum capability, bool enabled)
+{
+    if(Changes(cached, (int8_t)enabled)){
+        if(enabled){
+            glEnable(capability);
+        }else{
+            glDisable(capability);
+        }
+    }
+}
+
+void InvalidateGLState()
+{
+    g_State.program = UNKNOWN_BINDING;
+    g_State.vao = UNKNOWN_BINDING;
+
+    for(unsigned int& buffer : g_State.buffers){
+        buffer = UNKNOWN_BINDING;
+    }
+
+    for(auto& unit : g_State.textures){
+        for(unsigned int& texture : unit){
+            texture = UNKNOWN_BINDING;
+        }
+    }
+
+    g_State.active_texture = UNKNOWN_BINDING;
+    g_State.read_framebuffer = UNKNOWN_BINDING;
+    g_State.draw_framebuffer = UNKNOWN_BINDING;
+    g_State.viewport[0] = g_State.viewport[1] = g_State.viewport[2] = g_State.viewport[3] = -1;
+    g_State.depth_test = g_State.blend = g_State.cull_face = -1;
+    g_State.cull_mode = g_State.winding_order = -1;
+    g_State.depth_func = -1;
+    g_State.depth_mask = g_State.color_mask = -1;
+    g_State.blend_func_set = false;
+}
+
 void OpenGLErrorCallback(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar* message, const void* userParam)
 {
     if(type == GL_DEBUG_TYPE_ERROR){
@@ -10,17 +133,17 @@ void OpenGLErrorCallback(GLenum source, GLenum type, GLuint id, GLenum severity,
 
 void OpenglFramebufferSizeCallback(GLFWwindow* window, int width, int height)
 {
-    glViewport(0, 0, width, height);
+    SetViewport(0, 0, width, height);
 }
 
 void EnableDepthTest()
 {
-    glEnable(GL_DEPTH_TEST);
+    SetCapability(g_State.depth_test, GL_DEPTH_TEST, true);
 }
 
 void DisableDepthTest()
 {
-    glDisable(GL_DEPTH_TEST);
+    SetCapability(g_State.depth_test, GL_DEPTH_TEST, false);
 }
 
 void ClearColor(float r, float g, float b, float a)
@@ -33,37 +156,81 @@ void ClearScreen()
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 }
 
+void ClearColorBuffer()
+{
+    glClear(GL_COLOR_BUFFER_BIT);
+}
+
 void EnableColorBlend()
 {
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    SetCapability(g_State.blend, GL_BLEND, true);
+
+    // the only blend function used
+    if(Changes(g_State.blend_func_set, true)){
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    }
 }
 
 void DisableColorBlend()
 {
-    glDisable(GL_BLEND);
+    SetCapability(g_State.blend, GL_BLEND, false);
 }
 
 void BindTexture(unsigned int texture, int slot)
 {
-    glActiveTexture(GL_TEXTURE0 + slot);
-    glBindTexture(GL_TEXTURE_2D, texture);
+    BindTextureTarget(GL_TEXTURE_2D, texture, slot);
 }
 
 void BindTextureArray(unsigned int textureArray, int slot)
 {
-    glActiveTexture(GL_TEXTURE0 + slot);
-    glBindTexture(GL_TEXTURE_2D_ARRAY, textureArray);
+    BindTextureTarget(GL_TEXTURE_2D_ARRAY, textureArray, slot);
+}
+
+void BindTextureTarget(GLenum target, unsigned int texture, int slot)
+{
+    int index = TextureTargetIndex(target);
+
+    if(index >= 0 && slot < MAX_CACHED_TEXTURE_UNITS){
+        if(!Changes(g_State.textures[slot][index], texture)){
+            return;
+        }
+    }else{
+        #ifdef DEBUG
+            gl_calls_issued++;
+        #endif
+    }
+
+    if(Changes(g_State.active_texture, (unsigned int)slot)){
+        glActiveTexture(GL_TEXTURE0 + slot);
+    }
+
+    glBindTexture(target, texture);
 }
 
 void BindFramebuffer(int target, unsigned int framebuffer)
 {
-    glBindFramebuffer(target, framebuffer);
+    if(target == GL_FRAMEBUFFER){
+        // binds both, issued if either differs
+        if(g_State.read_framebuffer != framebuffer){
+            g_State.read_framebuffer = framebuffer;
+            g_State.draw_framebuffer = UNKNOWN_BINDING;
+        }
+
+        if(Changes(g_State.draw_framebuffer, framebuffer)){
+            glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        }
+    }else if(target == GL_READ_FRAMEBUFFER){
+        if(Changes(g_State.read_framebuffer, framebuffer)){
+            glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+        }
+    }else if(Changes(g_State.draw_framebuffer, framebuffer)){
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, framebuffer);
+    }
 }
 
 void UnbindFramebuffer()
 {
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    BindFramebuffer(GL_FRAMEBUFFER, 0);
 }
 
 void BlitFramebuffer(int srcX0, int srcY0, int srcX1, int srcY1, int dstX0, int dstY0, int dstX1, int dstY1, unsigned int mask)
@@ -73,20 +240,194 @@ void BlitFramebuffer(int srcX0, int srcY0, int srcX1, int srcY1, int dstX0, int
 
 void EnableCullFace()
 {
-    glEnable(GL_CULL_FACE);
+    SetCapability(g_State.cull_face, GL_CULL_FACE, true);
 }
 
 void DisableCullFace()
 {
-    glDisable(GL_CULL_FACE);
+    SetCapability(g_State.cull_face, GL_CULL_FACE, false);
 }
 
 void SetCullFace(int face)
 {
-    glCullFace(face);
+    if(Changes(g_State.cull_mode, face)){
+        glCullFace(face);
+    }
 }
 
 void SetWindingOrder(int order)
 {
-    glFrontFace(order);
+    if(Changes(g_State.winding_order, order)){
+        glFrontFace(order);
+    }
+}
+
+void SetDepthFunc(GLenum func)
+{
+    if(Changes(g_State.depth_func, (int)func)){
+        glDepthFunc(func);
+    }
+}
+
+void SetDepthMask(bool write)
+{
+    if(Changes(g_State.depth_mask, (int8_t)write)){
+        glDepthMask(write);
+    }
+}
+
+void SetColorMask(bool write)
+{
+    if(Changes(g_State.color_mask, (int8_t)write)){
+        glColorMask(write, write, write, write);
+    }
+}
+
+void UseProgram(unsigned int program)
+{
+    if(Changes(g_State.program, program)){
+        glUseProgram(program);
+    }
+}
+
+void BindVertexArray(unsigned int vao)
+{
+    if(Changes(g_State.vao, vao)){
+        glBindVertexArray(vao);
+        g_State.buffers[BufferTargetIndex(GL_ELEMENT_ARRAY_BUFFER)] = UNKNOWN_BINDING;
+    }
+}
+
+void BindBuffer(GLenum target, unsigned int buffer)
+{
+    int index = BufferTargetIndex(target);
+
+    if(index < 0){
+        #ifdef DEBUG
+            gl_calls_issued++;
+        #endif
+        glBindBuffer(target, buffer);
+    }else if(Changes(g_State.buffers[index], buffer)){
+        glBindBuffer(target, buffer);
+    }
+}
+
+void BindBufferBase(GLenum target, unsigned int index, unsigned int buffer)
+{
+    int target_index = BufferTargetIndex(target);
+    if(target_index >= 0){
+        g_State.buffers[target_index] = buffer;
+    }
+
+    #ifdef DEBUG
+        gl_calls_issued++;
+    #endif
+
+    glBindBufferBase(target, index, buffer);
+}
+
+void BindBufferRange(GLenum target, unsigned int index, unsigned int buffer, GLintptr offset, GLsizeiptr size)
+{
+    int target_index = BufferTargetIndex(target);
+    if(target_index >= 0){
+        g_State.buffers[target_index] = buffer;
+    }
+
+    #ifdef DEBUG
+        gl_calls_issued++;
+    #endif
+
+    glBindBufferRange(target, index, buffer, offset, size);
+}
+
+void SetViewport(int x, int y, int width, int height)
+{
+    int* viewport = g_State.viewport;
+
+    if(viewport[0] == x && viewport[1] == y && viewport[2] == width && viewport[3] == height){
+        #ifdef DEBUG
+            gl_calls_elided++;
+        #endif
+        return;
+    }
+
+    #ifdef DEBUG
+        gl_calls_issued++;
+    #endif
+
+    viewport[0] = x;
+    viewport[1] = y;
+    viewport[2] = width;
+    viewport[3] = height;
+    glViewport(x, y, width, height);
+}
+
+// deleting a bound object unbinds it, the cache must forget it too or a new object with the same name would be considered bound
+
+void DeleteBuffers(int count, const unsigned int* buffers)
+{
+    for(int i = 0; i < count; i++){
+        for(unsigned int& buffer : g_State.buffers){
+            if(buffer == buffers[i]){
+                buffer = 0;
+            }
+        }
+    }
+
+    glDeleteBuffers(count, buffers);
+}
+
+void DeleteVertexArrays(int count, const unsigned int* vaos)
+{
+    for(int i = 0; i < count; i++){
+        if(g_State.vao == vaos[i]){
+            g_State.vao = 0;
+            g_State.buffers[BufferTargetIndex(GL_ELEMENT_ARRAY_BUFFER)] = UNKNOWN_BINDING;
+        }
+    }
+
+    glDeleteVertexArrays(count, vaos);
+}
+
+void DeleteTextures(int count, const unsigned int* textures)
+{
+    for(int i = 0; i < count; i++){
+        for(auto& unit : g_State.textures){
+            for(unsigned int& texture : unit){
+                if(texture == textures[i]){
+                    texture = 0;
+                }
+            }
+        }
+    }
+
+    glDeleteTextures(count, textures);
+}
+
+void DeleteFramebuffers(int count, const unsigned int* framebuffers)
+{
+    for(int i = 0; i < count; i++){
+        if(g_State.read_framebuffer == framebuffers[i]){
+            g_State.read_framebuffer = 0;
+        }
+        if(g_State.draw_framebuffer == framebuffers[i]){
+            g_State.draw_framebuffer = 0;
+        }
+    }
+
+    glDeleteFramebuffers(count, framebuffers);
+}
+
+bool HasExtension(const char* name)
+{
+    int count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+
+    for(int i = 0; i < count; i++){
+        if(strcmp((const char*)glGetStringi(GL_EXTENSIONS, i), name) == 0){
+            return true;
+        }
+    }
+
+    return false;
 }
\ No newline at end of file
@@ -9,6 +9,10 @@ extern void EnableDepthTest();
 extern void DisableDepthTest();
 extern void ClearColor(float r, float g, float b, float a);
 extern void ClearScreen();
+/**
+ * \brief Clear only the color, e.g. of a framebuffer sharing its depth
+ */
+extern void ClearColorBuffer();
 extern void EnableColorBlend();
 extern void DisableColorBlend();
 extern void BindTexture(unsigned int texture, int slot);
@@ -19,4 +23,42 @@ extern void BlitFramebuffer(int srcX0, int srcY0, int srcX1, int srcY1, int dstX
 extern void EnableCullFace();
 extern void DisableCullFace();
 extern void SetCullFace(int face);
-extern void SetWindingOrder(int order);
\ No newline at end of file
+extern void SetWindingOrder(int order);
+extern void SetDepthFunc(GLenum func);
+extern void SetDepthMask(bool write);
+/**
+ * \brief Enable or disable the writes to every color channel of every draw buffer
+ */
+extern void SetColorMask(bool write);
+/**
+ * \brief Whether the context exposes the extension, e.g. "GL_ARB_shader_viewport_layer_array"
+ */
+extern bool HasExtension(const char* name);
+
+/**
+ * \brief The binding and enable state is set through these functions, which remember what is bound and skip the calls that wouldn't change it.
+ * Objects must be deleted through the Delete functions below so that a name reused by the driver isn't mistaken for a bound one
+ */
+extern void UseProgram(unsigned int program);
+extern void BindVertexArray(unsigned int vao);
+/**
+ * \brief GL_ELEMENT_ARRAY_BUFFER is part of the VAO state, it is forgotten when the VAO changes
+ */
+extern void BindBuffer(GLenum target, unsigned int buffer);
+/**
+ * \brief Always issued, the indexed bindings aren't tracked. Like in OpenGL, they also bind the buffer to the generic target
+ */
+extern void BindBufferBase(GLenum target, unsigned int index, unsigned int buffer);
+extern void BindBufferRange(GLenum target, unsigned int index, unsigned int buffer, GLintptr offset, GLsizeiptr size);
+extern void BindTextureTarget(GLenum target, unsigned int texture, int slot);
+extern void SetViewport(int x, int y, int width, int height);
+
+extern void DeleteBuffers(int count, const unsigned int* buffers);
+extern void DeleteVertexArrays(int count, const unsigned int* vaos);
+extern void DeleteTextures(int count, const unsigned int* textures);
+extern void DeleteFramebuffers(int count, const unsigned int* framebuffers);
+
+/**
+ * \brief Forget the cached state, the next call of each kind is issued. Needed after code that changes the state behind the cache (ImGui)
+ */
+extern void InvalidateGLState();
\ No newline at end of file
@@ -0,0 +1,148 @@
+#include <PersistentBlock.hpp>
+#include <OpenGL.hpp>
+#include <Log.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+static constexpr GLbitfield PERSISTENT_FLAGS = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+void PersistentBlock::Init(GLenum target, unsigned int binding, size_t size)
+{
+    m_Target = target;
+    m_Binding = binding;
+    m_Copy = 0;
+
+    Allocate(size);
+}
+
+void PersistentBlock::Deinit()
+{
+    for(GLsync& fence : m_Fences){
+        if(fence){
+            glDeleteSync(fence);
+            fence = nullptr;
+        }
+    }
+
+    if(m_Buffer){
+        BindBuffer(m_Target, m_Buffer);
+        glUnmapBuffer(m_Target);
+        BindBuffer(m_Target, 0);
+        DeleteBuffers(1, &m_Buffer);
+    }
+
+    m_Buffer = 0;
+    m_Mapped = nullptr;
+    m_Size = 0;
+    m_Stride = 0;
+
+    for(auto& mirror : m_Mirrors){
+        mirror.clear();
+    }
+}
+
+void PersistentBlock::Allocate(size_t size)
+{
+    int alignment = 0;
+    glGetIntegerv(m_Target == GL_UNIFORM_BUFFER ? GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT : GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    alignment = std::max(alignment, 1);
+
+    size_t stride = (size + alignment - 1) / alignment * alignment;
+
+    unsigned int buffer;
+    glGenBuffers(1, &buffer);
+    BindBuffer(m_Target, buffer);
+    glBufferStorage(m_Target, stride * BLOCK_FRAME_COPIES, nullptr, PERSISTENT_FLAGS);
+    uint8_t* mapped = (uint8_t*)glMapBufferRange(m_Target, 0, stride * BLOCK_FRAME_COPIES, PERSISTENT_FLAGS);
+
+    if(!mapped){
+        LogError("Couldn't map the buffer of a block of %zu bytes", size);
+    }
+
+    // the copies keep their content, the new space is zeroed like the mirrors
+    for(unsigned int i = 0; i < BLOCK_FRAME_COPIES; i++){
+        m_Mirrors[i].resize(size, 0);
+
+        if(mapped){
+            memcpy(mapped + i * stride, m_Mirrors[i].data(), size);
+        }
+    }
+
+    if(m_Buffer){
+        BindBuffer(m_Target, m_Buffer);
+        glUnmapBuffer(m_Target);
+        DeleteBuffers(1, &m_Buffer); // the driver keeps it alive while the frames in flight read it
+    }
+
+    // the GPU doesn't use the new buffer yet
+    for(GLsync& fence : m_Fences){
+        if(fence){
+            glDeleteSync(fence);
+            fence = nullptr;
+        }
+    }
+
+    BindBuffer(m_Target, 0);
+
+    m_Buffer = buffer;
+    m_Mapped = mapped;
+    m_Size = size;
+    m_Stride = stride;
+}
+
+void PersistentBlock::Begin()
+{
+    m_Copy = (m_Copy + 1) % BLOCK_FRAME_COPIES;
+
+    GLsync& fence = m_Fences[m_Copy];
+
+    if(fence){
+        GLenum result;
+        do{
+            result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000); // 1 ms
+        }while(result == GL_TIMEOUT_EXPIRED);
+
+        if(result == GL_WAIT_FAILED){
+            LogError("Waiting for a block fence failed");
+        }
+
+        glDeleteSync(fence);
+        fence = nullptr;
+    }
+}
+
+bool PersistentBlock::Write(size_t offset, const void* data, size_t size)
+{
+    if(offset + size > m_Size){
+        Allocate(std::max(offset + size, m_Size * 2));
+    }
+
+    uint8_t* mirror = m_Mirrors[m_Copy].data() + offset;
+
+    if(memcmp(mirror, data, size) == 0){
+        return false;
+    }
+
+    memcpy(mirror, data, size);
+
+    if(m_Mapped){
+        memcpy(m_Mapped + m_Copy * m_Stride + offset, data, size);
+    }
+
+    return true;
+}
+
+void PersistentBlock::Bind() const
+{
+    BindBufferRange(m_Target, m_Binding, m_Buffer, m_Copy * m_Stride, m_Size);
+}
+
+void PersistentBlock::End()
+{
+    if(m_Fences[m_Copy]){
+        glDeleteSync(m_Fences[m_Copy]);
+    }
+
+    m_Fences[m_Copy] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
\ No newline at end of file
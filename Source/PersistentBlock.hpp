@@ -0,0 +1,65 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#include <glad/glad.h>
+
+inline constexpr unsigned int BLOCK_FRAME_COPIES = 3; // frames the GPU can be behind
+
+/**
+ * \brief A uniform or storage block in a persistently mapped buffer. There is a copy of the block for each frame in flight,
+ * so the CPU never writes the copy the GPU is reading. Each copy remembers what was written in it, and only the bytes
+ * that changed since then are stored
+ */
+class PersistentBlock{
+public:
+    PersistentBlock() = default;
+    ~PersistentBlock() = default;
+
+    /**
+     * \param target GL_UNIFORM_BUFFER or GL_SHADER_STORAGE_BUFFER
+     * \param size initial size of the block in bytes, it grows when a write goes past the end
+     */
+    void Init(GLenum target, unsigned int binding, size_t size);
+    void Deinit();
+
+    /**
+     * \brief Move to the next copy, waiting for the GPU to finish the frame that last used it
+     */
+    void Begin();
+
+    /**
+     * \brief Store the data in the current copy if it differs from what the copy holds
+     * \return true if something was written
+     */
+    bool Write(size_t offset, const void* data, size_t size);
+
+    /**
+     * \brief Bind the current copy to the block binding
+     */
+    void Bind() const;
+
+    /**
+     * \brief Fence the current copy after the last draw that reads it
+     */
+    void End();
+
+    inline size_t GetSize() const { return m_Size; }
+
+private:
+    void Allocate(size_t size);
+
+    GLenum m_Target = GL_UNIFORM_BUFFER;
+    unsigned int m_Binding = 0;
+    unsigned int m_Buffer = 0;
+    uint8_t* m_Mapped = nullptr;
+
+    size_t m_Size = 0; // size of the block
+    size_t m_Stride = 0; // size of the block aligned to the buffer offset alignment
+    unsigned int m_Copy = 0;
+
+    std::vector<uint8_t> m_Mirrors[BLOCK_FRAME_COPIES]; // what was written in each copy
+    GLsync m_Fences[BLOCK_FRAME_COPIES] = {};
+};
\ No newline at end of file
@@ -3,6 +3,8 @@
 #include <Bloom.hpp>
 #include <OpenGL.hpp>
 #include <Renderer.hpp>
+#include <DynamicResolution.hpp>
+#include <Globals.hpp>
 
 #include <limits> 
 
@@ -37,6 +39,8 @@ void PostProcessingPass()
     }
 
     GetShader(g_PostProcessingShader)->Bind();
+    // the scene fills only the scaled corner of the deferred and bloom targets, it is stretched over the window
+    GetShader(g_PostProcessingShader)->SetUniform2f("renderScale", (float)GetRenderWidth() / g_ScreenWidth, (float)GetRenderHeight() / g_ScreenHeight);
     DrawFullscreenQuad();
 }
 
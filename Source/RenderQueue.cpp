@@ -0,0 +1,365 @@
+#include <RenderQueue.hpp>
+#include <Model.hpp>
+#include <Animator.hpp>
+#include <BVH.hpp>
+#include <StreamBuffer.hpp>
+#include <Globals.hpp>
+
+#include <algorithm>
+#include <limits>
+#include <cstring>
+
+// key layout, from the most significant bits
+static constexpr int PASS_BITS = 4;
+static constexpr int SHADER_BITS = 6;
+static constexpr int ANIMATOR_BITS = 6;
+static constexpr int MATERIAL_BITS = 16;
+static constexpr int MESH_BITS = 16;
+static constexpr int DEPTH_BITS = 16;
+
+static constexpr int DEPTH_SHIFT = 0;
+static constexpr int MESH_SHIFT = DEPTH_SHIFT + DEPTH_BITS;
+static constexpr int MATERIAL_SHIFT = MESH_SHIFT + MESH_BITS;
+static constexpr int ANIMATOR_SHIFT = MATERIAL_SHIFT + MATERIAL_BITS;
+static constexpr int SHADER_SHIFT = ANIMATOR_SHIFT + ANIMATOR_BITS;
+static constexpr int PASS_SHIFT = SHADER_SHIFT + SHADER_BITS;
+
+static_assert(PASS_SHIFT + PASS_BITS == 64, "the key fields must fill 64 bits");
+
+static constexpr UniformHandle IS_PLAYING("isPlaying");
+static constexpr UniformHandle OBJECT_ID("id");
+static constexpr UniformHandle LOD_COLOR("lodColor");
+
+struct StateChanges{
+    bool shader;
+    bool animator;
+    bool material;
+    bool geometry; // the geometry chunk, the meshes of a chunk share the bound buffers
+    bool object;
+    bool lod;
+};
+
+static StateChanges GetStateChanges(const DrawItem* last, const DrawItem& item)
+{
+    if(!last){
+        return {true, true, item.material != 0, true, true, true};
+    }
+
+    return {last->shader != item.shader, last->animator != item.animator, last->material != item.material, last->geometry_chunk != item.geometry_chunk,
+            last->object_id != item.object_id, last->lod != item.lod};
+}
+
+static bool IsPickingItem(const DrawItem& item)
+{
+    return (item.key >> PASS_SHIFT) == RENDER_PASS_PICKING;
+}
+
+static bool IsGBufferItem(const DrawItem& item)
+{
+    return (item.key >> PASS_SHIFT) == RENDER_PASS_GBUFFER;
+}
+
+/**
+ * \brief Give the next free id to a new value. When the field is full the ids are reassigned from scratch
+ */
+template<typename T>
+static uint64_t GetFieldID(std::unordered_map<T, uint64_t>& ids, const T& value, int bits, uint64_t first_id = 0)
+{
+    auto it = ids.find(value);
+    if(it != ids.end()){
+        return it->second;
+    }
+
+    if(ids.size() + first_id >= (1ull << bits)){
+        ids.clear();
+    }
+
+    uint64_t id = ids.size() + first_id;
+    ids[value] = id;
+    return id;
+}
+
+void RenderQueue::Clear()
+{
+    m_Items.clear();
+    m_Instances.clear();
+    m_ProxyLODs.clear();
+}
+
+uint64_t RenderQueue::GetShaderID(const Shader& shader)
+{
+    return GetFieldID(m_ShaderIDs, shader.GetID(), SHADER_BITS);
+}
+
+uint64_t RenderQueue::GetAnimatorID(Animator* animator)
+{
+    if(!animator){ // static models first
+        return 0;
+    }
+
+    return GetFieldID(m_AnimatorIDs, animator, ANIMATOR_BITS, 1);
+}
+
+uint64_t RenderQueue::GetMaterialID(uint64_t material_hash)
+{
+    return GetFieldID(m_MaterialIDs, material_hash, MATERIAL_BITS);
+}
+
+uint64_t RenderQueue::GetMeshID(uint64_t geometry)
+{
+    return GetFieldID(m_MeshIDs, geometry, MESH_BITS);
+}
+
+void RenderQueue::AddItem(RenderPass pass, Shader& shader, Model& model, Animator* animator, uint32_t mesh_index, uint32_t lod, uint32_t first_instance, float min_distance, float max_distance, uint32_t object_id)
+{
+    const Mesh& mesh = model.GetMeshes()[mesh_index];
+
+    uint64_t shader_id = GetShaderID(shader);
+    uint64_t animator_id = GetAnimatorID(animator);
+
+    // only the G-buffer pass uses the textures, in the others the material doesn't split the batches
+    uint64_t material = (pass == RENDER_PASS_GBUFFER) ? mesh.GetMaterialHash() : 0;
+    uint64_t material_id = (pass == RENDER_PASS_GBUFFER) ? GetMaterialID(material) : 0;
+    const GeometryRange& geometry = mesh.GetGeometry();
+    uint64_t mesh_id = GetMeshID(((uint64_t)geometry.chunk << 32) | mesh.GetLOD(lod).first_index);
+    uint64_t depth = (uint64_t)(std::clamp(min_distance / max_distance, 0.0f, 1.0f) * ((1 << DEPTH_BITS) - 1)); // front to back
+
+    uint64_t key = ((uint64_t)pass << PASS_SHIFT) | (shader_id << SHADER_SHIFT) | (animator_id << ANIMATOR_SHIFT) |
+                   (material_id << MATERIAL_SHIFT) | (mesh_id << MESH_SHIFT) | (depth << DEPTH_SHIFT);
+
+    uint32_t instance_count = (uint32_t)m_Instances.size() - first_instance;
+
+    m_Items.push_back({key, &shader, &model, animator, mesh_index, lod, first_instance, instance_count, material, geometry.chunk, object_id});
+}
+
+void RenderQueue::AddProxies(RenderPass pass, Shader& shader, const BVH& tree, const std::vector<int>& proxies, glm::vec3 eye, float max_distance, const LODSelection& lod_selection)
+{
+    m_ProxyLODs.clear();
+    SelectLODs(tree, proxies, eye, max_distance, lod_selection, 0);
+    GroupProxies(pass, shader, tree);
+}
+
+void RenderQueue::AddLayerProxies(const BVH& tree, const std::vector<int>& proxies, glm::vec3 eye, float max_distance, const LODSelection& lod_selection, uint32_t layer)
+{
+    SelectLODs(tree, proxies, eye, max_distance, lod_selection, layer);
+}
+
+void RenderQueue::AddLayers(RenderPass pass, Shader& shader, const BVH& tree)
+{
+    GroupProxies(pass, shader, tree);
+    m_ProxyLODs.clear();
+}
+
+void RenderQueue::SelectLODs(const BVH& tree, const std::vector<int>& proxies, glm::vec3 eye, float max_distance, const LODSelection& lod_selection, uint32_t layer)
+{
+    for(int proxy_id : proxies){
+        const BVHProxy& proxy = tree.GetProxyData(proxy_id);
+        const Mesh& mesh = proxy.model->GetMeshes()[proxy.mesh_index];
+        uint32_t lod_count = mesh.GetLODCount();
+        uint32_t lod = 0;
+
+        if(lod_count > 1){
+            float size = GetProjectedSize(proxy.model->GetWorldOBB(proxy.transform_index, proxy.mesh_index), lod_selection.eye, lod_selection.projection_scale);
+
+            if(lod_selection.hysteresis){
+                uint8_t& selected = proxy.model->GetSelectedLOD(proxy.transform_index, proxy.mesh_index);
+                selected = SelectLOD(size, lod_count, selected);
+                lod = selected;
+            }else{
+                lod = SelectLOD(size, lod_count);
+            }
+
+            lod = std::min(lod + lod_selection.bias, lod_count - 1);
+        }
+
+        float distance = glm::length(proxy.model->GetWorldOBB(proxy.transform_index, proxy.mesh_index).center - eye);
+        m_ProxyLODs.push_back({proxy_id, lod, layer, distance / max_distance});
+    }
+}
+
+void RenderQueue::GroupProxies(RenderPass pass, Shader& shader, const BVH& tree)
+{
+    // group the instances of the same mesh and LOD
+    std::sort(m_ProxyLODs.begin(), m_ProxyLODs.end(), [&tree](const ProxyLOD& a, const ProxyLOD& b){
+        const BVHProxy& pa = tree.GetProxyData(a.proxy);
+        const BVHProxy& pb = tree.GetProxyData(b.proxy);
+
+        if(pa.model != pb.model) return pa.model < pb.model;
+        if(pa.mesh_index != pb.mesh_index) return pa.mesh_index < pb.mesh_index;
+        if(a.lod != b.lod) return a.lod < b.lod;
+        if(pa.transform_index != pb.transform_index) return pa.transform_index < pb.transform_index;
+        return a.layer < b.layer;
+    });
+
+    size_t i = 0;
+
+    while(i < m_ProxyLODs.size()){
+        const BVHProxy& first = tree.GetProxyData(m_ProxyLODs[i].proxy);
+        uint32_t lod = m_ProxyLODs[i].lod;
+        uint32_t first_instance = (uint32_t)m_Instances.size();
+        float min_depth = std::numeric_limits<float>::max();
+
+        for(; i < m_ProxyLODs.size(); i++){
+            const BVHProxy& proxy = tree.GetProxyData(m_ProxyLODs[i].proxy);
+
+            if(proxy.model != first.model || proxy.mesh_index != first.mesh_index || m_ProxyLODs[i].lod != lod){
+                break;
+            }
+
+            InstanceData instance = proxy.model->GetInstanceData(proxy.transform_index);
+            instance.normal[3].x = (float)m_ProxyLODs[i].layer;
+            m_Instances.push_back(instance);
+            min_depth = std::min(min_depth, m_ProxyLODs[i].depth);
+        }
+
+        AddItem(pass, shader, *first.model, first.animator, first.mesh_index, lod, first_instance, min_depth, 1.0f, 0);
+    }
+}
+
+void RenderQueue::AddModel(RenderPass pass, Shader& shader, Model& model, Animator* animator, uint32_t object_id)
+{
+    uint32_t instance_count = model.GetInstanceCount();
+
+    if(instance_count == 0){
+        return;
+    }
+
+    for(uint32_t j = 0; j < model.GetMeshes().size(); j++){
+        uint32_t first_instance = (uint32_t)m_Instances.size();
+
+        for(uint32_t i = 0; i < instance_count; i++){
+            m_Instances.push_back(model.GetInstanceData(i));
+        }
+
+        AddItem(pass, shader, model, animator, j, 0, first_instance, 0.0f, 1.0f, object_id);
+    }
+}
+
+void RenderQueue::Sort()
+{
+    #ifdef DEBUG
+        m_StateChangesUnsorted = CountStateChanges();
+    #endif
+
+    RadixSort();
+
+    #ifdef DEBUG
+        m_StateChanges = CountStateChanges();
+
+        m_Triangles = 0;
+        for(const DrawItem& item : m_Items){
+            m_Triangles += item.model->GetMeshes()[item.mesh_index].GetLOD(item.lod).index_count / 3 * item.instance_count;
+        }
+    #endif
+}
+
+void RenderQueue::RadixSort()
+{
+    m_SortBuffer.resize(m_Items.size());
+
+    for(int shift = 0; shift < 64; shift += 8){
+        uint32_t offsets[256] = {0};
+
+        for(const DrawItem& item : m_Items){
+            offsets[(item.key >> shift) & 0xFF]++;
+        }
+
+        if(m_Items.empty() || offsets[(m_Items[0].key >> shift) & 0xFF] == m_Items.size()){
+            continue;
+        }
+
+        uint32_t sum = 0;
+        for(int i = 0; i < 256; i++){
+            uint32_t count = offsets[i];
+            offsets[i] = sum;
+            sum += count;
+        }
+
+        for(const DrawItem& item : m_Items){
+            m_SortBuffer[offsets[(item.key >> shift) & 0xFF]++] = item;
+        }
+
+        std::swap(m_Items, m_SortBuffer);
+    }
+}
+
+uint32_t RenderQueue::CountStateChanges() const
+{
+    uint32_t changes = 0;
+
+    for(size_t i = 0; i < m_Items.size(); i++){
+        StateChanges changed = GetStateChanges((i == 0) ? nullptr : &m_Items[i - 1], m_Items[i]);
+        changes += changed.shader + changed.animator + changed.material + changed.geometry + (IsPickingItem(m_Items[i]) && changed.object);
+    }
+
+    return changes;
+}
+
+void RenderQueue::Submit()
+{
+    Draw(nullptr, nullptr);
+}
+
+void RenderQueue::Submit(UniformHandle matrix_uniform, const glm::mat4& matrix)
+{
+    Draw(&matrix_uniform, &matrix);
+}
+
+void RenderQueue::Draw(const UniformHandle* matrix_uniform, const glm::mat4* matrix)
+{
+    if(m_Items.empty()){
+        return;
+    }
+
+    #ifdef DEBUG
+        state_changes_unsorted += m_StateChangesUnsorted;
+        state_changes += m_StateChanges;
+        triangles += m_Triangles;
+    #endif
+
+    // aligned to the instance size so the items can start at base instance offset / stride
+    StreamAllocation alloc = StreamAllocate(m_Instances.size() * sizeof(InstanceData), sizeof(InstanceData));
+    memcpy(alloc.data, m_Instances.data(), m_Instances.size() * sizeof(InstanceData));
+    uint32_t base_instance = alloc.offset / sizeof(InstanceData);
+
+    for(size_t i = 0; i < m_Items.size(); i++){
+        const DrawItem& item = m_Items[i];
+        const Mesh& mesh = item.model->GetMeshes()[item.mesh_index];
+        StateChanges changed = GetStateChanges((i == 0) ? nullptr : &m_Items[i - 1], item);
+
+        if(changed.shader){
+            item.shader->Bind();
+
+            if(matrix_uniform){
+                item.shader->SetUniformMat4fv(*matrix_uniform, *matrix);
+            }
+        }
+
+        // the uniforms belong to the program, so they are set again when the shader changes
+        if(changed.shader || changed.animator){
+            if(item.animator){ // every instance of a skinned model shares the same pose
+                item.animator->UploadFinalBoneMatrices(*item.shader);
+            }else{
+                item.shader->SetUniform1i(IS_PLAYING, 0);
+            }
+        }
+
+        if(item.material != 0 && (changed.shader || changed.material)){
+            mesh.BindTextures(*item.shader);
+        }
+
+        if(IsPickingItem(item) && (changed.shader || changed.object)){
+            item.shader->SetUniform1ui(OBJECT_ID, item.object_id);
+        }
+
+        if(IsGBufferItem(item) && (changed.shader || changed.lod)){
+            item.shader->SetUniform1i(LOD_COLOR, GetShowLODs() ? (int)item.lod : -1);
+        }
+
+        if(changed.geometry){
+            mesh.BindGeometry();
+        }
+
+        mesh.DrawInstances(alloc.buffer, base_instance + item.first_instance, item.instance_count, item.lod);
+    }
+}
\ No newline at end of file
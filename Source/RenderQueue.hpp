@@ -0,0 +1,141 @@
+#pragma once
+
+#include <Shader.hpp>
+#include <Mesh.hpp>
+#include <LOD.hpp>
+
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include <glm.hpp>
+
+class Model;
+class Animator;
+class BVH;
+
+enum RenderPass{
+    RENDER_PASS_GBUFFER = 0,
+    RENDER_PASS_SHADOW = 1,
+    RENDER_PASS_PICKING = 2,
+    RENDER_PASS_DEPTH = 3 // depth pre-pass of the camera view
+};
+
+/**
+ * \brief A range of instances of one mesh. The key sorts by (from the most significant bits) pass, shader, animator, material, mesh and depth
+ */
+struct DrawItem{
+    uint64_t key;
+    Shader* shader;
+    Model* model;
+    Animator* animator; // nullptr for static models
+    uint32_t mesh_index;
+    uint32_t lod;
+    uint32_t first_instance; // in the instances of the queue
+    uint32_t instance_count;
+
+    // the state itself, compared at submission so a reused id can't skip a bind
+    uint64_t material; // 0 when the pass doesn't use the textures
+    uint32_t geometry_chunk; // the meshes of a chunk share the vertex and index buffers
+    uint32_t object_id; // "id" uniform of the picking pass
+};
+
+/**
+ * \brief Command list of one pass: the instance data and the sorted draws. Everything up to Sort touches no OpenGL state,
+ * so a queue can be built on a worker thread and submitted on the main thread
+ */
+class RenderQueue{
+public:
+    RenderQueue() = default;
+    ~RenderQueue() = default;
+
+    void Clear();
+
+    /**
+     * \brief Queue the (transform, mesh) pairs of the scene tree proxies. The instances of the same mesh and LOD of a model become one instanced draw
+     * \param eye used to find the nearest instance of each draw
+     * \param max_distance distance mapped to the last depth bucket, farther instances are clamped
+     * \param lod_selection how the LOD of each instance is chosen from its size on the screen
+     */
+    void AddProxies(RenderPass pass, Shader& shader, const BVH& tree, const std::vector<int>& proxies, glm::vec3 eye, float max_distance, const LODSelection& lod_selection);
+    /**
+     * \brief Queue the proxies of one view of a layered pass, their instances are drawn into the layer. Nothing is drawn until AddLayers
+     * \param layer stored in the instances, the shader looks the layer and viewport of the view up with it (see GetShadowViewIndex)
+     */
+    void AddLayerProxies(const BVH& tree, const std::vector<int>& proxies, glm::vec3 eye, float max_distance, const LODSelection& lod_selection, uint32_t layer);
+    /**
+     * \brief Queue the proxies added with AddLayerProxies. The instances of the same mesh and LOD of all the layers become one instanced draw,
+     * the shader reads the layer of each instance
+     */
+    void AddLayers(RenderPass pass, Shader& shader, const BVH& tree);
+    /**
+     * \brief Queue every instance of every mesh of the model at full detail, in transform order so the shader gets the transform index from gl_InstanceID
+     * \param object_id set as the "id" uniform, used by the picking pass
+     */
+    void AddModel(RenderPass pass, Shader& shader, Model& model, Animator* animator, uint32_t object_id = 0);
+
+    /**
+     * \brief Sort the items by key. Call once every item is queued
+     */
+    void Sort();
+
+    /**
+     * \brief Copy the instances to the stream buffer, then draw the items binding only the state that changes between consecutive items.
+     * Main thread only
+     */
+    void Submit();
+    /**
+     * \brief Submit setting a matrix once for each shader, e.g. "lightSpaceMatrix" for the shadow maps
+     */
+    void Submit(UniformHandle matrix_uniform, const glm::mat4& matrix);
+
+    inline size_t Size() const { return m_Items.size(); }
+    inline size_t GetInstanceCount() const { return m_Instances.size(); }
+
+private:
+    struct ProxyLOD{
+        int proxy;
+        uint32_t lod;
+        uint32_t layer;
+        float depth; // distance from the eye of its view over the max distance
+    };
+
+    void SelectLODs(const BVH& tree, const std::vector<int>& proxies, glm::vec3 eye, float max_distance, const LODSelection& lod_selection, uint32_t layer);
+    /**
+     * \brief Sort m_ProxyLODs and add an item for each run of the same model, mesh and LOD
+     */
+    void GroupProxies(RenderPass pass, Shader& shader, const BVH& tree);
+
+    void AddItem(RenderPass pass, Shader& shader, Model& model, Animator* animator, uint32_t mesh_index, uint32_t lod, uint32_t first_instance, float min_distance, float max_distance, uint32_t object_id);
+    void Draw(const UniformHandle* matrix_uniform, const glm::mat4* matrix);
+    /**
+     * \brief LSD radix sort on the keys, 8 bits per pass. The passes where every key has the same byte are skipped
+     */
+    void RadixSort();
+    /**
+     * \brief Number of shader, animator, material and geometry changes needed to draw the items in their current order
+     */
+    uint32_t CountStateChanges() const;
+
+    uint64_t GetShaderID(const Shader& shader);
+    uint64_t GetAnimatorID(Animator* animator);
+    uint64_t GetMaterialID(uint64_t material_hash);
+    uint64_t GetMeshID(uint64_t geometry);
+
+    std::vector<DrawItem> m_Items;
+    std::vector<DrawItem> m_SortBuffer;
+    std::vector<InstanceData> m_Instances; // the instances of each item are contiguous
+    std::vector<ProxyLOD> m_ProxyLODs;
+
+    #ifdef DEBUG
+        // counted while sorting, added to the global counters at submission so the workers don't share them
+        uint32_t m_StateChanges = 0;
+        uint32_t m_StateChangesUnsorted = 0;
+        uint32_t m_Triangles = 0;
+    #endif
+
+    // small ids for the key fields. they are kept between frames so the order stays stable
+    std::unordered_map<int, uint64_t> m_ShaderIDs;
+    std::unordered_map<Animator*, uint64_t> m_AnimatorIDs;
+    std::unordered_map<uint64_t, uint64_t> m_MaterialIDs;
+    std::unordered_map<uint64_t, uint64_t> m_MeshIDs;
+};
\ No newline at end of file
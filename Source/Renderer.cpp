@@ -4,10 +4,12 @@
 #include <Shader.hpp>
 #include <Camera.hpp>
 #include <GPUBuffer.hpp>
+#include <StreamBuffer.hpp>
+
+#include <cstring>
 
 static GPUBuffer g_FullscreenQuadBuffer;
-static GPUBuffer g_TextureBuffer;
-static GPUBuffer g_LineBuffer;
+static unsigned int g_TextureVAO = 0; // vertices read from the stream buffer
 static GPUBuffer g_CubeBuffer;
 static Framebuffer g_DeferredPassFramebuffer;
 
@@ -113,15 +115,17 @@ void InitRenderer()
     g_FullscreenQuadBuffer.AddAttribute(2, GL_FLOAT, 4 * sizeof(float));
 
     g_TextureShader.Load("Resources/Shaders/Texture.vert", "Resources/Shaders/Texture.frag");
-    g_TextureBuffer.Init(6, 4 * sizeof(float), 0);
-    g_TextureBuffer.BindVBO();
-    g_TextureBuffer.AddAttribute(2, GL_FLOAT, 4 * sizeof(float));
-    g_TextureBuffer.AddAttribute(2, GL_FLOAT, 4 * sizeof(float));
+    glGenVertexArrays(1, &g_TextureVAO);
+    BindVertexArray(g_TextureVAO);
+    glEnableVertexAttribArray(0);
+    glVertexAttribFormat(0, 2, GL_FLOAT, GL_FALSE, 0);
+    glVertexAttribBinding(0, 0);
+    glEnableVertexAttribArray(1);
+    glVertexAttribFormat(1, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float));
+    glVertexAttribBinding(1, 0);
 
     g_SolidShapeShader.Load("Resources/Shaders/SolidShape.vert", "Resources/Shaders/SolidShape.frag");
-    g_LineBuffer.Init(2, 3 * sizeof(float), 0);
-    g_LineBuffer.BindVBO();
-    g_LineBuffer.AddAttribute(3, GL_FLOAT, 3 * sizeof(float));
+    BindVertexArray(0);
 
     g_CubeBuffer.Init(24, 3 * sizeof(float), 36);
     g_CubeBuffer.SetData(0, (void*) cubeData, 24, 3 * sizeof(float));
@@ -130,13 +134,13 @@ void InitRenderer()
 
     g_DeferredPassFramebuffer.Init(g_ScreenWidth, g_ScreenHeight);
     g_GBuffer.Init(g_ScreenWidth, g_ScreenHeight);
+    g_DeferredPassFramebuffer.SetDepthTexture(g_GBuffer.GetDepthTexture());
 }
 
 void DeinitRenderer()
 {
     g_FullscreenQuadBuffer.Free();
-    g_TextureBuffer.Free();
-    g_LineBuffer.Free();
+    DeleteVertexArrays(1, &g_TextureVAO);
     g_TextureShader.Unload();
     g_SolidShapeShader.Unload();
 
@@ -155,59 +159,28 @@ void UpdateView(glm::mat4 view)
 
 void DeferredPass(GBuffer& gBuffer, Shader& deferredShader, Camera& camera)
 {
-    switch(g_DeferredMode){
-        case DEFERRED_SHADING:
-        {
-            g_DeferredPassFramebuffer.Bind();
-            ClearScreen();
-
-            DisableColorBlend();
-            DisableDepthTest();
-            
-            deferredShader.Bind();
-            BindTexture(gBuffer.GetPositionTexture(), 0);
-            BindTexture(gBuffer.GetNormalTexture(), 1);
-            BindTexture(gBuffer.GetAlbedoTexture(), 2);
-
-            DrawFullscreenQuad();
-            
-            EnableColorBlend();
-            EnableDepthTest();
-
-            // As a last step, we now copy over the depth buffer from our g-buffer to the default framebuffer.
-            BindFramebuffer(GL_READ_FRAMEBUFFER, gBuffer.GetFBO());
-            BindFramebuffer(GL_DRAW_FRAMEBUFFER, g_DeferredPassFramebuffer.GetFBO());
-            BlitFramebuffer(0, 0, g_ScreenWidth, g_ScreenHeight, 0, 0, g_ScreenWidth, g_ScreenHeight, GL_DEPTH_BUFFER_BIT);
-        } break;
-        case DEFERRED_POSITION:
-        {
-            UnbindFramebuffer();
-            DisableColorBlend();
-            DisableDepthTest();
-            DrawTexture(gBuffer.GetPositionTexture(), -1.0f, -1.0f, 2.0f, 2.0f);
-            EnableColorBlend();
-            EnableDepthTest();
-        } break;
-        case DEFERRED_NORMAL:
-        {
-            UnbindFramebuffer();
-            DisableColorBlend();
-            DisableDepthTest();
-            DrawTexture(gBuffer.GetNormalTexture(), -1.0f, -1.0f, 2.0f, 2.0f);    
-            EnableColorBlend();
-            EnableDepthTest();
-        } break;
-        case DEFERRED_ALBEDO:
-        {
-            UnbindFramebuffer();
-            DisableColorBlend();
-            DisableDepthTest();
-            DrawTexture(gBuffer.GetAlbedoTexture(), -1.0f, -1.0f, 2.0f, 2.0f);    
-            EnableColorBlend();
-            EnableDepthTest();
-        } break;
-        default: break;
-    }
+    // the debug views are decoded from the G-buffer by the deferred shader too, the positions and normals aren't stored as they are shown
+    g_DeferredPassFramebuffer.SetDepthTexture(gBuffer.GetDepthTexture());
+    g_DeferredPassFramebuffer.Bind();
+    ClearColorBuffer(); // the depth is the one of the G-buffer
+
+    DisableColorBlend();
+    DisableDepthTest();
+    SetDepthMask(false); // the depth texture is sampled while attached
+
+    deferredShader.Bind();
+    deferredShader.SetUniform1i("deferredMode", g_DeferredMode);
+    deferredShader.SetUniformMat4fv("inverseViewProjection", glm::inverse(camera.GetProjectionMatrix() * camera.GetViewMatrix()));
+    BindTexture(gBuffer.GetDepthTexture(), 0);
+    BindTexture(gBuffer.GetNormalTexture(), 1);
+    BindTexture(gBuffer.GetAlbedoTexture(), 2);
+    BindTexture(gBuffer.GetMaterialTexture(), 5);
+
+    DrawFullscreenQuad();
+
+    SetDepthMask(true);
+    EnableColorBlend();
+    EnableDepthTest();
 }
 
 void DrawFullscreenQuad()
@@ -223,26 +196,6 @@ Framebuffer& GetDeferredPassFramebuffer()
     return g_DeferredPassFramebuffer;
 }
 
-void DrawLine3D(glm::vec3 start, glm::vec3 end, glm::vec4 color)
-{
-    g_SolidShapeShader.Bind();
-    g_SolidShapeShader.SetUniform4fv("color", color, 1);
-    g_SolidShapeShader.SetUniformMat4fv("proj", g_Proj, 1);
-    g_SolidShapeShader.SetUniformMat4fv("view", g_View, 1);
-    g_SolidShapeShader.SetUniformMat4fv("model", glm::mat4(1.0f), 1);
-
-    float data[] = {
-        start.x, start.y, start.z,
-        end.x, end.y, end.z
-    };
-
-    g_LineBuffer.SetData(0, (void*) data, 2, 3 * sizeof(float));
-    g_LineBuffer.BindVAO();
-    g_LineBuffer.BindVBO();
-
-    glDrawArrays(GL_LINES, 0, 2);
-}
-
 void DrawSolidCube(glm::vec3 position, glm::vec3 scale, glm::vec4 color)
 {
     g_SolidShapeShader.Bind();
@@ -258,44 +211,8 @@ void DrawSolidCube(glm::vec3 position, glm::vec3 scale, glm::vec4 color)
     glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_INT, 0);
 }
 
-void DrawBoundingBox(glm::vec3 min, glm::vec3 max, glm::vec4 color)
-{
-    glm::vec3 vertices[] = {
-        glm::vec3(min.x, min.y, min.z),
-        glm::vec3(max.x, min.y, min.z),
-        glm::vec3(max.x, max.y, min.z),
-        glm::vec3(min.x, max.y, min.z),
-        glm::vec3(min.x, min.y, max.z),
-        glm::vec3(max.x, min.y, max.z),
-        glm::vec3(max.x, max.y, max.z),
-        glm::vec3(min.x, max.y, max.z)
-    };
-
-    DrawLine3D(vertices[0], vertices[1], color);
-    DrawLine3D(vertices[1], vertices[2], color);
-    DrawLine3D(vertices[2], vertices[3], color);
-    DrawLine3D(vertices[3], vertices[0], color);
-
-    DrawLine3D(vertices[4], vertices[5], color);
-    DrawLine3D(vertices[5], vertices[6], color);
-    DrawLine3D(vertices[6], vertices[7], color);
-    DrawLine3D(vertices[7], vertices[4], color);
-
-    DrawLine3D(vertices[0], vertices[4], color);
-    DrawLine3D(vertices[1], vertices[5], color);
-    DrawLine3D(vertices[2], vertices[6], color);
-    DrawLine3D(vertices[3], vertices[7], color);
-}
-
-void DrawBoundingBox(const AABB& box, glm::vec4 color)
-{
-    DrawBoundingBox(box.min, box.max, color);
-}
-
 void DrawTexture(unsigned int texture, float x, float y, float width, float height)
 {
-    g_TextureBuffer.BindVAO();
-    g_TextureBuffer.BindVBO();
     g_TextureShader.Bind();    
 
     BindTexture(texture, 0);
@@ -310,6 +227,10 @@ void DrawTexture(unsigned int texture, float x, float y, float width, float heig
         x + width, y + height, 1.0f, 1.0f   // Top-right
     };
 
-    g_TextureBuffer.SetData(0, (void*) data, 6, 4 * sizeof(float));
+    StreamAllocation alloc = StreamAllocate(sizeof(data));
+    memcpy(alloc.data, data, sizeof(data));
+
+    BindVertexArray(g_TextureVAO);
+    glBindVertexBuffer(0, alloc.buffer, alloc.offset, 4 * sizeof(float));
     glDrawArrays(GL_TRIANGLES, 0, 6);
 }
\ No newline at end of file
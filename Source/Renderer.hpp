@@ -6,11 +6,13 @@
 #include <BoundingBox.hpp>
 #include <Framebuffer.hpp>
 
+// must match DeferredShading.frag
 enum DeferredMode{
    DEFERRED_POSITION,
    DEFERRED_NORMAL,
    DEFERRED_ALBEDO,
-   DEFERRED_SHADING
+   DEFERRED_SHADING,
+   DEFERRED_LIGHT_HEATMAP // the shading tinted by the number of lights of each cluster
 };
 
 extern void UpdateProj(glm::mat4 proj);
@@ -23,10 +25,6 @@ extern void DrawFullscreenQuad();
 
 extern Framebuffer& GetDeferredPassFramebuffer();
 
-extern void DrawLine3D(glm::vec3 start, glm::vec3 end, glm::vec4 color);
-extern void DrawBoundingBox(glm::vec3 min, glm::vec3 max, glm::vec4 color);
-extern void DrawBoundingBox(const AABB& box, glm::vec4 color);
-
 /**
  * @brief Parameters in OpenGL coordinates ([-1, 1] range)
  */
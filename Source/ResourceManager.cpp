@@ -1,14 +1,22 @@
 #include <ResourceManager.hpp>
+#include <OpenGL.hpp>
 #include <PredefinedMeshes.hpp>
 #include <Material.hpp>
 #include <Globals.hpp>
 #include <ShadowMap.hpp>
+#include <GPUCulling.hpp>
+#include <MousePicking.hpp>
+#include <LOD.hpp>
+#include <Timer.hpp>
+#include <Log.hpp>
 
 #include <stb_image.h>
 #include <glad/glad.h>
 
+#include <cstdio>
+
 static ResourceManager g_ResourceManager;
-uint32_t g_GBufferShader, g_DeferredShader, g_ShadowMapShader, g_PointLightShadowMapShader;
+uint32_t g_GBufferShader, g_DepthPrepassShader, g_DeferredShader, g_ShadowMapShader, g_PointLightShadowMapShader, g_LayeredShadowMapShader, g_LayeredPointLightShadowMapShader;
 
 uint32_t g_Cube, g_Sphere;
 
@@ -64,10 +72,10 @@ uint32_t ResourceManager::LoadTexture(const std::string& path, const std::string
     return id;
 }
 
-uint32_t ResourceManager::LoadShader(const std::string& vertex_path, const std::string& fragment_path)
+uint32_t ResourceManager::LoadShader(const std::string& vertex_path, const std::string& fragment_path, const std::string& geometry_path)
 {
     uint32_t id = RandUint32();
-    m_Shaders[id].Load(vertex_path.c_str(), fragment_path.c_str());
+    m_Shaders[id].Load(vertex_path.c_str(), fragment_path.c_str(), geometry_path.empty() ? nullptr : geometry_path.c_str());
     return id;
 }
 
@@ -154,19 +162,29 @@ void ResourceManager::Init()
         mesh.SetMaterial(mat);
     }
 
-    m_ShadowMapArray = InitShadowMapArray(MAX_LIGHTS * 2); // directional + spot lights
-    m_CubeShadowMapArray = InitCubeShadowMapArray(MAX_LIGHTS); // point lights
+    m_ShadowMapArray = InitShadowMapArray(MAX_SHADOWED_LIGHTS * 2); // directional + spot lights
+    m_CubeShadowMapArray = InitCubeShadowMapArray(MAX_SHADOWED_LIGHTS); // point lights
+    m_StaticShadowMapArray = InitShadowMapArray(MAX_SHADOWED_LIGHTS * 2);
+    m_StaticCubeShadowMapArray = InitCubeShadowMapArray(MAX_SHADOWED_LIGHTS);
+    m_ShadowCaches.assign(MAX_SHADOWED_LIGHTS * 2 * SHADOW_CASCADE_COUNT, ShadowCache());
+    m_CubeShadowCaches.assign(MAX_SHADOWED_LIGHTS * 6, ShadowCache());
+
+    InitLayeredShadowMaps();
+    InitShadowCascadeTimers();
+
+    for(int i = 0; i < 2; i++){
+        m_LayeredShadowPasses[i].cube = (i == 1);
+        m_LayeredShadowPasses[i].layers.assign(i == 1 ? MAX_SHADOWED_LIGHTS * 6 : MAX_SHADOWED_LIGHTS * 2 * SHADOW_CASCADE_COUNT, ShadowLayerData());
+    }
 
-    glActiveTexture(GL_TEXTURE3);
-    glBindTexture(GL_TEXTURE_2D_ARRAY, m_ShadowMapArray);
-    glActiveTexture(GL_TEXTURE4);
-    glBindTexture(GL_TEXTURE_CUBE_MAP_ARRAY, m_CubeShadowMapArray);
+    BindTextureArray(m_ShadowMapArray, 3);
+    BindTextureTarget(GL_TEXTURE_CUBE_MAP_ARRAY, m_CubeShadowMapArray, 4);
 
-    for(int i = 0; i < 20; i++){
+    for(unsigned int i = 0; i < MAX_SHADOWED_LIGHTS * 2; i++){
         m_ShadowMapArrayIndices.insert(i);
     }
 
-    for(int i = 0; i < 10; i++){
+    for(unsigned int i = 0; i < MAX_SHADOWED_LIGHTS; i++){
         m_CubeShadowMapArrayIndices.insert(i);
     }
 }
@@ -203,14 +221,22 @@ void ResourceManager::Deinit()
 
     m_Models.clear();
     m_SkinnedModels.clear();
+    m_SceneTree.Clear();
     m_Textures.clear();
     m_Shaders.clear();
     m_DirectionalLights.clear();
     m_PointLights.clear();
     m_SpotLights.clear();
 
-    glDeleteTextures(1, &m_ShadowMapArray);
-    glDeleteTextures(1, &m_CubeShadowMapArray);
+    DeleteTextures(1, &m_ShadowMapArray);
+    DeleteTextures(1, &m_CubeShadowMapArray);
+    DeleteTextures(1, &m_StaticShadowMapArray);
+    DeleteTextures(1, &m_StaticCubeShadowMapArray);
+    m_ShadowCaches.clear();
+    m_CubeShadowCaches.clear();
+
+    DeinitLayeredShadowMaps();
+    DeinitShadowCascadeTimers();
 }
 
 void InitResourceManager()
@@ -234,75 +260,630 @@ void ResourceManager::HotReloadShaders()
         shader.Reload();
     }
 
-    Shader& gbuffer_s = GetGBufferShader();
-    gbuffer_s.Bind();
-    gbuffer_s.SetUniformMat4fv("projection", GetCamera().GetProjectionMatrix(), 1);
-
     Shader& deferred_s = GetDeferredShader();
     deferred_s.Bind();
-    deferred_s.SetUniform1i("Positions", 0);
+    deferred_s.SetUniform1i("Depth", 0);
     deferred_s.SetUniform1i("Normals", 1);
     deferred_s.SetUniform1i("Albedo", 2);
+    deferred_s.SetUniform1i("Material", 5);
+
+    InvalidateShadowCaches();
 }
 
-void ResourceManager::DrawModels(Shader& shader, glm::mat4 view)
+void ResourceManager::UseShadowCache(bool use)
 {
-    for(auto& [id, model] : GetModels()){
-        auto& transforms = model.GetTransforms();
+    if(use != m_UseShadowCache){
+        InvalidateShadowCaches();
+    }
+
+    m_UseShadowCache = use;
+}
+
+void ResourceManager::InvalidateShadowCaches()
+{
+    m_ShadowCachesInvalid = true;
+}
+
+ResourceManager::ShadowCache& ResourceManager::GetShadowCache(const ShadowMapLayer& layer)
+{
+    return layer.cube ? m_CubeShadowCaches[GetShadowViewIndex(layer)] : m_ShadowCaches[GetShadowViewIndex(layer)];
+}
+
+/**
+ * \brief FNV-1a over the bytes, the same as Mesh::GetMaterialHash
+ */
+static uint64_t HashBytes(const void* data, size_t size, uint64_t hash = 14695981039346656037ull)
+{
+    const uint8_t* bytes = (const uint8_t*)data;
+
+    for(size_t i = 0; i < size; i++){
+        hash = (hash ^ bytes[i]) * 1099511628211ull;
+    }
+
+    return hash;
+}
+
+/**
+ * \brief Hash of a (transform, mesh) and its revision. The keys of the shadow caches add them up, so they don't depend on the order the tree returns the proxies in
+ */
+static uint64_t HashCaster(const BVHProxy& proxy, uint32_t revision)
+{
+    uint64_t fields[3] = {(uint64_t)(uintptr_t)proxy.model, ((uint64_t)proxy.transform_index << 32) | proxy.mesh_index, revision};
+    uint64_t hash = HashBytes(fields, sizeof(fields));
+
+    // the last bytes are mixed poorly by FNV, a sum of such hashes would collide easily
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdull;
+    hash ^= hash >> 33;
 
-        for(uint32_t i = 0; i < transforms.size(); i++){
-            model.Draw(shader, view, transforms[i]);
+    return hash;
+}
+
+/**
+ * \brief Fill list.visible_proxies with the proxies in the frustum of the list. Only reads the tree and the bounds, so lists can be culled in parallel
+ */
+static void CullView(const BVH& tree, ViewDrawList& list)
+{
+    // subtrees completely inside the frustum are accepted as they are, the boxes on the border get a precise OBB test
+    tree.QueryFrustum(list.frustum, list.visible_proxies, list.intersecting_proxies, list.stack);
+
+    list.culling_batch.Clear();
+    for(int proxy_id : list.intersecting_proxies){
+        const BVHProxy& proxy = tree.GetProxyData(proxy_id);
+        list.culling_batch.Add(proxy.model->GetWorldOBB(proxy.transform_index, proxy.mesh_index));
+    }
+
+    CullBatch(list.frustum, list.culling_batch, list.visible_items);
+
+    for(uint32_t index : list.visible_items){
+        list.visible_proxies.push_back(list.intersecting_proxies[index]);
+    }
+}
+
+void ResourceManager::BuildCameraList(glm::vec3 eye)
+{
+    CullView(m_SceneTree, m_CameraList);
+
+    m_CameraList.visible = m_CameraList.visible_proxies.size();
+
+    // the view and projection come from the Camera block
+    m_CameraList.queue.Clear();
+    m_CameraList.queue.AddProxies(RENDER_PASS_GBUFFER, *m_CameraList.shader, m_SceneTree, m_CameraList.visible_proxies, eye, g_Far, m_CameraList.lod_selection);
+    m_CameraList.queue.Sort();
+
+    // selecting the LODs again gives the ones just stored, so the pre-pass draws the same triangles as the G-buffer pass
+    m_CameraList.depth_queue.Clear();
+
+    if(m_CameraList.depth_shader){
+        m_CameraList.depth_queue.AddProxies(RENDER_PASS_DEPTH, *m_CameraList.depth_shader, m_SceneTree, m_CameraList.visible_proxies, eye, g_Far, m_CameraList.lod_selection);
+        m_CameraList.depth_queue.Sort();
+    }
+}
+
+void ResourceManager::BuildShadowList(ViewDrawList& list)
+{
+    CullView(m_SceneTree, list);
+
+    if(m_ShadowListsCached){
+        BuildCachedShadowList(list);
+        return;
+    }
+
+    // keep only the casters whose shadow can reach the camera frustum, or the part of it the cascade covers
+    uint32_t casters = 0;
+
+    for(int proxy_id : list.visible_proxies){
+        const BVHProxy& proxy = m_SceneTree.GetProxyData(proxy_id);
+
+        AABB aabb = AABBFromOBB(proxy.model->GetWorldOBB(proxy.transform_index, proxy.mesh_index));
+        if(ShadowInFrustum(list.receivers, aabb.min, aabb.max, list.light)){
+            list.visible_proxies[casters++] = proxy_id;
         }
     }
 
-    for(auto& [id, skinned_model] : GetSkinnedModels()){
-        auto& transforms = skinned_model.model.GetTransforms();
+    list.visible_proxies.resize(casters);
+    list.visible = casters;
+
+    // the layered pass queues the casters of all the views of an array together
+    if(m_ShadowListsLayered){
+        return;
+    }
 
-        for(uint32_t i = 0; i < transforms.size(); i++){
-            skinned_model.animator.UploadFinalBoneMatrices(shader);
-            skinned_model.model.Draw(shader, view, transforms[i]);
+    list.queue.Clear();
+    list.queue.AddProxies(RENDER_PASS_SHADOW, *list.shader, m_SceneTree, list.visible_proxies, list.light.position, list.light.range, list.lod_selection);
+    list.queue.Sort();
+}
+
+void ResourceManager::BuildCachedShadowList(ViewDrawList& list)
+{
+    // a cached map must stay valid wherever the camera goes, so every caster in the light volume is kept
+    uint64_t static_casters = 0, dynamic_casters = 0;
+    uint32_t static_count = 0;
+    list.dynamic_proxies.clear();
+
+    for(int proxy_id : list.visible_proxies){
+        const BVHProxy& proxy = m_SceneTree.GetProxyData(proxy_id);
+        uint32_t revision = proxy.model->GetTransformRevision(proxy.transform_index);
+
+        if(proxy.animator){
+            // the pose can change every frame without the transform changing
+            dynamic_casters += HashCaster(proxy, m_Frame);
+            list.dynamic_proxies.push_back(proxy_id);
+        }else if(m_Frame - revision < DYNAMIC_CASTER_FRAMES){
+            dynamic_casters += HashCaster(proxy, revision);
+            list.dynamic_proxies.push_back(proxy_id);
+        }else{
+            static_casters += HashCaster(proxy, revision);
+            list.visible_proxies[static_count++] = proxy_id;
         }
     }
+
+    list.visible = list.visible_proxies.size();
+    list.visible_proxies.resize(static_count);
+
+    // the LODs are picked from the light, they change only with the view and the settings
+    uint64_t view_key = HashBytes(&list.view_projection, sizeof(glm::mat4));
+    view_key = HashBytes(&list.lod_selection.projection_scale, sizeof(float), view_key);
+    view_key = HashBytes(&list.lod_selection.bias, sizeof(uint32_t), view_key);
+    list.static_key = HashBytes(&static_casters, sizeof(uint64_t), view_key);
+    list.dynamic_key = HashBytes(&dynamic_casters, sizeof(uint64_t), view_key);
+
+    if(m_ShadowListsLayered){
+        return;
+    }
+
+    list.queue.Clear();
+    list.queue.AddProxies(RENDER_PASS_SHADOW, *list.shader, m_SceneTree, list.visible_proxies, list.light.position, list.light.range, list.lod_selection);
+    list.queue.Sort();
+
+    list.dynamic_queue.Clear();
+    list.dynamic_queue.AddProxies(RENDER_PASS_SHADOW, *list.shader, m_SceneTree, list.dynamic_proxies, list.light.position, list.light.range, list.lod_selection);
+    list.dynamic_queue.Sort();
 }
 
-void ResourceManager::DrawModelsShadows(Shader& shader, glm::mat4 light_space_matrix)
+void ResourceManager::BuildPickingList()
 {
-    for(auto& [id, model] : GetModels()){
-        auto& transforms = model.GetTransforms();
+    // every instance is queued in transform order, so the shader gets the transform index from gl_InstanceID
+    Shader& shader = GetMousePickingShader();
+
+    m_PickingQueue.Clear();
+
+    for(auto& [id, model] : m_Models){
+        m_PickingQueue.AddModel(RENDER_PASS_PICKING, shader, model, nullptr, id);
+    }
+
+    for(auto& [id, skinned_model] : m_SkinnedModels){
+        m_PickingQueue.AddModel(RENDER_PASS_PICKING, shader, skinned_model.model, &skinned_model.animator, id);
+    }
+
+    m_PickingQueue.Sort();
+}
+
+void ResourceManager::BuildLayeredShadowPass(LayeredShadowPass& pass)
+{
+    pass.static_queue.Clear();
+    pass.queue.Clear();
+    pass.static_lists.clear();
+    pass.live_lists.clear();
+
+    // only reads the caches, they are updated when the pass is drawn
+    for(uint32_t i = 0; i < m_ShadowListCount; i++){
+        ViewDrawList& list = m_ShadowLists[i];
+
+        if(list.layer.cube != pass.cube){
+            continue;
+        }
+
+        list.draw_static = false;
+        list.draw_live = true;
+
+        if(m_ShadowListsCached){
+            const ShadowCache& cache = GetShadowCache(list.layer);
+            list.draw_static = !cache.valid || cache.static_key != list.static_key;
+            list.draw_live = list.draw_static || cache.dynamic_key != list.dynamic_key;
+        }
+
+        if(!list.draw_live){
+            continue;
+        }
+
+        // the cascades of a layer are drawn with the viewports of their quadrants
+        uint32_t view = GetShadowViewIndex(list.layer);
+        pass.layers[view] = {list.view_projection, glm::vec4(list.light.position, 1.0f), (int)list.layer.layer, list.layer.cascade + 1};
+        pass.live_lists.push_back(i);
+
+        if(!m_ShadowListsCached){
+            pass.queue.AddLayerProxies(m_SceneTree, list.visible_proxies, list.light.position, list.light.range, list.lod_selection, view);
+            continue;
+        }
+
+        if(list.draw_static){
+            pass.static_lists.push_back(i);
+            pass.static_queue.AddLayerProxies(m_SceneTree, list.visible_proxies, list.light.position, list.light.range, list.lod_selection, view);
+        }
+
+        pass.queue.AddLayerProxies(m_SceneTree, list.dynamic_proxies, list.light.position, list.light.range, list.lod_selection, view);
+    }
+
+    pass.static_queue.AddLayers(RENDER_PASS_SHADOW, *pass.shader, m_SceneTree);
+    pass.static_queue.Sort();
+    pass.queue.AddLayers(RENDER_PASS_SHADOW, *pass.shader, m_SceneTree);
+    pass.queue.Sort();
+}
+
+ViewDrawList& ResourceManager::AddShadowList(const glm::mat4& light_space_matrix, const ShadowCasterLight& light, Shader& shader, const ShadowMapLayer& layer)
+{
+    if(m_ShadowListCount == m_ShadowLists.size()){
+        m_ShadowLists.emplace_back();
+    }
+
+    ViewDrawList& list = m_ShadowLists[m_ShadowListCount++];
+    ExtractFrustum(list.frustum, light_space_matrix);
+    list.view_projection = light_space_matrix;
+    list.light = light;
+    list.shader = &shader;
+    list.layer = layer;
+    list.receivers = g_Frustum;
+    list.cascade = -1;
+
+    return list;
+}
+
+void ResourceManager::BuildDrawLists(bool picking)
+{
+    // the cascades follow the camera, both culling paths and the deferred pass read them
+    for(auto& [id, directional_light] : GetDirectionalLights()){
+        UpdateShadowCascades(directional_light, GetCamera().GetViewMatrix(), GetCamera().GetProjectionMatrix());
+    }
+
+    // refit the instances that moved since the last frame. from here on the jobs only read the bounds and the tree
+    uint32_t rebuilt = 0;
+    m_Frame++;
+
+    if(m_ShadowCachesInvalid){
+        for(ShadowCache& cache : m_ShadowCaches){
+            cache.valid = false;
+        }
 
-        for(uint32_t i = 0; i < transforms.size(); i++){
-            model.DrawShadows(shader, light_space_matrix, transforms[i]);
+        for(ShadowCache& cache : m_CubeShadowCaches){
+            cache.valid = false;
         }
+
+        m_ShadowCachesInvalid = false;
+    }
+
+    for(auto& [id, model] : GetModels()){
+        rebuilt += model.UpdateBounds(nullptr, m_Frame);
     }
 
     for(auto& [id, skinned_model] : GetSkinnedModels()){
-        auto& transforms = skinned_model.model.GetTransforms();
+        rebuilt += skinned_model.model.UpdateBounds(&skinned_model.animator, m_Frame);
+    }
+
+    if(rebuilt > 0 || m_SceneTree.GetProxyCount() != m_LastProxyCount){
+        MarkGPUSceneDirty();
+        m_LastProxyCount = m_SceneTree.GetProxyCount();
+    }
+
+    m_Jobs.clear();
+    m_ShadowListCount = 0;
+    m_ShadowListsCached = m_UseShadowCache;
+    m_ShadowListsLayered = m_UseLayeredShadows && !GetUseGPUCulling();
+
+    // the GPU culling path culls and builds its commands in compute shaders
+    if(!GetUseGPUCulling()){
+        m_CameraList.frustum = g_Frustum;
+        m_CameraList.shader = &GetGBufferShader();
+        m_CameraList.depth_shader = m_UseDepthPrepass ? &GetDepthPrepassShader() : nullptr;
+        glm::vec3 eye = GetCamera().GetPosition();
+        // only the camera list keeps the LODs between frames, the shadow lists pick theirs from the size seen by the camera
+        m_CameraList.lod_selection = GetLODSelection(eye, 0, true);
+        m_Jobs.push_back({"GBUFFER_DRAW_LIST", [this, eye]{ BuildCameraList(eye); }});
+
+        // same order as DrawShadowMaps
+        for(auto& [id, directional_light] : GetDirectionalLights()){
+            if(directional_light.shadowMap.HasShadowMap()){
+                for(unsigned int i = 0; i < SHADOW_CASCADE_COUNT; i++){
+                    ViewDrawList& list = AddShadowList(directional_light.lightSpaceMatrix[i], GetShadowCasterLight(directional_light, i), GetShadowMapShader(), directional_light.shadowMap.GetCascadeLayer(i));
+                    list.receivers = directional_light.cascadeReceivers[i];
+                    list.cascade = i;
+                }
+            }
+        }
+
+        for(auto& [id, point_light] : GetPointLights()){
+            if(point_light.shadowMap.HasShadowMap()){
+                for(int i = 0; i < 6; i++){
+                    AddShadowList(point_light.lightSpaceMatrix[i], GetShadowCasterLight(point_light), GetPointLightShadowMapShader(), point_light.shadowMap.GetLayer(i));
+                }
+            }
+        }
+
+        for(auto& [id, spot_light] : GetSpotLights()){
+            if(spot_light.shadowMap.HasShadowMap()){
+                AddShadowList(spot_light.lightSpaceMatrix, GetShadowCasterLight(spot_light), GetShadowMapShader(), spot_light.shadowMap.GetLayer());
+            }
+        }
+
+        LODSelection shadow_lods = GetLODSelection(eye, GetShadowLODBias(), false);
+
+        // the lists don't move anymore, the jobs can point to them
+        for(uint32_t i = 0; i < m_ShadowListCount; i++){
+            ViewDrawList* list = &m_ShadowLists[i];
+            // a cached map can't depend on the camera, its LODs are picked as seen from the light
+            list->lod_selection = m_ShadowListsCached ? GetLODSelection(list->light.position, GetShadowLODBias(), false) : shadow_lods;
+            m_Jobs.push_back({"SHADOW_DRAW_LIST", [this, list]{ BuildShadowList(*list); }});
+        }
+    }
+
+    m_PickingQueueBuilt = picking;
+
+    if(picking){
+        m_Jobs.push_back({"PICKING_DRAW_LIST", [this]{ BuildPickingList(); }});
+    }
+
+    RunJobs(m_Jobs);
+
+    for(uint32_t& casters : m_CascadeCasters){
+        casters = 0;
+    }
+
+    for(uint32_t i = 0; i < m_ShadowListCount; i++){
+        if(m_ShadowLists[i].cascade >= 0){
+            m_CascadeCasters[m_ShadowLists[i].cascade] += m_ShadowLists[i].visible;
+        }
+    }
+
+    // the layered passes need the casters of every view of their array
+    if(m_ShadowListsLayered){
+        m_Jobs.clear();
+        m_LayeredShadowPasses[0].shader = &GetLayeredShadowMapShader();
+        m_LayeredShadowPasses[1].shader = &GetLayeredPointLightShadowMapShader();
+
+        for(LayeredShadowPass& pass : m_LayeredShadowPasses){
+            LayeredShadowPass* layered_pass = &pass;
+            m_Jobs.push_back({"LAYERED_SHADOW_LIST", [this, layered_pass]{ BuildLayeredShadowPass(*layered_pass); }});
+        }
+
+        RunJobs(m_Jobs);
+    }
+}
+
+void ResourceManager::DrawDepthPrepass()
+{
+    m_DepthPrepassDrawn = !GetUseGPUCulling() && m_CameraList.depth_shader;
+
+    if(!m_DepthPrepassDrawn){
+        return;
+    }
+
+    SetColorMask(false);
+    m_CameraList.depth_queue.Submit();
+    SetColorMask(true);
+}
+
+void ResourceManager::DrawModels(Shader& shader, glm::mat4 view)
+{
+    if(GetUseGPUCulling()){
+        // the commands built on the GPU always use the full detail meshes
+        shader.Bind();
+        shader.SetUniform1i("lodColor", GetShowLODs() ? 0 : -1);
+
+        DrawModelsGPU(shader, view, g_Frustum);
+        return;
+    }
+
+    #ifdef DEBUG
+        drawn += m_CameraList.visible;
+        culled += m_SceneTree.GetProxyCount() - m_CameraList.visible;
+    #endif
+
+    if(m_DepthPrepassDrawn){
+        // the depth is final, a fragment passes only if it is the visible one
+        SetDepthFunc(GL_EQUAL);
+        SetDepthMask(false);
+
+        m_CameraList.queue.Submit();
+
+        SetDepthFunc(GL_LESS);
+        SetDepthMask(true);
+        m_DepthPrepassDrawn = false;
+    }else{
+        m_CameraList.queue.Submit();
+    }
+}
+
+uint32_t ResourceManager::DrawModelsShadows(Shader& shader, glm::mat4 light_space_matrix, const ShadowCasterLight& light, const ShadowMapLayer& layer)
+{
+    #ifdef DEBUG
+        shadow_views++;
+    #endif
+
+    if(GetUseGPUCulling()){
+        // the bounds were refitted by BuildDrawLists earlier in the frame
+        Frustum light_frustum;
+        ExtractFrustum(light_frustum, light_space_matrix);
+
+        // the casters drawn here depend on the camera, the cache can't be trusted anymore
+        GetShadowCache(layer).valid = false;
+        BindShadowMapLayer(layer);
+
+        #ifdef DEBUG
+            shadow_views_rendered++;
+        #endif
 
-        for(uint32_t i = 0; i < transforms.size(); i++){
-            skinned_model.animator.UploadFinalBoneMatrices(shader);
-            skinned_model.model.DrawShadows(shader, light_space_matrix, transforms[i]);
+        return DrawModelsShadowsGPU(shader, light_space_matrix, light_frustum, light);
+    }
+
+    if(m_NextShadowList >= m_ShadowListCount || m_ShadowLists[m_NextShadowList].view_projection != light_space_matrix){
+        LogError("Shadow view without a draw list, the lights changed after BuildDrawLists");
+        return 0;
+    }
+
+    ViewDrawList& list = m_ShadowLists[m_NextShadowList++];
+
+    if(!m_ShadowListsCached){
+        BindShadowMapLayer(layer);
+        list.queue.Submit("lightSpaceMatrix", light_space_matrix);
+
+        #ifdef DEBUG
+            shadow_views_rendered++;
+        #endif
+
+        return list.visible;
+    }
+
+    ShadowCache& cache = GetShadowCache(layer);
+    bool static_dirty = !cache.valid || cache.static_key != list.static_key;
+
+    if(!static_dirty && cache.dynamic_key == list.dynamic_key){
+        return 0; // the map already holds these casters
+    }
+
+    if(static_dirty){
+        BindShadowMapLayer(layer, true);
+        list.queue.Submit("lightSpaceMatrix", light_space_matrix);
+
+        #ifdef DEBUG
+            shadow_caches_rendered++;
+        #endif
+    }
+
+    CopyStaticShadowMapLayer(layer);
+    BindShadowMapLayer(layer, false, false);
+    list.dynamic_queue.Submit("lightSpaceMatrix", light_space_matrix);
+    cache = {list.static_key, list.dynamic_key, true};
+
+    #ifdef DEBUG
+        shadow_views_rendered++;
+    #endif
+
+    return static_dirty ? list.visible : list.dynamic_proxies.size();
+}
+
+void ResourceManager::DrawPickingList(glm::mat4 view)
+{
+    if(m_PickingQueueBuilt){
+        m_PickingQueue.Submit("view", view);
+    }
+}
+
+uint32_t ResourceManager::DrawLayeredShadowPass(LayeredShadowPass& pass)
+{
+    if(pass.live_lists.empty()){
+        return 0;
+    }
+
+    SetShadowLayers(pass.cube, pass.layers.data(), pass.layers.size());
+
+    if(!pass.static_lists.empty()){
+        for(uint32_t index : pass.static_lists){
+            ClearShadowMapLayer(m_ShadowLists[index].layer, true);
         }
+
+        BindShadowMapArray(pass.cube, true);
+        pass.static_queue.Submit();
+    }
+
+    // the live layers start from their static cache, or empty without caching
+    for(uint32_t index : pass.live_lists){
+        if(m_ShadowListsCached){
+            CopyStaticShadowMapLayer(m_ShadowLists[index].layer);
+        }else{
+            ClearShadowMapLayer(m_ShadowLists[index].layer);
+        }
+    }
+
+    BindShadowMapArray(pass.cube);
+    pass.queue.Submit();
+
+    for(uint32_t index : pass.live_lists){
+        const ViewDrawList& list = m_ShadowLists[index];
+        GetShadowCache(list.layer) = {list.static_key, list.dynamic_key, m_ShadowListsCached};
     }
+
+    #ifdef DEBUG
+        shadow_views_rendered += pass.live_lists.size();
+        shadow_caches_rendered += pass.static_lists.size();
+    #endif
+
+    return pass.static_queue.GetInstanceCount() + pass.queue.GetInstanceCount();
 }
 
 void ResourceManager::DrawShadowMaps()
 {
+    m_NextShadowList = 0;
+
+    #if defined(DEBUG) || defined(PROFILE)
+        bool print_casters = GetShouldDisplayTimers();
+    #endif
+
+    if(m_ShadowListsLayered){
+        #ifdef DEBUG
+            shadow_views += m_ShadowListCount;
+        #endif
+
+        for(LayeredShadowPass& pass : m_LayeredShadowPasses){
+            uint32_t instances = DrawLayeredShadowPass(pass);
+
+            #if defined(DEBUG) || defined(PROFILE)
+                if(print_casters) printf("Shadow casters: layered %s: %u instances\n", pass.cube ? "cube maps" : "shadow maps", instances);
+            #endif
+        }
+
+        #if defined(DEBUG) || defined(PROFILE)
+            if(print_casters){
+                for(unsigned int i = 0; i < SHADOW_CASCADE_COUNT; i++){
+                    printf("Shadow casters: cascade %u: %u\n", i, GetCascadeCasters(i));
+                }
+            }
+        #endif
+
+        UnbindShadowMapLayer();
+        return;
+    }
+
+    // the scene has one sun, only the cascades of the first shadowed directional light are timed
+    bool cascades_timed = false;
+
     for(auto& [id, directional_light] : GetDirectionalLights()){
-        DrawShadowMap(directional_light);
+        uint32_t casters = DrawShadowMap(directional_light, !cascades_timed);
+        cascades_timed = cascades_timed || directional_light.shadowMap.HasShadowMap();
+
+        #if defined(DEBUG) || defined(PROFILE)
+            if(print_casters) printf("Shadow casters: directional light %u: %u\n", id, casters);
+        #endif
     }
 
+    #if defined(DEBUG) || defined(PROFILE)
+        if(print_casters){
+            for(unsigned int i = 0; i < SHADOW_CASCADE_COUNT; i++){
+                printf("Shadow casters: cascade %u: %u, GPU: %f ms\n", i, GetCascadeCasters(i), GetShadowCascadeTime(i));
+            }
+        }
+    #endif
+
     for(auto& [id, point_light] : GetPointLights()){
-        DrawShadowMap(point_light);
+        uint32_t casters = DrawShadowMap(point_light);
+
+        #if defined(DEBUG) || defined(PROFILE)
+            if(print_casters) printf("Shadow casters: point light %u: %u\n", id, casters);
+        #endif
     }
 
     for(auto& [id, spot_light] : GetSpotLights()){
-        DrawShadowMap(spot_light);
+        uint32_t casters = DrawShadowMap(spot_light);
+
+        #if defined(DEBUG) || defined(PROFILE)
+            if(print_casters) printf("Shadow casters: spot light %u: %u\n", id, casters);
+        #endif
     }
+
+    UnbindShadowMapLayer();
 }
 
 void ResourceManager::SetShadowMaps()
 {
-    GetDeferredShader().Bind();
     ResetLightsCounters();
 
     for(auto& [id, directional_light] : GetDirectionalLights()){
@@ -316,6 +897,8 @@ void ResourceManager::SetShadowMaps()
     for(auto& [id, spot_light] : GetSpotLights()){
         SetSpotLight(spot_light);
     }
+
+    UploadLightsCounters();
 }
 
 void ResourceManager::UnloadModelsWithoutTransforms()
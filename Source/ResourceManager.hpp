@@ -9,6 +9,10 @@
 #include <Shader.hpp>
 #include <Animator.hpp>
 #include <Lights.hpp>
+#include <Culling.hpp>
+#include <BVH.hpp>
+#include <RenderQueue.hpp>
+#include <JobSystem.hpp>
 
 extern uint32_t g_Cube;
 extern uint32_t g_Sphere;
@@ -18,13 +22,48 @@ struct SkinnedModel{
     Animator animator;
 
     SkinnedModel() = default;
-    SkinnedModel(const Model& model, const Animator& animator) : model(model), animator(animator) {}
 
     void AddAnimation(const std::string& animationPath, float ticksPerSecond = 0.0f){
         animator.AddAnimation(animationPath, model, ticksPerSecond);
     }
 };
 
+// frames after its last move a caster is still drawn over the static shadow caches instead of into them, so a moving object doesn't redraw the caches every frame
+inline constexpr uint32_t DYNAMIC_CASTER_FRAMES = 60;
+
+/**
+ * \brief Culling results and draw list of one view: the camera, a shadow map or a face of a cube shadow map.
+ * Built by a job, submitted on the main thread
+ */
+struct ViewDrawList{
+    Frustum frustum;
+    glm::mat4 view_projection;
+    ShadowCasterLight light; // shadow views only
+    ShadowMapLayer layer; // shadow views only
+    Frustum receivers; // shadow views only, the casters must shadow something in it: the camera frustum, or the slice of a cascade
+    int cascade = -1; // the cascade of the directional light of the shadow view, -1 for the other views
+    Shader* shader;
+    LODSelection lod_selection;
+    RenderQueue queue;
+    Shader* depth_shader = nullptr; // camera view only, nullptr when there is no depth pre-pass
+    RenderQueue depth_queue;
+    uint32_t visible = 0; // proxies drawn, the casters for shadow views
+
+    // shadow views with caching: queue has the static casters, drawn into the static cache, dynamic_queue the ones drawn over it every time the map is drawn.
+    // The keys identify the view and the casters with their revisions, the map is drawn again only when one of them changes
+    RenderQueue dynamic_queue;
+    uint64_t static_key = 0;
+    uint64_t dynamic_key = 0;
+    // layered shadow pass: whether the static cache and the live map of the view are drawn this frame
+    bool draw_static = false;
+    bool draw_live = false;
+
+    // scratch memory of the job, kept so it's reused
+    std::vector<int> visible_proxies, intersecting_proxies, stack, dynamic_proxies;
+    CullingBatch culling_batch;
+    std::vector<uint32_t> visible_items;
+};
+
 class ResourceManager{
 public:
     ResourceManager() = default;
@@ -52,7 +91,10 @@ public:
     void LoadSkinnedModel(uint32_t id, const std::string& path, const std::string& animationPath, float ticksPerSecond = 0.0f, bool gamma = false);
     uint32_t LoadTexture(const std::string& path, bool flip = true);
     uint32_t LoadTexture(const std::string& path, const std::string& type, bool flip = true);
-    uint32_t LoadShader(const std::string& vertex_path, const std::string& fragment_path);
+    /**
+     * \param geometry_path empty for the programs without a geometry shader
+     */
+    uint32_t LoadShader(const std::string& vertex_path, const std::string& fragment_path, const std::string& geometry_path = "");
     uint32_t LoadDirectionalLight(const glm::vec3& direction, const glm::vec3& color);
     uint32_t LoadPointLight(const glm::vec3& position, const glm::vec3& color);
     uint32_t LoadSpotLight(const glm::vec3& position, const glm::vec3& direction, const glm::vec3& color, float cutOff, float outerCutOff);
@@ -76,11 +118,62 @@ public:
     inline std::unordered_map<uint32_t, SpotLight>& GetSpotLights() { return m_SpotLights; }
     inline unsigned int GetShadowMapArray() const { return m_ShadowMapArray; }
     inline unsigned int GetCubeShadowMapArray() const { return m_CubeShadowMapArray; }
+    inline unsigned int GetStaticShadowMapArray() const { return m_StaticShadowMapArray; }
+    inline unsigned int GetStaticCubeShadowMapArray() const { return m_StaticCubeShadowMapArray; }
+    inline BVH& GetSceneTree() { return m_SceneTree; }
+    /**
+     * \brief Revision to pass to Model::UpdateBounds, the shadow caches find the casters that moved from it
+     */
+    inline uint32_t GetBoundsRevision() const { return m_Frame; }
 
     void HotReloadShaders();
+    inline void UseDepthPrepass(bool use) { m_UseDepthPrepass = use; }
+    inline bool GetUseDepthPrepass() const { return m_UseDepthPrepass; }
+    /**
+     * \brief Keep the shadow maps between frames and draw again only the ones whose light or casters changed. Used only by the CPU culling path
+     */
+    void UseShadowCache(bool use);
+    inline bool GetUseShadowCache() const { return m_UseShadowCache; }
+    /**
+     * \brief Draw every shadow map again in the next frame, e.g. after the shaders are reloaded
+     */
+    void InvalidateShadowCaches();
+    /**
+     * \brief Draw all the shadow maps of each array with one submission, instead of one for each map and cube face. Used only by the CPU culling path
+     */
+    inline void UseLayeredShadows(bool use) { m_UseLayeredShadows = use; }
+    inline bool GetUseLayeredShadows() const { return m_UseLayeredShadows; }
+    /**
+     * \brief Casters of the cascade summed over the directional lights, as culled by the last BuildDrawLists. 0 with the GPU culling path
+     */
+    inline uint32_t GetCascadeCasters(unsigned int cascade) const { return m_CascadeCasters[cascade]; }
+    /**
+     * \brief Fit the cascades of the directional lights to the camera, refit the bounds that changed, then cull and build the draw lists of the G-buffer pass, of each shadow map view and of the picking pass,
+     * one job for each. Call once per frame after extracting g_Frustum, before any draw of the models
+     * \param picking build the list of UpdateMousePicking
+     */
+    void BuildDrawLists(bool picking);
+    /**
+     * \brief Fill the depth buffer with the G-buffer draw list, without writing any color. Does nothing if the pre-pass is disabled or the GPU culling path is used
+     */
+    void DrawDepthPrepass();
+    /**
+     * \brief Submit the G-buffer draw list built by BuildDrawLists. After DrawDepthPrepass, with an equal depth test and no depth writes,
+     * so the materials are sampled only for the visible fragments
+     */
     void DrawModels(Shader& shader, glm::mat4 view);
-    void DrawModelsShadows(Shader& shader, glm::mat4 light_space_matrix);
+    /**
+     * \brief Submit the next shadow draw list built by BuildDrawLists into the layer: the instances inside the light volume whose shadow can reach the camera frustum.
+     * With the shadow caching every instance inside the light volume is drawn, and nothing is drawn if the map didn't change.
+     * The lists are submitted in the order DrawShadowMaps visits the lights
+     * \return the number of casters drawn
+     */
+    uint32_t DrawModelsShadows(Shader& shader, glm::mat4 light_space_matrix, const ShadowCasterLight& light, const ShadowMapLayer& layer);
     void DrawShadowMaps();
+    /**
+     * \brief Submit the picking draw list, every instance with the id of its model
+     */
+    void DrawPickingList(glm::mat4 view);
     void SetShadowMaps();
 
     int GetShadowMapArrayIndex();
@@ -91,6 +184,44 @@ public:
     void UpdateAnimations(float deltaTime);
 
 private:
+    /**
+     * \brief What a layer of the shadow map arrays holds, compared to the keys of its draw list
+     */
+    struct ShadowCache{
+        uint64_t static_key = 0;
+        uint64_t dynamic_key = 0;
+        bool valid = false;
+    };
+
+    /**
+     * \brief Draw lists of the layered shadow pass of one shadow map array, built from the casters of its shadow views
+     */
+    struct LayeredShadowPass{
+        bool cube;
+        Shader* shader;
+        RenderQueue static_queue; // the static casters of the views whose static cache is drawn again
+        RenderQueue queue; // drawn into the live array
+        std::vector<ShadowLayerData> layers; // indexed by GetShadowViewIndex of the views
+        std::vector<uint32_t> static_lists, live_lists; // the shadow lists drawn by each queue
+    };
+
+    ShadowCache& GetShadowCache(const ShadowMapLayer& layer);
+    ViewDrawList& AddShadowList(const glm::mat4& light_space_matrix, const ShadowCasterLight& light, Shader& shader, const ShadowMapLayer& layer);
+    void BuildCameraList(glm::vec3 eye);
+    void BuildShadowList(ViewDrawList& list);
+    /**
+     * \brief Split the casters of a shadow view in the static and dynamic queues and compute the keys of the cache
+     */
+    void BuildCachedShadowList(ViewDrawList& list);
+    /**
+     * \brief Queue the casters of the shadow views of the array that must be drawn this frame, each one in the layer of its view
+     */
+    void BuildLayeredShadowPass(LayeredShadowPass& pass);
+    /**
+     * \returns the number of instances drawn
+     */
+    uint32_t DrawLayeredShadowPass(LayeredShadowPass& pass);
+    void BuildPickingList();
 
     std::unordered_map<uint32_t, Model> m_Models;
     std::unordered_map<uint32_t, SkinnedModel> m_SkinnedModels;
@@ -101,7 +232,32 @@ private:
     std::unordered_map<uint32_t, SpotLight> m_SpotLights;
 
     unsigned int m_ShadowMapArray, m_CubeShadowMapArray;
+    unsigned int m_StaticShadowMapArray, m_StaticCubeShadowMapArray; // depth of the static casters of each layer, copied to the live arrays before the dynamic casters are drawn
+    std::vector<ShadowCache> m_ShadowCaches, m_CubeShadowCaches; // indexed by GetShadowViewIndex, one for each view of the arrays
+    bool m_UseShadowCache = true;
+    bool m_ShadowCachesInvalid = false; // applied by the next BuildDrawLists, so the lists and the caches agree until the maps are drawn
+    LayeredShadowPass m_LayeredShadowPasses[2]; // the shadow map array, the cube shadow map array
+    bool m_UseLayeredShadows = true;
+    // the settings the shadow lists of this frame were built with
+    bool m_ShadowListsCached = false;
+    bool m_ShadowListsLayered = false;
+    uint32_t m_CascadeCasters[SHADOW_CASCADE_COUNT] = {};
     std::unordered_set<int> m_ShadowMapArrayIndices, m_CubeShadowMapArrayIndices;
+
+    BVH m_SceneTree; // one proxy for each mesh of each model instance
+    uint32_t m_LastProxyCount = 0;
+    uint32_t m_Frame = 0; // revision given to the transforms refitted by BuildDrawLists
+
+    // rebuilt every frame by BuildDrawLists. kept as members so the memory is reused
+    ViewDrawList m_CameraList;
+    std::vector<ViewDrawList> m_ShadowLists; // in the order DrawShadowMaps visits the lights, six for each point light
+    uint32_t m_ShadowListCount = 0;
+    uint32_t m_NextShadowList = 0;
+    RenderQueue m_PickingQueue;
+    bool m_PickingQueueBuilt = false;
+    bool m_UseDepthPrepass = false;
+    bool m_DepthPrepassDrawn = false;
+    std::vector<Job> m_Jobs;
 };
 
 extern void InitResourceManager();
@@ -116,11 +272,14 @@ inline DirectionalLight* GetDirectionalLight(uint32_t id) { return GetResourceMa
 inline PointLight* GetPointLight(uint32_t id) { return GetResourceManager().GetPointLight(id); }
 inline SpotLight* GetSpotLight(uint32_t id) { return GetResourceManager().GetSpotLight(id); }
 
-extern uint32_t g_GBufferShader, g_DeferredShader, g_ShadowMapShader, g_PointLightShadowMapShader;
+extern uint32_t g_GBufferShader, g_DepthPrepassShader, g_DeferredShader, g_ShadowMapShader, g_PointLightShadowMapShader, g_LayeredShadowMapShader, g_LayeredPointLightShadowMapShader;
 inline Shader& GetGBufferShader() { return *GetShader(g_GBufferShader); }
+inline Shader& GetDepthPrepassShader() { return *GetShader(g_DepthPrepassShader); }
 inline Shader& GetDeferredShader() { return *GetShader(g_DeferredShader); }
 inline Shader& GetShadowMapShader() { return *GetShader(g_ShadowMapShader); }
 inline Shader& GetPointLightShadowMapShader() { return *GetShader(g_PointLightShadowMapShader); }
+inline Shader& GetLayeredShadowMapShader() { return *GetShader(g_LayeredShadowMapShader); }
+inline Shader& GetLayeredPointLightShadowMapShader() { return *GetShader(g_LayeredPointLightShadowMapShader); }
 
 inline uint32_t LoadModel(const std::string& path, bool gamma = false){ return GetResourceManager().LoadModel(path, gamma); }
 inline uint32_t LoadModel(const std::vector<Mesh>& meshes, const std::string& model_name, bool gamma = false){ return GetResourceManager().LoadModel(meshes, model_name, gamma); }
@@ -130,7 +289,7 @@ inline uint32_t LoadSkinnedModel(const std::string& path, const std::string& ani
 inline void LoadSkinnedModel(uint32_t id, const std::string& path, const std::string& animationPath, float ticksPerSecond = 0.0f, bool gamma = false){ GetResourceManager().LoadSkinnedModel(id, path, animationPath, ticksPerSecond, gamma); }
 inline uint32_t LoadTexture(const std::string& path, bool flip = true){ return GetResourceManager().LoadTexture(path, flip); }
 inline uint32_t LoadTexture(const std::string& path, const std::string& type, bool flip = true){ return GetResourceManager().LoadTexture(path, type, flip); }
-inline uint32_t LoadShader(const std::string& vertex_path, const std::string& fragment_path){ return GetResourceManager().LoadShader(vertex_path, fragment_path); }
+inline uint32_t LoadShader(const std::string& vertex_path, const std::string& fragment_path, const std::string& geometry_path = ""){ return GetResourceManager().LoadShader(vertex_path, fragment_path, geometry_path); }
 inline uint32_t LoadDirectionalLight(const glm::vec3& direction, const glm::vec3& color){ return GetResourceManager().LoadDirectionalLight(direction, color); }
 inline uint32_t LoadPointLight(const glm::vec3& position, const glm::vec3& color){ return GetResourceManager().LoadPointLight(position, color); }
 inline uint32_t LoadSpotLight(const glm::vec3& position, const glm::vec3& direction, const glm::vec3& color, float cutOff, float outerCutOff){ return GetResourceManager().LoadSpotLight(position, direction, color, cutOff, outerCutOff); }
@@ -154,12 +313,27 @@ inline std::unordered_map<uint32_t, PointLight>& GetPointLights() { return GetRe
 inline std::unordered_map<uint32_t, SpotLight>& GetSpotLights() { return GetResourceManager().GetSpotLights(); }
 inline unsigned int GetShadowMapArray() { return GetResourceManager().GetShadowMapArray(); }
 inline unsigned int GetCubeShadowMapArray() { return GetResourceManager().GetCubeShadowMapArray(); }
+inline unsigned int GetStaticShadowMapArray() { return GetResourceManager().GetStaticShadowMapArray(); }
+inline unsigned int GetStaticCubeShadowMapArray() { return GetResourceManager().GetStaticCubeShadowMapArray(); }
+inline BVH& GetSceneTree() { return GetResourceManager().GetSceneTree(); }
+inline uint32_t GetBoundsRevision() { return GetResourceManager().GetBoundsRevision(); }
 
 inline void HotReloadShaders(){ GetResourceManager().HotReloadShaders(); }
+inline void UseDepthPrepass(bool use){ GetResourceManager().UseDepthPrepass(use); }
+inline bool GetUseDepthPrepass(){ return GetResourceManager().GetUseDepthPrepass(); }
+inline void UseShadowCache(bool use){ GetResourceManager().UseShadowCache(use); }
+inline bool GetUseShadowCache(){ return GetResourceManager().GetUseShadowCache(); }
+inline void InvalidateShadowCaches(){ GetResourceManager().InvalidateShadowCaches(); }
+inline void UseLayeredShadows(bool use){ GetResourceManager().UseLayeredShadows(use); }
+inline bool GetUseLayeredShadows(){ return GetResourceManager().GetUseLayeredShadows(); }
+inline uint32_t GetCascadeCasters(unsigned int cascade){ return GetResourceManager().GetCascadeCasters(cascade); }
 extern void ClearModels();
+inline void BuildDrawLists(bool picking){ GetResourceManager().BuildDrawLists(picking); }
+inline void DrawDepthPrepass(){ GetResourceManager().DrawDepthPrepass(); }
 inline void DrawModels(Shader& shader, glm::mat4 view){ GetResourceManager().DrawModels(shader, view); }
-inline void DrawModelsShadows(Shader& shader, glm::mat4 light_space_matrix){ GetResourceManager().DrawModelsShadows(shader, light_space_matrix); }
+inline uint32_t DrawModelsShadows(Shader& shader, glm::mat4 light_space_matrix, const ShadowCasterLight& light, const ShadowMapLayer& layer){ return GetResourceManager().DrawModelsShadows(shader, light_space_matrix, light, layer); }
 inline void DrawShadowMaps(){ GetResourceManager().DrawShadowMaps(); }
+inline void DrawPickingList(glm::mat4 view){ GetResourceManager().DrawPickingList(view); }
 inline void SetShadowMaps(){ GetResourceManager().SetShadowMaps(); }
 
 inline int GetShadowMapArrayIndex() { return GetResourceManager().GetShadowMapArrayIndex(); }
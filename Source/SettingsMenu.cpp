@@ -4,6 +4,10 @@
 #include <Window.hpp>
 #include <Globals.hpp>
 #include <PostProcessing.hpp>
+#include <GPUCulling.hpp>
+#include <ResourceManager.hpp>
+#include <LOD.hpp>
+#include <DynamicResolution.hpp>
 
 #include <string>
 #include <vector>
@@ -91,6 +95,53 @@ void SettingsMenu()
                 if(ImGui::Checkbox("Bloom", &useBloom)){
                     UseBloom(useBloom);
                 }   
+
+                bool useGPUCulling = GetUseGPUCulling();
+                if(ImGui::Checkbox("GPU Culling", &useGPUCulling)){
+                    UseGPUCulling(useGPUCulling);
+                }
+
+                bool useOcclusionCulling = GetUseOcclusionCulling();
+                if(ImGui::Checkbox("Occlusion Culling (GPU Culling only)", &useOcclusionCulling)){
+                    UseOcclusionCulling(useOcclusionCulling);
+                }
+
+                bool useDepthPrepass = GetUseDepthPrepass();
+                if(ImGui::Checkbox("Depth Pre-pass (CPU culling only)", &useDepthPrepass)){
+                    UseDepthPrepass(useDepthPrepass);
+                }
+
+                bool useShadowCache = GetUseShadowCache();
+                if(ImGui::Checkbox("Shadow Caching (CPU culling only)", &useShadowCache)){
+                    UseShadowCache(useShadowCache);
+                }
+
+                bool useLayeredShadows = GetUseLayeredShadows();
+                if(ImGui::Checkbox("Layered Shadows (CPU culling only)", &useLayeredShadows)){
+                    UseLayeredShadows(useLayeredShadows);
+                }
+
+                int shadowLODBias = GetShadowLODBias();
+                if(ImGui::SliderInt("Shadow LOD Bias", &shadowLODBias, 0, MAX_MESH_LODS - 1)){
+                    SetShadowLODBias(shadowLODBias);
+                }
+
+                bool showLODs = GetShowLODs();
+                if(ImGui::Checkbox("Show LODs", &showLODs)){
+                    SetShowLODs(showLODs);
+                }
+
+                bool useDynamicResolution = GetUseDynamicResolution();
+                if(ImGui::Checkbox("Dynamic Resolution", &useDynamicResolution)){
+                    UseDynamicResolution(useDynamicResolution);
+                }
+
+                float targetFrameTime = GetTargetFrameTime();
+                if(ImGui::SliderFloat("Target GPU Frame Time (ms)", &targetFrameTime, 4.0f, 50.0f)){
+                    SetTargetFrameTime(targetFrameTime);
+                }
+
+                ImGui::EndTabItem();
             }
 
             if (ImGui::BeginTabItem("Audio")){
@@ -117,4 +168,4 @@ void SettingsMenu()
 
     ImGui::Render();
     ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
-}
+}
\ No newline at end of file
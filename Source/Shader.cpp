@@ -1,10 +1,11 @@
 #include <Shader.hpp>
+#include <OpenGL.hpp>
 #include <Log.hpp>
 #include <glad/glad.h>
 #include <glm.hpp>
 #include <gtc/type_ptr.hpp>
 
-void Shader::Load(const char* vertexPath, const char* fragmentPath)
+void Shader::Load(const char* vertexPath, const char* fragmentPath, const char* geometryPath)
 {
     m_ID = glCreateProgram();
 
@@ -38,19 +39,37 @@ void Shader::Load(const char* vertexPath, const char* fragmentPath)
     fclose(vertex_file);
     fclose(fragment_file);
 
+    std::string geometry_src_code;
+
+    if(geometryPath){
+        FILE* geometry_file = fopen(geometryPath, "r");
+
+        if(!geometry_file){
+            LogError("Could not open geometry shader file %s", geometryPath);
+            return;
+        }
+
+        while((ch = fgetc(geometry_file)) != EOF){
+            geometry_src_code += ch;
+        }
+
+        fclose(geometry_file);
+    }
+
     m_VertexPath = vertexPath;
     m_FragmentPath = fragmentPath;
+    m_GeometryPath = geometryPath ? geometryPath : "";
 
-    Compile(vertex_src_code.c_str(), fragment_src_code.c_str());
+    Compile(vertex_src_code.c_str(), fragment_src_code.c_str(), geometryPath ? geometry_src_code.c_str() : nullptr);
 
     #ifdef DEBUG
         LogMessage("Shader %s and %s loaded successfully", vertexPath, fragmentPath);
     #endif
 }
 
-void Shader::Compile(const char* vertex_src_code, const char* fragment_src_code)
+void Shader::Compile(const char* vertex_src_code, const char* fragment_src_code, const char* geometry_src_code)
 {
-    unsigned int vertex_shader, fragment_shader;
+    unsigned int vertex_shader, fragment_shader, geometry_shader = 0;
     bool status;
 
     //compile vertex Shader
@@ -73,6 +92,20 @@ void Shader::Compile(const char* vertex_src_code, const char* fragment_src_code)
         LogError("Couldn't compile shader %s", m_FragmentPath.c_str());
     }
 
+    //compile geometry Shader
+    if(geometry_src_code){
+        geometry_shader = glCreateShader(GL_GEOMETRY_SHADER);
+        glShaderSource(geometry_shader, 1, &geometry_src_code, nullptr);
+        glCompileShader(geometry_shader);
+        status = CheckCompileErrors(geometry_shader);
+
+        if(!status){
+            LogError("Couldn't compile shader %s", m_GeometryPath.c_str());
+        }
+
+        glAttachShader(m_ID, geometry_shader);
+    }
+
     glAttachShader(m_ID, vertex_shader);
     glAttachShader(m_ID, fragment_shader);
     glLinkProgram(m_ID);
@@ -82,9 +115,15 @@ void Shader::Compile(const char* vertex_src_code, const char* fragment_src_code)
     if(!status){
         LogError("Couldn't link Shaders %s and %s", m_VertexPath.c_str(), m_FragmentPath.c_str());
     }
+
+    m_Uniforms.Build(m_ID);
     
     glDeleteShader(vertex_shader);
     glDeleteShader(fragment_shader);
+
+    if(geometry_shader){
+        glDeleteShader(geometry_shader);
+    }
 }
 
 bool Shader::CheckCompileErrors(unsigned int shader_id)
@@ -137,83 +176,84 @@ bool Shader::CheckLinkErrors()
 void Shader::Unload()
 {
     glDeleteProgram(m_ID);
+    m_Uniforms.Clear();
 }
 
 void Shader::Reload()
 {
     Unload();
-    Load(m_VertexPath.c_str(), m_FragmentPath.c_str());
+    Load(m_VertexPath.c_str(), m_FragmentPath.c_str(), m_GeometryPath.empty() ? nullptr : m_GeometryPath.c_str());
 }
 
 void Shader::Bind() const
 {
-    glUseProgram(m_ID);
+    UseProgram(m_ID);
 }
 
 void Shader::Unbind() const
 {
-    glUseProgram(0);
+    UseProgram(0);
 }
 
-void Shader::SetUniform1i(const std::string& name, int value)
+void Shader::SetUniform1i(UniformHandle handle, int value)
 {
-    int location = GetUniformLocation(name);
+    int location = GetUniformLocation(handle);
     glUniform1i(location, value);
 }
 
-void Shader::SetUniform1ui(const std::string& name, unsigned int value)
+void Shader::SetUniform1ui(UniformHandle handle, unsigned int value)
 {
-    int location = GetUniformLocation(name);
+    int location = GetUniformLocation(handle);
     glUniform1ui(location, value);
 }
 
-void Shader::SetUniform1f(const std::string& name, float value)
+void Shader::SetUniform1f(UniformHandle handle, float value)
 {
-    int location = GetUniformLocation(name);
+    int location = GetUniformLocation(handle);
     glUniform1f(location, value);
 }
 
-void Shader::SetUniformMat4fv(const std::string& name, const glm::mat4& matrix, unsigned int count)
+void Shader::SetUniform2f(UniformHandle handle, float x, float y)
 {
-    int location = GetUniformLocation(name);
+    int location = GetUniformLocation(handle);
+    glUniform2f(location, x, y);
+}
+
+void Shader::SetUniformMat4fv(UniformHandle handle, const glm::mat4& matrix, unsigned int count)
+{
+    int location = GetUniformLocation(handle);
     glUniformMatrix4fv(location, count, GL_FALSE, glm::value_ptr(matrix));
 }
 
-void Shader::SetUniform1iv(const std::string& name, int* values, unsigned int count)
+void Shader::SetUniform1iv(UniformHandle handle, int* values, unsigned int count)
 {
-    int location = GetUniformLocation(name);
+    int location = GetUniformLocation(handle);
     glUniform1iv(location, count, values);
 }
 
-void Shader::SetUniform1iuv(const std::string& name, unsigned int* values, unsigned int count)
+void Shader::SetUniform1iuv(UniformHandle handle, unsigned int* values, unsigned int count)
 {
-    int location = GetUniformLocation(name);
+    int location = GetUniformLocation(handle);
     glUniform1uiv(location, count, values);
 }
 
-void Shader::SetUniform3fv(const std::string& name, const glm::vec3& vector, unsigned int count)
+void Shader::SetUniform3fv(UniformHandle handle, const glm::vec3& vector, unsigned int count)
 {
-    int location = GetUniformLocation(name);
+    int location = GetUniformLocation(handle);
     glUniform3fv(location, count, glm::value_ptr(vector));
 }
 
-void Shader::SetUniform4fv(const std::string& name, const glm::vec4& vector, unsigned int count)
+void Shader::SetUniform4fv(UniformHandle handle, const glm::vec4& vector, unsigned int count)
 {
-    int location = GetUniformLocation(name);
+    int location = GetUniformLocation(handle);
     glUniform4fv(location, count, glm::value_ptr(vector));
 }
 
-int Shader::GetUniformLocation(const std::string& name)
+int Shader::GetUniformLocation(UniformHandle handle) const
 {
-    if(m_UniformsCache.find(name) != m_UniformsCache.end()){
-        return m_UniformsCache[name];
-    }
-
-    int location = glGetUniformLocation(m_ID, name.c_str());
+    int location = m_Uniforms.GetLocation(handle);
     if(location == -1){
-        LogWarning("Uniform %s not found in shader", name.c_str());
-    }else{
-        m_UniformsCache[name] = location;
+        LogWarning("Uniform %s not found in shader", handle.GetName() ? handle.GetName() : "(unnamed)");
     }
 
     return location;
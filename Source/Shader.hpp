@@ -1,6 +1,7 @@
 #pragma once
 
-#include <unordered_map>
+#include <UniformHandle.hpp>
+
 #include <string>
 #include <glm.hpp>
 
@@ -9,7 +10,10 @@ public:
     Shader() = default;
     ~Shader() = default;
 
-    void Load(const char* vertexPath, const char* fragmentPath);
+    /**
+     * \param geometryPath nullptr for the programs without a geometry shader
+     */
+    void Load(const char* vertexPath, const char* fragmentPath, const char* geometryPath = nullptr);
     void Unload();
 
     void Reload();
@@ -19,23 +23,25 @@ public:
     
     inline int GetID() const { return m_ID; }
 
-    void SetUniform1i(const std::string& name, int value);
-    void SetUniform1ui(const std::string& name, unsigned int value);
-    void SetUniform1f(const std::string& name, float value);
-    void SetUniformMat4fv(const std::string& name, const glm::mat4& matrix, unsigned int count = 1);
-    void SetUniform1iv(const std::string& name, int* values, unsigned int count = 1);
-    void SetUniform1iuv(const std::string& name, unsigned int* values, unsigned int count = 1);
-    void SetUniform3fv(const std::string& name, const glm::vec3& vector, unsigned int count = 1);
-    void SetUniform4fv(const std::string& name, const glm::vec4& vector, unsigned int count = 1);
+    void SetUniform1i(UniformHandle handle, int value);
+    void SetUniform1ui(UniformHandle handle, unsigned int value);
+    void SetUniform1f(UniformHandle handle, float value);
+    void SetUniform2f(UniformHandle handle, float x, float y);
+    void SetUniformMat4fv(UniformHandle handle, const glm::mat4& matrix, unsigned int count = 1);
+    void SetUniform1iv(UniformHandle handle, int* values, unsigned int count = 1);
+    void SetUniform1iuv(UniformHandle handle, unsigned int* values, unsigned int count = 1);
+    void SetUniform3fv(UniformHandle handle, const glm::vec3& vector, unsigned int count = 1);
+    void SetUniform4fv(UniformHandle handle, const glm::vec4& vector, unsigned int count = 1);
 
 private:
-    int GetUniformLocation(const std::string& name);
-    void Compile(const char* vertexCode, const char* fragmentCode);
+    int GetUniformLocation(UniformHandle handle) const;
+    void Compile(const char* vertexCode, const char* fragmentCode, const char* geometryCode);
     bool CheckCompileErrors(unsigned int shader_id);
     bool CheckLinkErrors();
 
     unsigned int m_ID;
-    std::unordered_map<std::string, int> m_UniformsCache;
+    UniformTable m_Uniforms; // rebuilt every time the program is linked, so the hot reload resolves the locations again
     std::string m_VertexPath;
     std::string m_FragmentPath;
+    std::string m_GeometryPath; // empty without a geometry shader
 };
\ No newline at end of file
@@ -1,10 +1,25 @@
 #include <ShadowMap.hpp>
+#include <OpenGL.hpp>
 #include <Globals.hpp>
 #include <ResourceManager.hpp>
 #include <Log.hpp>
+#include <DynamicResolution.hpp>
 
 #include <glad/glad.h>
 
+static unsigned int g_LayeredFBO = 0;
+static unsigned int g_ShadowLayerBuffers[2] = {0, 0}; // shadow map array, cube shadow map array
+static bool g_VertexShaderLayer = false;
+
+#if defined(DEBUG) || defined(PROFILE)
+    static constexpr uint32_t CASCADE_TIMER_FRAMES = 4; // frames in flight before a query set is reused
+    static unsigned int g_CascadeQueries[CASCADE_TIMER_FRAMES][SHADOW_CASCADE_COUNT + 1]; // the start of each cascade, then the end of the last
+    static uint32_t g_NextCascadeQueries = 0;
+    static uint32_t g_PendingCascadeQueries = 0;
+    static bool g_CascadesTimed = false;
+    static float g_CascadeTimes[SHADOW_CASCADE_COUNT] = {};
+#endif
+
 void ShadowMap::Init()
 {
     glGenFramebuffers(1, &m_FBO);
@@ -16,7 +31,7 @@ void ShadowMap::Init()
         return;
     }
 
-    glBindFramebuffer(GL_FRAMEBUFFER, m_FBO);
+    BindFramebuffer(GL_FRAMEBUFFER, m_FBO);
     glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GetShadowMapArray(), 0, m_ShadowMapIndex);
     glDrawBuffer(GL_NONE);
     glReadBuffer(GL_NONE);
@@ -25,25 +40,18 @@ void ShadowMap::Init()
         LogError("Shadow map framebuffer is not complete");
     }
 
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    BindFramebuffer(GL_FRAMEBUFFER, 0);
 }
 
 void ShadowMap::Deinit()
 {
-    glDeleteFramebuffers(1, &m_FBO);
-}
+    DeleteFramebuffers(1, &m_FBO);
+    m_FBO = 0;
 
-void ShadowMap::Bind() const
-{
-    glViewport(0, 0, SHADOWMAP_SIZE, SHADOWMAP_SIZE);
-    glBindFramebuffer(GL_FRAMEBUFFER, m_FBO);
-    glClear(GL_DEPTH_BUFFER_BIT);
-}
-
-void ShadowMap::Unbind() const
-{
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
-    glViewport(0, 0, g_ScreenWidth, g_ScreenHeight);
+    if(m_ShadowMapIndex != -1){
+        FreeShadowMapArrayIndex(m_ShadowMapIndex);
+        m_ShadowMapIndex = -1;
+    }
 }
 
 void PointLightShadowMap::Init()
@@ -57,7 +65,7 @@ void PointLightShadowMap::Init()
         return;
     }
 
-    glBindFramebuffer(GL_FRAMEBUFFER, m_FBO);
+    BindFramebuffer(GL_FRAMEBUFFER, m_FBO);
     glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GetCubeShadowMapArray(), 0, m_ShadowMapIndex * 6);
     glDrawBuffer(GL_NONE);
     glReadBuffer(GL_NONE);
@@ -66,33 +74,208 @@ void PointLightShadowMap::Init()
         LogError("Shadow cube map framebuffer is not complete");
     }
 
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    BindFramebuffer(GL_FRAMEBUFFER, 0);
 }
 
 void PointLightShadowMap::Deinit()
 {
-    glDeleteFramebuffers(1, &m_FBO);
+    DeleteFramebuffers(1, &m_FBO);
+    m_FBO = 0;
+
+    if(m_ShadowMapIndex != -1){
+        FreeCubeShadowMapArrayIndex(m_ShadowMapIndex);
+        m_ShadowMapIndex = -1;
+    }
+}
+
+static unsigned int GetLayerArray(const ShadowMapLayer& layer, bool static_cache)
+{
+    if(layer.cube){
+        return static_cache ? GetStaticCubeShadowMapArray() : GetCubeShadowMapArray();
+    }
+
+    return static_cache ? GetStaticShadowMapArray() : GetShadowMapArray();
+}
+
+void BindShadowMapLayer(const ShadowMapLayer& layer, bool static_cache, bool clear)
+{
+    SetViewport(GetShadowLayerX(layer), GetShadowLayerY(layer), GetShadowLayerSize(layer), GetShadowLayerSize(layer));
+    BindFramebuffer(GL_FRAMEBUFFER, layer.fbo);
+    glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GetLayerArray(layer, static_cache), 0, layer.layer);
+
+    if(clear){
+        // a glClear ignores the viewport, it would clear the other cascades of the layer
+        ClearShadowMapLayer(layer, static_cache);
+    }
+}
+
+void CopyStaticShadowMapLayer(const ShadowMapLayer& layer)
+{
+    GLenum target = layer.cube ? GL_TEXTURE_CUBE_MAP_ARRAY : GL_TEXTURE_2D_ARRAY;
+    unsigned int x = GetShadowLayerX(layer), y = GetShadowLayerY(layer), size = GetShadowLayerSize(layer);
+    glCopyImageSubData(GetLayerArray(layer, true), target, 0, x, y, layer.layer, GetLayerArray(layer, false), target, 0, x, y, layer.layer, size, size, 1);
+}
+
+void ClearShadowMapLayer(const ShadowMapLayer& layer, bool static_cache)
+{
+    // a glClear would clear every layer attached to the layered framebuffer
+    float depth = 1.0f;
+    glClearTexSubImage(GetLayerArray(layer, static_cache), 0, GetShadowLayerX(layer), GetShadowLayerY(layer), layer.layer,
+                       GetShadowLayerSize(layer), GetShadowLayerSize(layer), 1, GL_DEPTH_COMPONENT, GL_FLOAT, &depth);
+}
+
+void UnbindShadowMapLayer()
+{
+    BindFramebuffer(GL_FRAMEBUFFER, 0);
+    SetRenderViewport();
+}
+
+void InitLayeredShadowMaps()
+{
+    g_VertexShaderLayer = HasExtension("GL_ARB_shader_viewport_layer_array") ||
+                          (HasExtension("GL_AMD_vertex_shader_layer") && HasExtension("GL_AMD_vertex_shader_viewport_index"));
+
+    if(!g_VertexShaderLayer){
+        LogMessage("gl_Layer and gl_ViewportIndex can't be written by the vertex shaders, the layered shadow pass uses a geometry shader");
+    }
+
+    // the arrays are attached before each pass, glDrawBuffer and glReadBuffer are framebuffer state
+    glGenFramebuffers(1, &g_LayeredFBO);
+    BindFramebuffer(GL_FRAMEBUFFER, g_LayeredFBO);
+    glDrawBuffer(GL_NONE);
+    glReadBuffer(GL_NONE);
+    BindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    // immutable storage, written with glBufferSubData once per frame
+    glGenBuffers(2, g_ShadowLayerBuffers);
+    BindBuffer(GL_SHADER_STORAGE_BUFFER, g_ShadowLayerBuffers[0]);
+    glBufferStorage(GL_SHADER_STORAGE_BUFFER, MAX_SHADOWED_LIGHTS * 2 * SHADOW_CASCADE_COUNT * sizeof(ShadowLayerData), nullptr, GL_DYNAMIC_STORAGE_BIT);
+    BindBuffer(GL_SHADER_STORAGE_BUFFER, g_ShadowLayerBuffers[1]);
+    glBufferStorage(GL_SHADER_STORAGE_BUFFER, MAX_SHADOWED_LIGHTS * 6 * sizeof(ShadowLayerData), nullptr, GL_DYNAMIC_STORAGE_BIT);
+    BindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+void DeinitLayeredShadowMaps()
+{
+    DeleteFramebuffers(1, &g_LayeredFBO);
+    DeleteBuffers(2, g_ShadowLayerBuffers);
+}
+
+bool HasVertexShaderLayer()
+{
+    return g_VertexShaderLayer;
+}
+
+void SetShadowLayers(bool cube, const ShadowLayerData* layers, unsigned int count)
+{
+    BindBuffer(GL_SHADER_STORAGE_BUFFER, g_ShadowLayerBuffers[cube]);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, count * sizeof(ShadowLayerData), layers);
+    BindBufferBase(GL_SHADER_STORAGE_BUFFER, SHADOW_LAYERS_BINDING, g_ShadowLayerBuffers[cube]);
+}
+
+void BindShadowMapArray(bool cube, bool static_cache)
+{
+    ShadowMapLayer layer = {g_LayeredFBO, cube, 0};
+
+    // glViewport sets every viewport, the state cache only tracks the first one
+    SetViewport(0, 0, SHADOWMAP_SIZE, SHADOWMAP_SIZE);
+
+    for(unsigned int i = 0; i < SHADOW_CASCADE_COUNT; i++){
+        ShadowMapLayer quadrant = {g_LayeredFBO, false, 0, (int)i};
+        glViewportIndexedf(1 + i, (float)GetShadowLayerX(quadrant), (float)GetShadowLayerY(quadrant), (float)SHADOW_CASCADE_SIZE, (float)SHADOW_CASCADE_SIZE);
+    }
+    BindFramebuffer(GL_FRAMEBUFFER, g_LayeredFBO);
+    glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GetLayerArray(layer, static_cache), 0);
+}
+
+void InitShadowCascadeTimers()
+{
+    #if defined(DEBUG) || defined(PROFILE)
+        for(uint32_t i = 0; i < CASCADE_TIMER_FRAMES; i++){
+            glGenQueries(SHADOW_CASCADE_COUNT + 1, g_CascadeQueries[i]);
+        }
+
+        g_NextCascadeQueries = 0;
+        g_PendingCascadeQueries = 0;
+        g_CascadesTimed = false;
+    #endif
+}
+
+void DeinitShadowCascadeTimers()
+{
+    #if defined(DEBUG) || defined(PROFILE)
+        for(uint32_t i = 0; i < CASCADE_TIMER_FRAMES; i++){
+            glDeleteQueries(SHADOW_CASCADE_COUNT + 1, g_CascadeQueries[i]);
+        }
+    #endif
+}
+
+void BeginShadowCascadeTimers()
+{
+    #if defined(DEBUG) || defined(PROFILE)
+        // the oldest sets finish first, stop at the first one still running
+        while(g_PendingCascadeQueries > 0){
+            unsigned int* queries = g_CascadeQueries[(g_NextCascadeQueries + CASCADE_TIMER_FRAMES - g_PendingCascadeQueries) % CASCADE_TIMER_FRAMES];
+
+            int available = 0;
+            glGetQueryObjectiv(queries[SHADOW_CASCADE_COUNT], GL_QUERY_RESULT_AVAILABLE, &available);
+            if(!available){
+                break;
+            }
+
+            GLuint64 timestamps[SHADOW_CASCADE_COUNT + 1];
+            for(uint32_t i = 0; i <= SHADOW_CASCADE_COUNT; i++){
+                glGetQueryObjectui64v(queries[i], GL_QUERY_RESULT, &timestamps[i]);
+            }
+
+            for(uint32_t i = 0; i < SHADOW_CASCADE_COUNT; i++){
+                g_CascadeTimes[i] = (timestamps[i + 1] - timestamps[i]) / 1000000.0f;
+            }
+
+            g_PendingCascadeQueries--;
+        }
+
+        g_CascadesTimed = g_PendingCascadeQueries < CASCADE_TIMER_FRAMES;
+    #endif
 }
 
-void PointLightShadowMap::Bind(unsigned int face) const
+void TimeShadowCascade(unsigned int cascade)
 {
-    glViewport(0, 0, SHADOWMAP_SIZE, SHADOWMAP_SIZE);
-    glBindFramebuffer(GL_FRAMEBUFFER, m_FBO);
-    glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GetCubeShadowMapArray(), 0, m_ShadowMapIndex * 6 + face);
-    glClear(GL_DEPTH_BUFFER_BIT);
+    #if defined(DEBUG) || defined(PROFILE)
+        if(g_CascadesTimed){
+            glQueryCounter(g_CascadeQueries[g_NextCascadeQueries][cascade], GL_TIMESTAMP);
+        }
+    #endif
+}
+
+void EndShadowCascadeTimers()
+{
+    #if defined(DEBUG) || defined(PROFILE)
+        if(!g_CascadesTimed){
+            return;
+        }
+
+        glQueryCounter(g_CascadeQueries[g_NextCascadeQueries][SHADOW_CASCADE_COUNT], GL_TIMESTAMP);
+        g_NextCascadeQueries = (g_NextCascadeQueries + 1) % CASCADE_TIMER_FRAMES;
+        g_PendingCascadeQueries++;
+        g_CascadesTimed = false;
+    #endif
 }
 
-void PointLightShadowMap::Unbind() const
+float GetShadowCascadeTime(unsigned int cascade)
 {
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
-    glViewport(0, 0, g_ScreenWidth, g_ScreenHeight);
+    #if defined(DEBUG) || defined(PROFILE)
+        return g_CascadeTimes[cascade];
+    #else
+        return 0.0f;
+    #endif
 }
 
 unsigned int InitShadowMapArray(unsigned int count)
 {
     unsigned int shadowMapArray;
     glGenTextures(1, &shadowMapArray);
-    glBindTexture(GL_TEXTURE_2D_ARRAY, shadowMapArray);
+    BindTextureArray(shadowMapArray, 0);
     glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_DEPTH_COMPONENT, SHADOWMAP_SIZE, SHADOWMAP_SIZE, count, 0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
     glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
@@ -109,7 +292,7 @@ unsigned int InitCubeShadowMapArray(unsigned int count)
 {
     unsigned int shadowMapArray;
     glGenTextures(1, &shadowMapArray);
-    glBindTexture(GL_TEXTURE_CUBE_MAP_ARRAY, shadowMapArray);
+    BindTextureTarget(GL_TEXTURE_CUBE_MAP_ARRAY, shadowMapArray, 0);
     glTexImage3D(GL_TEXTURE_CUBE_MAP_ARRAY, 0, GL_DEPTH_COMPONENT, SHADOWMAP_SIZE, SHADOWMAP_SIZE, count * 6, 0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
     glTexParameteri(GL_TEXTURE_CUBE_MAP_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_CUBE_MAP_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
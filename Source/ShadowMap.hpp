@@ -1,6 +1,32 @@
 #pragma once
 
+#include <glm.hpp>
+
 constexpr unsigned int SHADOWMAP_SIZE = 1024;
+// the cascades of a directional light share its layer, one quadrant each: cascade 0 bottom left, 1 bottom right, 2 top left, 3 top right
+inline constexpr unsigned int SHADOW_CASCADE_COUNT = 4;
+inline constexpr unsigned int SHADOW_CASCADE_SIZE = SHADOWMAP_SIZE / 2;
+inline constexpr unsigned int SHADOW_LAYERS_BINDING = 13; // storage buffer binding of the ShadowLayerData of the layered shadow pass
+
+/**
+ * \brief A shadow map or a face of a cube shadow map, as a layer of the shadow map arrays.
+ * The live arrays are sampled by the deferred pass, the static arrays of the same size cache the depth of the casters that don't move
+ */
+struct ShadowMapLayer{
+    unsigned int fbo;
+    bool cube;
+    unsigned int layer; // index * 6 + face for the cube maps
+    int cascade = -1; // the quadrant drawn by a cascade of a directional light, -1 for the whole layer
+};
+
+inline unsigned int GetShadowLayerSize(const ShadowMapLayer& layer) { return layer.cascade < 0 ? SHADOWMAP_SIZE : SHADOW_CASCADE_SIZE; }
+inline unsigned int GetShadowLayerX(const ShadowMapLayer& layer) { return layer.cascade < 0 ? 0 : (layer.cascade % 2) * SHADOW_CASCADE_SIZE; }
+inline unsigned int GetShadowLayerY(const ShadowMapLayer& layer) { return layer.cascade < 0 ? 0 : (layer.cascade / 2) * SHADOW_CASCADE_SIZE; }
+/**
+ * \brief Index of the view drawn into the layer: SHADOW_CASCADE_COUNT slots for each layer of the shadow map array, one for each face of the cube array.
+ * The shadow caches and the ShadowLayerData of the layered pass are indexed by it
+ */
+inline unsigned int GetShadowViewIndex(const ShadowMapLayer& layer) { return layer.cube ? layer.layer : layer.layer * SHADOW_CASCADE_COUNT + (layer.cascade < 0 ? 0 : layer.cascade); }
 
 class ShadowMap{
 public:
@@ -10,10 +36,13 @@ public:
     void Init();
     void Deinit();
 
-    void Bind() const;
-    void Unbind() const;
-
+    inline ShadowMapLayer GetLayer() const { return {m_FBO, false, (unsigned int)m_ShadowMapIndex}; }
+    /**
+     * \brief The quadrant of the layer drawn by a cascade of a directional light
+     */
+    inline ShadowMapLayer GetCascadeLayer(unsigned int cascade) const { return {m_FBO, false, (unsigned int)m_ShadowMapIndex, (int)cascade}; }
     inline unsigned int GetShadowMapIndex() const { return m_ShadowMapIndex; }
+    inline bool HasShadowMap() const { return m_ShadowMapIndex != -1; }
 
 private:
     unsigned int m_FBO;
@@ -28,15 +57,77 @@ public:
     void Init();
     void Deinit();
 
-    void Bind(unsigned int face) const;
-    void Unbind() const;
-
+    inline ShadowMapLayer GetLayer(unsigned int face) const { return {m_FBO, true, (unsigned int)m_ShadowMapIndex * 6 + face}; }
     inline unsigned int GetShadowMapIndex() const { return m_ShadowMapIndex; }
+    inline bool HasShadowMap() const { return m_ShadowMapIndex != -1; }
 
 private:
     unsigned int m_FBO;
     int m_ShadowMapIndex = -1;
 };
 
+/**
+ * \brief What the layered shadow shaders read for each view they draw, indexed by GetShadowViewIndex
+ */
+struct ShadowLayerData{
+    glm::mat4 light_space_matrix;
+    glm::vec4 light_position; // the point light shadows store the distance from it, w unused
+    int layer;
+    int viewport; // 0 for the whole layer, 1 + the cascade for its quadrant
+    int padding[2];
+};
+
+/**
+ * \brief Attach the layer of the live or of the static array to its framebuffer, set the viewport to its quadrant or to the whole layer and optionally clear the depth there
+ */
+void BindShadowMapLayer(const ShadowMapLayer& layer, bool static_cache = false, bool clear = true);
+/**
+ * \brief Copy the static cache of the layer (or of its quadrant) to the live array, the dynamic casters are then drawn over the static ones
+ */
+void CopyStaticShadowMapLayer(const ShadowMapLayer& layer);
+void ClearShadowMapLayer(const ShadowMapLayer& layer, bool static_cache = false);
+void UnbindShadowMapLayer();
+
+/**
+ * \brief Framebuffer and layer buffers of the layered shadow pass, which draws into all the layers of a shadow map array with one submission.
+ * The vertex shader writes gl_Layer and gl_ViewportIndex where GL_ARB_shader_viewport_layer_array (or both GL_AMD_vertex_shader_layer and GL_AMD_vertex_shader_viewport_index)
+ * is available, a geometry shader does it elsewhere
+ */
+void InitLayeredShadowMaps();
+void DeinitLayeredShadowMaps();
+/**
+ * \brief Whether the vertex shaders can write gl_Layer and gl_ViewportIndex, the layered shadow shaders need the geometry shader otherwise
+ */
+bool HasVertexShaderLayer();
+/**
+ * \brief Copy the data of the layers to the buffer of the array and bind it to SHADOW_LAYERS_BINDING
+ * \param count at most MAX_SHADOWED_LIGHTS * 2 * SHADOW_CASCADE_COUNT for the shadow map array, MAX_SHADOWED_LIGHTS * 6 for the cube one
+ */
+void SetShadowLayers(bool cube, const ShadowLayerData* layers, unsigned int count);
+/**
+ * \brief Attach every layer of the live or static array to the layered framebuffer and set the viewports: 0 covers the whole layers, 1 + the cascade its quadrant. Nothing is cleared
+ */
+void BindShadowMapArray(bool cube, bool static_cache = false);
+
+/**
+ * \brief GPU time of drawing each cascade, from timestamp queries read a few frames later so nothing waits for the GPU.
+ * Only the cascades of one light are timed, and only by the per map path: the layered pass draws them all together. DEBUG and PROFILE builds only
+ */
+void InitShadowCascadeTimers();
+void DeinitShadowCascadeTimers();
+/**
+ * \brief Read the finished queries and start timing a frame, if a query set is free
+ */
+void BeginShadowCascadeTimers();
+/**
+ * \brief Mark the start of the cascade on the GPU, the cascades are drawn in order
+ */
+void TimeShadowCascade(unsigned int cascade);
+void EndShadowCascadeTimers();
+/**
+ * \returns milliseconds, 0 until a frame was timed
+ */
+float GetShadowCascadeTime(unsigned int cascade);
+
 unsigned int InitShadowMapArray(unsigned int count);
 unsigned int InitCubeShadowMapArray(unsigned int count);
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include <Skydome.hpp>
+#include <OpenGL.hpp>
 #include <Log.hpp>
 #include <Shader.hpp>
 #include <ResourceManager.hpp>
@@ -78,7 +79,7 @@ void LoadSkydome(const std::string& hdri)
     }
 
     glGenTextures(1, &skydomeTexture);
-    glBindTexture(GL_TEXTURE_2D, skydomeTexture);
+    BindTexture(skydomeTexture, 0);
     glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB32F, width, height, 0, GL_RGB, GL_FLOAT, data);
 
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
@@ -94,44 +95,41 @@ void LoadSkydome(const std::string& hdri)
     glGenBuffers(1, &skydomeVBO);
     glGenBuffers(1, &skydomeEBO);
 
-    glBindVertexArray(skydomeVAO);
+    BindVertexArray(skydomeVAO);
 
-    glBindBuffer(GL_ARRAY_BUFFER, skydomeVBO);
+    BindBuffer(GL_ARRAY_BUFFER, skydomeVBO);
     glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
 
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, skydomeEBO);
+    BindBuffer(GL_ELEMENT_ARRAY_BUFFER, skydomeEBO);
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
 
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
     glEnableVertexAttribArray(0);
 
-    glBindVertexArray(0);
+    BindVertexArray(0);
 
     skydomeShader = LoadShader("Resources/Shaders/Skydome.vert", "Resources/Shaders/Skydome.frag");
 }
 
 void UnloadSkydome()
 {
-    glDeleteTextures(1, &skydomeTexture);
-    glDeleteVertexArrays(1, &skydomeVAO);
-    glDeleteBuffers(1, &skydomeVBO);
-    glDeleteBuffers(1, &skydomeEBO);
+    DeleteTextures(1, &skydomeTexture);
+    DeleteVertexArrays(1, &skydomeVAO);
+    DeleteBuffers(1, &skydomeVBO);
+    DeleteBuffers(1, &skydomeEBO);
 }
 
-void DrawSkydome(glm::mat4 view, glm::mat4 projection, glm::mat4 model)
+void DrawSkydome(glm::mat4 model)
 {
     Shader& shader = *GetShader(skydomeShader);
     shader.Bind();
-    shader.SetUniformMat4fv("view", view);
-    shader.SetUniformMat4fv("projection", projection);
     shader.SetUniformMat4fv("model", model);
 
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, skydomeTexture);
+    BindTexture(skydomeTexture, 0);
 
-    glBindVertexArray(skydomeVAO);
+    BindVertexArray(skydomeVAO);
     glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
-    glBindVertexArray(0);
+    BindVertexArray(0);
 
     shader.Unbind();
 }
\ No newline at end of file
@@ -5,4 +5,7 @@
 
 extern void LoadSkydome(const std::string& hdri);
 extern void UnloadSkydome();
-extern void DrawSkydome(glm::mat4 view, glm::mat4 projection, glm::mat4 model);
\ No newline at end of file
+/**
+ * \brief Draw the skydome with the camera of the Camera block
+ */
+extern void DrawSkydome(glm::mat4 model);
\ No newline at end of file
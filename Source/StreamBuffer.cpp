@@ -0,0 +1,178 @@
+#include <StreamBuffer.hpp>
+#include <OpenGL.hpp>
+#include <Timer.hpp>
+#include <Log.hpp>
+
+#include <glad/glad.h>
+
+#include <chrono>
+#include <algorithm>
+#include <vector>
+#include <cstdio>
+
+static constexpr GLbitfield PERSISTENT_FLAGS = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+static constexpr size_t SLOT_ALIGNMENT = 256; // the slots start aligned for every kind of binding
+
+static unsigned int g_Buffer = 0;
+static uint8_t* g_Mapped = nullptr;
+static size_t g_SlotSize = 0;
+static unsigned int g_Slot = 0;
+static size_t g_Offset = 0; // bump pointer in the current slot
+static GLsync g_Fences[STREAM_FRAMES] = {};
+static std::vector<unsigned int> g_Retired; // replaced by a bigger buffer during this frame, still referenced by its draws
+
+static size_t g_StorageAlignment = 16;
+static double g_StallTime = 0.0;
+
+static void DeleteFences()
+{
+    for(GLsync& fence : g_Fences){
+        if(fence){
+            glDeleteSync(fence);
+            fence = nullptr;
+        }
+    }
+}
+
+static void DeleteBuffer(unsigned int buffer)
+{
+    BindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+    glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+    BindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    DeleteBuffers(1, &buffer);
+}
+
+static void DeleteRetiredBuffers()
+{
+    for(unsigned int buffer : g_Retired){
+        DeleteBuffer(buffer);
+    }
+
+    g_Retired.clear();
+}
+
+static void AllocateBuffer(size_t slot_size)
+{
+    slot_size = (slot_size + SLOT_ALIGNMENT - 1) / SLOT_ALIGNMENT * SLOT_ALIGNMENT;
+
+    if(g_Buffer){
+        g_Retired.push_back(g_Buffer);
+    }
+
+    glGenBuffers(1, &g_Buffer);
+    BindBuffer(GL_COPY_WRITE_BUFFER, g_Buffer);
+    glBufferStorage(GL_COPY_WRITE_BUFFER, slot_size * STREAM_FRAMES, nullptr, PERSISTENT_FLAGS);
+    g_Mapped = (uint8_t*)glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, slot_size * STREAM_FRAMES, PERSISTENT_FLAGS);
+    BindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    if(!g_Mapped){
+        LogError("Couldn't map the stream buffer");
+    }
+
+    // nothing has been drawn from the new buffer yet
+    DeleteFences();
+
+    g_SlotSize = slot_size;
+    g_Offset = 0;
+}
+
+void InitStreamBuffer(size_t slot_size)
+{
+    int alignment = 0;
+    glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    g_StorageAlignment = std::max(alignment, 1);
+
+    g_Slot = 0;
+    AllocateBuffer(slot_size);
+}
+
+void DeinitStreamBuffer()
+{
+    DeleteFences();
+    DeleteRetiredBuffers();
+
+    if(g_Buffer){
+        DeleteBuffer(g_Buffer);
+    }
+
+    g_Buffer = 0;
+    g_Mapped = nullptr;
+    g_SlotSize = 0;
+}
+
+void BeginStreamFrame()
+{
+    g_Slot = (g_Slot + 1) % STREAM_FRAMES;
+    g_Offset = 0;
+    g_StallTime = 0.0;
+
+    GLsync& fence = g_Fences[g_Slot];
+
+    if(fence){
+        auto start = std::chrono::high_resolution_clock::now();
+
+        GLenum result = glClientWaitSync(fence, 0, 0);
+        if(result == GL_TIMEOUT_EXPIRED){
+            do{
+                result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000); // 1 ms
+            }while(result == GL_TIMEOUT_EXPIRED);
+        }
+
+        if(result == GL_WAIT_FAILED){
+            LogError("Waiting for the stream buffer fence failed");
+        }
+
+        g_StallTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+        glDeleteSync(fence);
+        fence = nullptr;
+    }
+
+    #if defined(DEBUG) || defined(PROFILE)
+        if(GetShouldDisplayTimers()){
+            printf("Stream buffer stall: %f ms\n", g_StallTime);
+        }
+    #endif
+}
+
+void EndStreamFrame()
+{
+    // all the draws that read the old buffers have been issued, the driver keeps their storage until they are done
+    DeleteRetiredBuffers();
+
+    if(g_Fences[g_Slot]){
+        glDeleteSync(g_Fences[g_Slot]);
+    }
+
+    g_Fences[g_Slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+StreamAllocation StreamAllocate(size_t size, size_t alignment)
+{
+    size_t offset = (g_Offset + alignment - 1) / alignment * alignment;
+
+    if(offset + size > g_SlotSize){
+        #ifdef DEBUG
+            LogWarning("Stream buffer slot full (%zu bytes), growing it", g_SlotSize);
+        #endif
+
+        AllocateBuffer(std::max(g_SlotSize * 2, size));
+        offset = 0;
+    }
+
+    g_Offset = offset + size;
+
+    size_t buffer_offset = g_Slot * g_SlotSize + offset;
+
+    return {g_Mapped + buffer_offset, buffer_offset, g_Buffer};
+}
+
+size_t GetStreamStorageAlignment()
+{
+    return g_StorageAlignment;
+}
+
+double GetStreamStallTime()
+{
+    return g_StallTime;
+}
\ No newline at end of file
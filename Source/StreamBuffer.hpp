@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+inline constexpr unsigned int STREAM_FRAMES = 3; // one slot of the buffer for each frame in flight
+inline constexpr size_t STREAM_SLOT_SIZE = 8 << 20; // starting size of a slot, ~65k instances
+
+/**
+ * \brief Space written by the CPU during this frame. buffer and offset are what to bind, data is where to write
+ */
+struct StreamAllocation{
+    void* data;
+    size_t offset;
+    unsigned int buffer;
+};
+
+/**
+ * \brief Triple buffered, persistently mapped buffer for the data written every frame (instances, immediate-mode vertices, glyphs).
+ * Each frame bump-allocates from its own slot, so writing never waits for the draws of the previous frames.
+ * A fence per slot makes sure the GPU is done with a slot before it is reused
+ */
+extern void InitStreamBuffer(size_t slot_size);
+extern void DeinitStreamBuffer();
+
+/**
+ * \brief Move to the next slot, waiting for its fence if the GPU is still reading it. Call at the start of the frame
+ */
+extern void BeginStreamFrame();
+/**
+ * \brief Fence the slot of this frame. Call after the last draw of the frame
+ */
+extern void EndStreamFrame();
+
+/**
+ * \brief Bump-allocate size bytes in the slot of this frame. The slot grows (in a new buffer) if it's full
+ * \param alignment of the offset in the buffer, e.g. the storage buffer offset alignment to bind the range as a block
+ */
+extern StreamAllocation StreamAllocate(size_t size, size_t alignment = 16);
+
+extern size_t GetStreamStorageAlignment();
+/**
+ * \brief Milliseconds BeginStreamFrame waited for the GPU in the last frame
+ */
+extern double GetStreamStallTime();
\ No newline at end of file
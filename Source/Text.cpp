@@ -2,6 +2,7 @@
 #include <OpenGL.hpp>
 #include <Log.hpp>
 #include <Globals.hpp>
+#include <StreamBuffer.hpp>
 #include <gtc/matrix_transform.hpp>
 #include <gtc/matrix_transform.hpp>
 
@@ -15,8 +16,6 @@ void TextRenderer::Init(const std::string& font_path, float glyph_size){
     m_GlyphSize = glyph_size;
 
     m_Characters.resize(CH_NUM);
-    m_Transforms.resize(CH_LIMIT);
-    m_ToRender.resize(CH_LIMIT);
 
     if(FT_Init_FreeType(&m_FT)){
         LogError("Couldn't init FreeType Library");
@@ -31,8 +30,7 @@ void TextRenderer::Init(const std::string& font_path, float glyph_size){
         glPixelStorei(GL_UNPACK_ALIGNMENT, 1); //disable byte-alignment restriction
 
         glGenTextures(1, &m_TextureArrayID);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D_ARRAY, m_TextureArrayID);
+        BindTextureArray(m_TextureArrayID, 0);
         glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_R8, glyph_size, glyph_size, CH_NUM,
                      0, GL_RED, GL_UNSIGNED_BYTE, 0);
 
@@ -95,7 +93,7 @@ void TextRenderer::Init(const std::string& font_path, float glyph_size){
 }
 
 void TextRenderer::Deinit(){
-    glDeleteTextures(1, &m_TextureArrayID);
+    DeleteTextures(1, &m_TextureArrayID);
     m_GPUBuffer.Free();
     m_Shader.Unload();
 }
@@ -115,7 +113,10 @@ void TextRenderer::DrawText(const std::string& text, unsigned int x, unsigned in
     m_GPUBuffer.BindVBO();
     m_GPUBuffer.BindVAO();
 
-    int workingIndex = 0;
+    // at most one glyph per character, the whole string is drawn with a single call
+    StreamAllocation alloc = StreamAllocate(text.size() * sizeof(Glyph), GetStreamStorageAlignment());
+    Glyph* glyphs = (Glyph*) alloc.data;
+    int num_glyphs = 0;
 
     for(char c : text){
         if(c == '\0'){  // Null terminator
@@ -133,33 +134,21 @@ void TextRenderer::DrawText(const std::string& text, unsigned int x, unsigned in
             float xpos = x + (ch.bearing.x * scale);
             float ypos = y - ((m_GlyphSize - ch.bearing.y) * scale);
 
-            m_Transforms[workingIndex] = glm::translate(glm::mat4(1.0f), glm::vec3(xpos, ypos, 0)) * 
-                                         glm::scale(glm::mat4(1.0f), glm::vec3(m_GlyphSize * scale, m_GlyphSize * scale, 0.0f));
-            m_ToRender[workingIndex] = ch.texID;
+            glyphs[num_glyphs++] = {glm::vec2(xpos, ypos), m_GlyphSize * scale, (int)ch.texID};
 
             x += ((ch.advance >> 6) * scale);
-
-            workingIndex++;
-            if(workingIndex == CH_LIMIT - 1){ // if we reach the limit, draw and reset
-                Draw(workingIndex);
-                workingIndex = 0;
-            }
         }
     }
-    Draw(workingIndex); // draw the remaining characters
+
+    if(num_glyphs > 0){
+        BindBufferRange(GL_SHADER_STORAGE_BUFFER, GLYPHS_BINDING, alloc.buffer, alloc.offset, num_glyphs * sizeof(Glyph));
+        glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, num_glyphs);
+    }
 
     DisableColorBlend();
     EnableDepthTest();
 }
 
-void TextRenderer::Draw(int num_characters){
-    if(num_characters > 0){
-        m_Shader.SetUniformMat4fv("transforms", m_Transforms[0], num_characters);
-        m_Shader.SetUniform1iv("letterMap", &m_ToRender[0], num_characters);
-        glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, num_characters);
-    }
-}
-
 static TextRenderer g_DefaultTextRenderer;
 
 void InitTextRenderer(const std::string& font_path, float glyph_size){
@@ -10,8 +10,8 @@
 
 #include <vector>
 
-inline constexpr unsigned int CH_LIMIT = 100;
 inline constexpr unsigned int CH_NUM = 128;
+inline constexpr unsigned int GLYPHS_BINDING = 10; // storage buffer binding, after the light blocks
 
 class TextRenderer{
 public:
@@ -28,8 +28,6 @@ public:
 
 private:
 
-    void Draw(int num_characters);
-
     struct Character{
         unsigned int texID;     // ID of the glyph texture       
         glm::ivec2 size;        // Size of glyph
@@ -37,6 +35,15 @@ private:
         unsigned int advance;   // Horizontal offset to advance to next glyph
     };
 
+    /**
+     * \brief std430 layout of a glyph in Text.vert, written to the stream buffer
+     */
+    struct Glyph{
+        glm::vec2 position;
+        float size;
+        int letter;
+    };
+
     FT_Library m_FT;
     FT_Face m_Face;
 
@@ -45,8 +52,6 @@ private:
 
     unsigned int m_TextureArrayID;
     std::vector<Character> m_Characters;
-    std::vector<glm::mat4> m_Transforms;
-    std::vector<int> m_ToRender;
 
     std::string m_FontPath;
     float m_GlyphSize;
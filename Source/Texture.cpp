@@ -1,4 +1,5 @@
 #include <Texture.hpp>
+#include <OpenGL.hpp>
 #include <Log.hpp>
 
 #include <stb_image.h>
@@ -29,6 +30,7 @@ void Texture::Init(const std::string& path, const std::string& type, bool flip)
 {
     m_Path = path;
     m_Type = type;
+    m_TypeUniform = type;
     _Init(path, flip, nullptr);
 }
 
@@ -36,6 +38,7 @@ void Texture::Init(const std::string& path, unsigned char* data, const std::stri
 {
     m_Path = path;
     m_Type = type;
+    m_TypeUniform = type;
     m_Width = width;
     m_Height = height;
     _Init(path, flip, data);
@@ -46,7 +49,7 @@ void Texture::_Init(const std::string& path, bool flip, unsigned char* data)
     LogMessage("Loading texture %s", path.c_str());
 
     glGenTextures(1, &m_ID);
-    glBindTexture(GL_TEXTURE_2D, m_ID);
+    BindTexture(m_ID, 0);
 
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
@@ -85,16 +88,15 @@ void Texture::_Init(const std::string& path, bool flip, unsigned char* data)
 
 void Texture::Free()
 {
-    glDeleteTextures(1, &m_ID);
+    DeleteTextures(1, &m_ID);
 }
 
 void Texture::Bind(unsigned int slot) const
 {
-    glActiveTexture(GL_TEXTURE0 + slot);
-    glBindTexture(GL_TEXTURE_2D, m_ID);
+    BindTexture(m_ID, slot);
 }
 
-void Texture::Unbind() const
+void Texture::Unbind(unsigned int slot) const
 {
-    glBindTexture(GL_TEXTURE_2D, 0);
+    BindTexture(0, slot);
 }
\ No newline at end of file
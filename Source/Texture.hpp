@@ -1,5 +1,7 @@
 #pragma once
 
+#include <UniformHandle.hpp>
+
 #include <string>
 
 class Texture{
@@ -17,7 +19,7 @@ public:
     void Free();
 
     void Bind(unsigned int slot = 0) const;
-    void Unbind() const;
+    void Unbind(unsigned int slot = 0) const;
 
     inline unsigned int GetID() const { return m_ID; }
     inline unsigned int GetWidth() const { return m_Width; }
@@ -25,10 +27,14 @@ public:
 
     inline const std::string& GetPath() const { return m_Path; }
     inline const std::string& GetType() const { return m_Type; }
+    /**
+     * \brief Handle of the sampler uniform named after the type, hashed once when the type is set
+     */
+    inline UniformHandle GetTypeUniform() const { return m_TypeUniform; }
 
     void SetId(unsigned int id) { m_ID = id; }
     void SetPath(const std::string& path) { m_Path = path; }
-    void SetType(const std::string& type) { m_Type = type; }
+    void SetType(const std::string& type) { m_Type = type; m_TypeUniform = type; }
 
 private:
     void _Init(const std::string& path, bool flip, unsigned char* data);
@@ -37,4 +43,5 @@ private:
     int m_Width, m_Height, m_BPP;
     std::string m_Path;
     std::string m_Type = "";
+    UniformHandle m_TypeUniform = "";
 };
\ No newline at end of file
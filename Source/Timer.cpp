@@ -98,6 +98,19 @@ void ShouldDisplayTimers(bool shouldDisplay)
     #endif
 }
 
+bool GetShouldDisplayTimers()
+{
+    #if defined(DEBUG) || defined(PROFILE)
+
+    return ShouldDisplay;
+
+    #else
+
+    return false;
+
+    #endif
+}
+
 int Timer::Hash(const char* str)
 {
     int h = 0;
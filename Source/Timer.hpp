@@ -19,4 +19,5 @@ private:
 };
 
 extern void ShouldDisplayTimers(bool shouldDisplay);
+extern bool GetShouldDisplayTimers();
 extern void FreeRemainingTimers();
\ No newline at end of file
@@ -0,0 +1,78 @@
+#include <UniformBlocks.hpp>
+#include <PersistentBlock.hpp>
+
+static constexpr uint32_t INITIAL_LIGHTS_CAPACITY = 16; // the light blocks grow past it
+
+static PersistentBlock g_CameraBlock;
+static PersistentBlock g_PointLightsBlock;
+static PersistentBlock g_DirectionalLightsBlock;
+static PersistentBlock g_SpotLightsBlock;
+
+void InitUniformBlocks()
+{
+    g_CameraBlock.Init(GL_UNIFORM_BUFFER, CAMERA_BLOCK_BINDING, sizeof(CameraBlock));
+    g_PointLightsBlock.Init(GL_SHADER_STORAGE_BUFFER, POINT_LIGHTS_BINDING, LIGHTS_HEADER_SIZE + INITIAL_LIGHTS_CAPACITY * sizeof(PointLightData));
+    g_DirectionalLightsBlock.Init(GL_SHADER_STORAGE_BUFFER, DIRECTIONAL_LIGHTS_BINDING, LIGHTS_HEADER_SIZE + INITIAL_LIGHTS_CAPACITY * sizeof(DirectionalLightData));
+    g_SpotLightsBlock.Init(GL_SHADER_STORAGE_BUFFER, SPOT_LIGHTS_BINDING, LIGHTS_HEADER_SIZE + INITIAL_LIGHTS_CAPACITY * sizeof(SpotLightData));
+}
+
+void DeinitUniformBlocks()
+{
+    g_CameraBlock.Deinit();
+    g_PointLightsBlock.Deinit();
+    g_DirectionalLightsBlock.Deinit();
+    g_SpotLightsBlock.Deinit();
+}
+
+void UpdateCameraBlock(const glm::mat4& view, const glm::mat4& projection, const glm::vec3& position)
+{
+    CameraBlock camera = {view, projection, glm::vec4(position, 1.0f)};
+
+    g_CameraBlock.Begin();
+    g_CameraBlock.Write(0, &camera, sizeof(CameraBlock));
+    g_CameraBlock.Bind();
+}
+
+void BeginLightBlocks()
+{
+    g_PointLightsBlock.Begin();
+    g_DirectionalLightsBlock.Begin();
+    g_SpotLightsBlock.Begin();
+}
+
+void WritePointLight(uint32_t index, const PointLightData& light)
+{
+    g_PointLightsBlock.Write(LIGHTS_HEADER_SIZE + index * sizeof(PointLightData), &light, sizeof(PointLightData));
+}
+
+void WriteDirectionalLight(uint32_t index, const DirectionalLightData& light)
+{
+    g_DirectionalLightsBlock.Write(LIGHTS_HEADER_SIZE + index * sizeof(DirectionalLightData), &light, sizeof(DirectionalLightData));
+}
+
+void WriteSpotLight(uint32_t index, const SpotLightData& light)
+{
+    g_SpotLightsBlock.Write(LIGHTS_HEADER_SIZE + index * sizeof(SpotLightData), &light, sizeof(SpotLightData));
+}
+
+void EndLightBlocks(uint32_t num_point_lights, uint32_t num_directional_lights, uint32_t num_spot_lights)
+{
+    int point_count = num_point_lights, directional_count = num_directional_lights, spot_count = num_spot_lights;
+
+    g_PointLightsBlock.Write(0, &point_count, sizeof(int));
+    g_DirectionalLightsBlock.Write(0, &directional_count, sizeof(int));
+    g_SpotLightsBlock.Write(0, &spot_count, sizeof(int));
+
+    // bound again every frame: the copy changes, and GPUCulling binds its own storage buffers
+    g_PointLightsBlock.Bind();
+    g_DirectionalLightsBlock.Bind();
+    g_SpotLightsBlock.Bind();
+}
+
+void FenceUniformBlocks()
+{
+    g_CameraBlock.End();
+    g_PointLightsBlock.End();
+    g_DirectionalLightsBlock.End();
+    g_SpotLightsBlock.End();
+}
\ No newline at end of file
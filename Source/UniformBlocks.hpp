@@ -0,0 +1,82 @@
+#pragma once
+
+#include <ShadowMap.hpp>
+
+#include <glm.hpp>
+#include <cstdint>
+
+inline constexpr unsigned int CAMERA_BLOCK_BINDING = 0; // uniform buffer binding
+
+// storage buffer bindings, after the ones used by GPUCulling.comp
+inline constexpr unsigned int POINT_LIGHTS_BINDING = 7;
+inline constexpr unsigned int DIRECTIONAL_LIGHTS_BINDING = 8;
+inline constexpr unsigned int SPOT_LIGHTS_BINDING = 9;
+
+/**
+ * \brief std140 layout of the Camera block, shared by the G-buffer, deferred and skydome shaders
+ */
+struct CameraBlock{
+    glm::mat4 view;
+    glm::mat4 projection;
+    glm::vec4 position; // w unused
+};
+
+// std430 layouts of the light arrays. each light block starts with the number of lights, padded to 16 bytes
+inline constexpr size_t LIGHTS_HEADER_SIZE = 16;
+
+struct PointLightData{
+    glm::vec4 position;
+    glm::vec4 color;
+    int shadowMapIndex; // -1 without a shadow map
+    float range; // distance where the light fades out, see GetLightRange
+    int padding[2];
+};
+
+struct DirectionalLightData{
+    glm::vec4 direction;
+    glm::vec4 color;
+    glm::mat4 lightSpaceMatrices[SHADOW_CASCADE_COUNT];
+    glm::vec4 cascadeSplits; // view distance where each cascade ends
+    glm::vec4 cascadeBiases; // depth bias of each cascade, in the depth of its projection
+    int shadowMapIndex; // the layer of the cascades, -1 without a shadow map
+    int padding[3];
+};
+
+struct SpotLightData{
+    glm::vec4 position;
+    glm::vec4 direction;
+    glm::vec4 color;
+    glm::mat4 lightSpaceMatrix;
+    float cutOff;
+    float outerCutOff;
+    int shadowMapIndex;
+    float range;
+};
+
+static_assert(sizeof(CameraBlock) == 144 && sizeof(PointLightData) == 48 && sizeof(DirectionalLightData) == 336 && sizeof(SpotLightData) == 128,
+              "the blocks must match the layouts in the shaders");
+
+extern void InitUniformBlocks();
+extern void DeinitUniformBlocks();
+
+/**
+ * \brief Write the camera of this frame and bind its block. Call once per frame, before the G-buffer pass
+ */
+extern void UpdateCameraBlock(const glm::mat4& view, const glm::mat4& projection, const glm::vec3& position);
+
+/**
+ * \brief Start writing the lights of this frame. Only the lights that differ from what their slot holds are uploaded
+ */
+extern void BeginLightBlocks();
+extern void WritePointLight(uint32_t index, const PointLightData& light);
+extern void WriteDirectionalLight(uint32_t index, const DirectionalLightData& light);
+extern void WriteSpotLight(uint32_t index, const SpotLightData& light);
+/**
+ * \brief Write the number of lights of each type and bind the light blocks for the deferred pass
+ */
+extern void EndLightBlocks(uint32_t num_point_lights, uint32_t num_directional_lights, uint32_t num_spot_lights);
+
+/**
+ * \brief Fence the blocks of this frame. Call after the last draw that reads them
+ */
+extern void FenceUniformBlocks();
\ No newline at end of file
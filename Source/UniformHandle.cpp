@@ -0,0 +1,79 @@
+#include <UniformHandle.hpp>
+#include <Log.hpp>
+
+#include <glad/glad.h>
+#include <algorithm>
+
+void UniformTable::Build(unsigned int program)
+{
+    std::vector<std::pair<std::string, int>> uniforms;
+
+    int num_uniforms = 0, max_length = 0;
+    glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &num_uniforms);
+    glGetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &max_length);
+
+    std::vector<char> buffer(max_length + 1);
+
+    for(int i = 0; i < num_uniforms; i++){
+        int length = 0, size = 0;
+        GLenum type;
+        glGetActiveUniform(program, i, buffer.size(), &length, &size, &type, buffer.data());
+
+        std::string name(buffer.data(), length);
+        int location = glGetUniformLocation(program, name.c_str());
+
+        if(location == -1){ // members of the uniform blocks
+            continue;
+        }
+
+        uniforms.emplace_back(name, location);
+
+        // the arrays are listed once as "name[0]"
+        if(size > 1 || (name.size() > 3 && name.compare(name.size() - 3, 3, "[0]") == 0)){
+            std::string base = name.substr(0, name.size() - 3);
+
+            uniforms.emplace_back(base, location);
+
+            for(int j = 1; j < size; j++){
+                std::string element = base + "[" + std::to_string(j) + "]";
+                uniforms.emplace_back(element, glGetUniformLocation(program, element.c_str()));
+            }
+        }
+    }
+
+    Build(uniforms);
+}
+
+void UniformTable::Build(const std::vector<std::pair<std::string, int>>& uniforms)
+{
+    m_Slots.clear();
+    m_Slots.reserve(uniforms.size());
+
+    for(const auto& [name, location] : uniforms){
+        m_Slots.push_back({UniformHandle(name).GetHash(), location});
+    }
+
+    std::sort(m_Slots.begin(), m_Slots.end(), [](const Slot& a, const Slot& b){ return a.hash < b.hash; });
+
+    for(size_t i = 1; i < m_Slots.size(); i++){
+        if(m_Slots[i].hash == m_Slots[i - 1].hash && m_Slots[i].location != m_Slots[i - 1].location){
+            LogWarning("Two uniforms have the same hash");
+        }
+    }
+}
+
+void UniformTable::Clear()
+{
+    m_Slots.clear();
+}
+
+int UniformTable::GetLocation(UniformHandle handle) const
+{
+    auto it = std::lower_bound(m_Slots.begin(), m_Slots.end(), handle.GetHash(), [](const Slot& slot, uint64_t hash){ return slot.hash < hash; });
+
+    if(it == m_Slots.end() || it->hash != handle.GetHash()){
+        return -1;
+    }
+
+    return it->location;
+}
\ No newline at end of file
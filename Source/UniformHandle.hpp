@@ -0,0 +1,97 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <cstdint>
+
+/**
+ * \brief A uniform name reduced to its 64 bit FNV-1a hash. Built from a literal the hash is computed at compile time
+ */
+class UniformHandle{
+public:
+    constexpr UniformHandle(const char* name) : m_Hash(Append(FNV_OFFSET, name)), m_Name(name) {}
+    UniformHandle(const std::string& name) : m_Hash(Append(FNV_OFFSET, name.c_str())), m_Name(nullptr) {}
+
+    /**
+     * \brief Handle of prefix + index + suffix, e.g. Indexed("pointLights[", 2, "].color") for "pointLights[2].color", without building the string
+     */
+    static constexpr UniformHandle Indexed(const char* prefix, unsigned int index, const char* suffix = "]")
+    {
+        char digits[10] = {};
+        int count = 0;
+
+        do{
+            digits[count++] = '0' + index % 10;
+            index /= 10;
+        }while(index > 0);
+
+        uint64_t hash = Append(FNV_OFFSET, prefix);
+        while(count > 0){
+            hash = Append(hash, digits[--count]);
+        }
+
+        return UniformHandle(Append(hash, suffix), prefix);
+    }
+
+    inline constexpr uint64_t GetHash() const { return m_Hash; }
+    /**
+     * \brief The name for the messages. nullptr for the handles built from a std::string, the prefix for the indexed ones
+     */
+    inline constexpr const char* GetName() const { return m_Name; }
+
+private:
+    static constexpr uint64_t FNV_OFFSET = 14695981039346656037ull;
+    static constexpr uint64_t FNV_PRIME = 1099511628211ull;
+
+    constexpr UniformHandle(uint64_t hash, const char* name) : m_Hash(hash), m_Name(name) {}
+
+    static constexpr uint64_t Append(uint64_t hash, char ch)
+    {
+        return (hash ^ (uint8_t)ch) * FNV_PRIME;
+    }
+
+    static constexpr uint64_t Append(uint64_t hash, const char* str)
+    {
+        while(*str){
+            hash = Append(hash, *str++);
+        }
+
+        return hash;
+    }
+
+    uint64_t m_Hash;
+    const char* m_Name;
+};
+
+/**
+ * \brief The active uniforms of a linked program, sorted by hash. Built once after linking, looked up without allocating
+ */
+class UniformTable{
+public:
+    UniformTable() = default;
+    ~UniformTable() = default;
+
+    /**
+     * \brief Query every active uniform of the program. Each array element gets its own entry and the array name alone refers to the first element
+     */
+    void Build(unsigned int program);
+    /**
+     * \brief Build from uniforms already queried, one entry for each name that must be found (array elements included)
+     */
+    void Build(const std::vector<std::pair<std::string, int>>& uniforms);
+    void Clear();
+
+    /**
+     * \brief Location of the uniform, -1 (ignored by glUniform*) if the program doesn't use it
+     */
+    int GetLocation(UniformHandle handle) const;
+
+private:
+    struct Slot{
+        uint64_t hash;
+        int location;
+    };
+
+    std::vector<Slot> m_Slots;
+};
\ No newline at end of file
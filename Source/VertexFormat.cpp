@@ -0,0 +1,140 @@
+#include <VertexFormat.hpp>
+#include <Mesh.hpp>
+
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+void ApplyVertexLayout(const VertexLayout& layout)
+{
+    for(unsigned int i = 0; i < layout.count; i++){
+        const VertexAttribute& attribute = layout.attributes[i];
+
+        glEnableVertexAttribArray(attribute.location);
+
+        if(attribute.integer){
+            glVertexAttribIFormat(attribute.location, attribute.components, attribute.type, attribute.offset);
+        }else{
+            glVertexAttribFormat(attribute.location, attribute.components, attribute.type, attribute.normalized, attribute.offset);
+        }
+
+        glVertexAttribBinding(attribute.location, layout.binding);
+    }
+}
+
+bool HasBoneInfluences(const std::vector<Vertex>& vertices)
+{
+    for(const Vertex& vertex : vertices){
+        if(vertex.BoneIDs[0] >= 0){
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static int16_t PackSnorm16(float value)
+{
+    return (int16_t)std::round(std::clamp(value, -1.0f, 1.0f) * 32767.0f);
+}
+
+/**
+ * \brief Project the unit vector on the octahedron, then unfold the lower half over the corners
+ */
+static void OctahedralEncode(glm::vec3 v, int16_t out[2])
+{
+    float length = std::abs(v.x) + std::abs(v.y) + std::abs(v.z);
+
+    if(length == 0.0f){ // missing tangents
+        out[0] = out[1] = 0;
+        return;
+    }
+
+    float x = v.x / length;
+    float y = v.y / length;
+
+    if(v.z < 0.0f){
+        float folded_x = (1.0f - std::abs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+        float folded_y = (1.0f - std::abs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+        x = folded_x;
+        y = folded_y;
+    }
+
+    out[0] = PackSnorm16(x);
+    out[1] = PackSnorm16(y);
+}
+
+/**
+ * \brief Round to nearest even. Values too big become infinity, values too small become denormals or zero
+ */
+static uint16_t FloatToHalf(float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+
+    uint32_t sign = (bits >> 16) & 0x8000;
+    int32_t exponent = (int32_t)((bits >> 23) & 0xFF) - 127 + 15;
+    uint32_t mantissa = bits & 0x7FFFFF;
+
+    if(((bits >> 23) & 0xFF) == 0xFF){ // infinity and NaN
+        return sign | 0x7C00 | (mantissa ? 0x200 : 0);
+    }
+
+    if(exponent >= 31){
+        return sign | 0x7C00;
+    }
+
+    if(exponent <= 0){
+        if(exponent < -10){
+            return sign;
+        }
+
+        mantissa |= 0x800000; // the implicit bit becomes explicit in denormals
+        uint32_t shift = 14 - exponent;
+        uint32_t half = mantissa >> shift;
+        uint32_t rest = mantissa & ((1u << shift) - 1);
+        uint32_t halfway = 1u << (shift - 1);
+
+        if(rest > halfway || (rest == halfway && (half & 1))){
+            half++;
+        }
+
+        return sign | half;
+    }
+
+    uint32_t half = ((uint32_t)exponent << 10) | (mantissa >> 13);
+    uint32_t rest = mantissa & 0x1FFF;
+
+    if(rest > 0x1000 || (rest == 0x1000 && (half & 1))){
+        half++; // a carry into the exponent is still the right value
+    }
+
+    return sign | half;
+}
+
+StaticVertex EncodeStaticVertex(const Vertex& vertex)
+{
+    StaticVertex encoded;
+
+    encoded.position = vertex.Position;
+    OctahedralEncode(vertex.Normal, encoded.normal);
+    OctahedralEncode(vertex.Tangent, encoded.tangent);
+    encoded.tex_coords[0] = FloatToHalf(vertex.TexCoords.x);
+    encoded.tex_coords[1] = FloatToHalf(vertex.TexCoords.y);
+
+    return encoded;
+}
+
+SkinVertex EncodeSkinVertex(const Vertex& vertex)
+{
+    SkinVertex encoded;
+
+    for(unsigned int i = 0; i < MAX_BONE_INFLUENCE; i++){
+        int bone_id = vertex.BoneIDs[i];
+
+        encoded.bone_ids[i] = (bone_id < 0 || bone_id >= NO_BONE) ? NO_BONE : (uint8_t)bone_id;
+        encoded.weights[i] = (uint16_t)std::round(std::clamp(vertex.Weights[i], 0.0f, 1.0f) * 65535.0f);
+    }
+
+    return encoded;
+}
\ No newline at end of file
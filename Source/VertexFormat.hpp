@@ -0,0 +1,85 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <glm.hpp>
+
+struct Vertex;
+
+inline constexpr unsigned int STATIC_VERTEX_BUFFER_BINDING = 0;
+inline constexpr unsigned int SKIN_VERTEX_BUFFER_BINDING = 1;
+inline constexpr uint8_t NO_BONE = 255; // bone id of the unused influences
+
+/**
+ * \brief The stream every mesh has. Normal and tangent are octahedral encoded in two snorm16, the texture coordinates are half floats
+ */
+struct StaticVertex{
+    glm::vec3 position;
+    int16_t normal[2];
+    int16_t tangent[2];
+    uint16_t tex_coords[2];
+};
+
+/**
+ * \brief The second stream of skinned meshes
+ */
+struct SkinVertex{
+    uint8_t bone_ids[4]; // NO_BONE for the unused influences
+    uint16_t weights[4]; // unorm16
+};
+
+static_assert(sizeof(StaticVertex) == 24, "StaticVertex must be tightly packed");
+static_assert(sizeof(SkinVertex) == 12, "SkinVertex must be tightly packed");
+
+/**
+ * \brief One attribute of a vertex format, as given to glVertexAttribFormat
+ */
+struct VertexAttribute{
+    unsigned int location;
+    int components;
+    unsigned int type;
+    bool normalized;
+    bool integer; // read as ivec/uvec by the shader, glVertexAttribIFormat
+    unsigned int offset;
+};
+
+/**
+ * \brief The attributes read from one vertex buffer binding
+ */
+struct VertexLayout{
+    const VertexAttribute* attributes;
+    unsigned int count;
+    unsigned int stride;
+    unsigned int binding;
+};
+
+inline constexpr VertexAttribute STATIC_VERTEX_ATTRIBUTES[] = {
+    {0, 3, GL_FLOAT, false, false, offsetof(StaticVertex, position)},
+    {1, 2, GL_SHORT, true, false, offsetof(StaticVertex, normal)},
+    {2, 2, GL_HALF_FLOAT, false, false, offsetof(StaticVertex, tex_coords)},
+    {3, 2, GL_SHORT, true, false, offsetof(StaticVertex, tangent)}
+};
+
+inline constexpr VertexAttribute SKIN_VERTEX_ATTRIBUTES[] = {
+    {4, 4, GL_UNSIGNED_BYTE, false, true, offsetof(SkinVertex, bone_ids)},
+    {5, 4, GL_UNSIGNED_SHORT, true, false, offsetof(SkinVertex, weights)}
+};
+
+inline constexpr VertexLayout STATIC_VERTEX_LAYOUT = {STATIC_VERTEX_ATTRIBUTES, 4, sizeof(StaticVertex), STATIC_VERTEX_BUFFER_BINDING};
+inline constexpr VertexLayout SKIN_VERTEX_LAYOUT = {SKIN_VERTEX_ATTRIBUTES, 2, sizeof(SkinVertex), SKIN_VERTEX_BUFFER_BINDING};
+
+/**
+ * \brief Enable and describe the attributes of the layout in the bound VAO
+ */
+extern void ApplyVertexLayout(const VertexLayout& layout);
+
+/**
+ * \brief True if a vertex is influenced by at least one bone, the mesh then needs the skin stream
+ */
+extern bool HasBoneInfluences(const std::vector<Vertex>& vertices);
+
+extern StaticVertex EncodeStaticVertex(const Vertex& vertex);
+extern SkinVertex EncodeSkinVertex(const Vertex& vertex);
\ No newline at end of file
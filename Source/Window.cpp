@@ -3,11 +3,19 @@
 #include <Log.hpp>
 #include <Input.hpp>
 #include <Renderer.hpp>
+#include <DebugDraw.hpp>
 #include <Text.hpp>
 #include <ResourceManager.hpp>
 #include <Camera.hpp>
 #include <PredefinedMeshes.hpp>
 #include <Bloom.hpp>
+#include <GPUCulling.hpp>
+#include <LightClustering.hpp>
+#include <DynamicResolution.hpp>
+#include <UniformBlocks.hpp>
+#include <GeometryArena.hpp>
+#include <StreamBuffer.hpp>
+#include <JobSystem.hpp>
 #include <PostProcessing.hpp>
 #include <Timer.hpp>
 #include <MousePicking.hpp>
@@ -56,6 +64,8 @@ int InitWindow(unsigned int width, unsigned int height, const char* title)
         return -1;
     }
 
+    InvalidateGLState();
+
     #ifdef DEBUG
         glEnable(GL_DEBUG_OUTPUT);
         glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
@@ -76,17 +86,28 @@ int InitWindow(unsigned int width, unsigned int height, const char* title)
 
     // modules initialization
     GetCamera().Init({ 0.0f, 0.0f, 0.0f }, { 1.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f }, g_FOV);
+    InitStreamBuffer(STREAM_SLOT_SIZE);
+    InitJobSystem();
     InitRenderer();
+    InitDebugDraw();
     InitTextRenderer("Resources/Fonts/tektur/Tektur-Regular.ttf", 30);
+    InitGeometryArena();
     InitPredefinedMeshes();
     InitResourceManager();
     InitBloom();
+    InitGPUCulling();
+    InitLightClustering();
+    InitDynamicResolution();
+    InitUniformBlocks();
     InitPostProcessing();
     InitMousePicking();
 
     g_GBufferShader = LoadShader("Resources/Shaders/GBuffer.vert",
                                  "Resources/Shaders/GBuffer.frag");
 
+    g_DepthPrepassShader = LoadShader("Resources/Shaders/DepthPrepass.vert",
+                                      "Resources/Shaders/DepthPrepass.frag");
+
     g_DeferredShader = LoadShader("Resources/Shaders/DeferredShading.vert",
                                   "Resources/Shaders/DeferredShading.frag");
 
@@ -96,19 +117,29 @@ int InitWindow(unsigned int width, unsigned int height, const char* title)
     g_PointLightShadowMapShader = LoadShader("Resources/Shaders/ShadowMap.vert",
                                              "Resources/Shaders/PointLightShadowMap.frag");
 
-    Shader& gbuffer_s = GetGBufferShader();
-    gbuffer_s.Bind();
-    gbuffer_s.SetUniformMat4fv("projection", GetCamera().GetProjectionMatrix(), 1);
+    // the geometry shader only copies the triangles to their layer, it's needed when the vertex shader can't write gl_Layer
+    std::string layered_geometry = HasVertexShaderLayer() ? "" : "Resources/Shaders/ShadowMapLayered.geom";
+
+    g_LayeredShadowMapShader = LoadShader("Resources/Shaders/ShadowMapLayered.vert",
+                                          "Resources/Shaders/ShadowMapLayered.frag", layered_geometry);
+
+    g_LayeredPointLightShadowMapShader = LoadShader("Resources/Shaders/ShadowMapLayered.vert",
+                                                    "Resources/Shaders/PointLightShadowMapLayered.frag", layered_geometry);
 
     Shader& deferred_s = GetDeferredShader();
     deferred_s.Bind();
-    deferred_s.SetUniform1i("Positions", 0);
+    deferred_s.SetUniform1i("Depth", 0);
     deferred_s.SetUniform1i("Normals", 1);
     deferred_s.SetUniform1i("Albedo", 2);
+    deferred_s.SetUniform1i("Material", 5);
     deferred_s.SetUniform1i("ShadowMaps", 3);
     deferred_s.SetUniform1i("ShadowCubeMaps", 4);
     deferred_s.SetUniform1i("isPlaying", 0);
 
+    Shader& depthprepass_s = GetDepthPrepassShader();
+    depthprepass_s.Bind();
+    depthprepass_s.SetUniform1i("isPlaying", 0);
+
     Shader& shadowmap_s = GetShadowMapShader();
     shadowmap_s.Bind();
     shadowmap_s.SetUniform1i("isPlaying", 0);
@@ -117,17 +148,33 @@ int InitWindow(unsigned int width, unsigned int height, const char* title)
     pointlightshadowmap_s.Bind();
     pointlightshadowmap_s.SetUniform1i("isPlaying", 0);
 
+    Shader& layeredshadowmap_s = GetLayeredShadowMapShader();
+    layeredshadowmap_s.Bind();
+    layeredshadowmap_s.SetUniform1i("isPlaying", 0);
+
+    Shader& layeredpointlightshadowmap_s = GetLayeredPointLightShadowMapShader();
+    layeredpointlightshadowmap_s.Bind();
+    layeredpointlightshadowmap_s.SetUniform1i("isPlaying", 0);
+
     return 0;
 }
 
 void CloseWindow()
 {
     DeinitRenderer();
+    DeinitDebugDraw();
     DeinitTextRenderer();
     DeinitPredefinedMeshes();
     DeinitBloom();
+    DeinitGPUCulling();
+    DeinitLightClustering();
+    DeinitDynamicResolution();
+    DeinitUniformBlocks();
     DeinitResourceManager();
     DeinitMousePicking();
+    DeinitGeometryArena(); // after the models and the predefined meshes gave their ranges back
+    DeinitStreamBuffer();
+    DeinitJobSystem();
     FreeRemainingTimers();
     ClearLogs();
 
@@ -255,7 +302,7 @@ void SetWindowResolution(int width, int height)
         glfwSetWindowMonitor(g_Window, glfwGetPrimaryMonitor(), 0, 0, g_ScreenWidth, g_ScreenHeight, mode->refreshRate);
     }
 
-    glViewport(0, 0, width, height);
+    SetViewport(0, 0, width, height);
 }
 
 std::vector<std::pair<int, int>> QueryAvailableResolutions()
@@ -281,7 +328,7 @@ void EnableFullscreen()
         callback(g_ScreenWidth, g_ScreenHeight);
     }
 
-    glViewport(0, 0, g_ScreenWidth, g_ScreenHeight);
+    SetViewport(0, 0, g_ScreenWidth, g_ScreenHeight);
 }
 
 void DisableFullscreen()
@@ -293,7 +340,7 @@ void DisableFullscreen()
         callback(g_ScreenWidth, g_ScreenHeight);
     }
 
-    glViewport(0, 0, g_ScreenWidth, g_ScreenHeight);
+    SetViewport(0, 0, g_ScreenWidth, g_ScreenHeight);
 }
 
 double GetTime()
@@ -0,0 +1,102 @@
+#include <Tests.hpp>
+#include <BVH.hpp>
+#include <Culling.hpp>
+
+#include <chrono>
+#include <random>
+#include <algorithm>
+#include <gtc/matrix_transform.hpp>
+
+static const int QUERIES = 20;
+static const float INSTANCE_SPACING = 8.0f; // the instances are spread over a plane, so the density doesn't change with the count
+
+/**
+ * \returns the average milliseconds of one call
+ */
+template<typename Function>
+static double TimeQuery(Function function)
+{
+    function(); // warm up the caches
+
+    auto start = std::chrono::steady_clock::now();
+    for(int i = 0; i < QUERIES; i++){
+        function();
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    return std::chrono::duration<double, std::milli>(end - start).count() / QUERIES;
+}
+
+BENCHMARK(BVHQueryAgainstLinearCulling)
+{
+    printf("    %10s %10s %12s %12s %12s\n", "instances", "visible", "linear ms", "batch ms", "bvh ms");
+
+    for(uint32_t count : {1000u, 10000u, 100000u}){
+        std::mt19937 rng(count);
+        float side = std::sqrt((float)count) * INSTANCE_SPACING;
+        std::uniform_real_distribution<float> position(-side * 0.5f, side * 0.5f);
+        std::uniform_real_distribution<float> height(0.0f, 20.0f);
+        std::uniform_real_distribution<float> size(0.5f, 3.0f);
+        std::uniform_real_distribution<float> angle(0.0f, 6.2831853f);
+
+        std::vector<OBB> boxes;
+        CullingBatch batch;
+        BVH tree;
+        boxes.reserve(count);
+        batch.Reserve(count);
+
+        for(uint32_t i = 0; i < count; i++){
+            AABB aabb(-glm::vec3(size(rng)), glm::vec3(size(rng)));
+            glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(position(rng), height(rng), position(rng)));
+            model = glm::rotate(model, angle(rng), glm::vec3(0.0f, 1.0f, 0.0f));
+
+            boxes.push_back(OBBFromAABB(aabb, model));
+            batch.Add(boxes.back());
+            tree.CreateProxy(AABBFromOBB(boxes.back()), {nullptr, nullptr, i, 0});
+        }
+
+        Frustum frustum;
+        ExtractFrustum(frustum, glm::perspective(glm::radians(70.0f), 16.0f / 9.0f, 0.1f, 300.0f) *
+                                glm::lookAt(glm::vec3(0.0f, 2.0f, 0.0f), glm::vec3(1.0f, 2.0f, 0.3f), glm::vec3(0.0f, 1.0f, 0.0f)));
+
+        // what the draw lists did before the tree: test every instance
+        std::vector<uint32_t> linearVisible;
+        double linear = TimeQuery([&](){
+            linearVisible.clear();
+            for(uint32_t i = 0; i < count; i++){
+                if(OBBInFrustum(frustum, boxes[i].center, boxes[i].extents, boxes[i].rotation)){
+                    linearVisible.push_back(i);
+                }
+            }
+        });
+
+        std::vector<uint32_t> batchVisible;
+        double batched = TimeQuery([&](){
+            CullBatch(frustum, batch, batchVisible);
+        });
+
+        // the tree gives fat AABBs, the intersecting ones still get the precise test like in the draw lists
+        std::vector<int> inside, intersecting, stack;
+        std::vector<uint32_t> treeVisible;
+        double bvh = TimeQuery([&](){
+            tree.QueryFrustum(frustum, inside, intersecting, stack);
+
+            treeVisible.clear();
+            for(int proxy : inside){
+                treeVisible.push_back(tree.GetProxyData(proxy).transform_index);
+            }
+            for(int proxy : intersecting){
+                const OBB& box = boxes[tree.GetProxyData(proxy).transform_index];
+                if(OBBInFrustum(frustum, box.center, box.extents, box.rotation)){
+                    treeVisible.push_back(tree.GetProxyData(proxy).transform_index);
+                }
+            }
+        });
+
+        std::sort(treeVisible.begin(), treeVisible.end());
+        CHECK(treeVisible == linearVisible);
+        CHECK(batchVisible == linearVisible);
+
+        printf("    %10u %10zu %12.3f %12.3f %12.3f\n", count, linearVisible.size(), linear, batched, bvh);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,107 @@
+#include <Tests.hpp>
+#include <Culling.hpp>
+
+#include <random>
+#include <gtc/matrix_transform.hpp>
+
+static const uint32_t BOX_COUNT = 1003; // not a multiple of 8, so the scalar tail of the SIMD paths runs too
+
+static std::vector<OBB> RandomBoxes(std::mt19937& rng)
+{
+    std::uniform_real_distribution<float> position(-60.0f, 60.0f);
+    std::uniform_real_distribution<float> size(0.1f, 8.0f);
+    std::uniform_real_distribution<float> angle(0.0f, 6.2831853f);
+    std::uniform_real_distribution<float> axis(-1.0f, 1.0f);
+
+    std::vector<OBB> boxes;
+    boxes.reserve(BOX_COUNT);
+
+    for(uint32_t i = 0; i < BOX_COUNT; i++){
+        AABB aabb(-glm::vec3(size(rng), size(rng), size(rng)), glm::vec3(size(rng), size(rng), size(rng)));
+
+        glm::vec3 rotationAxis(axis(rng), axis(rng), axis(rng) + 2.0f); // never zero
+        glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(position(rng), position(rng), position(rng)));
+        model = glm::rotate(model, angle(rng), glm::normalize(rotationAxis));
+
+        boxes.push_back(OBBFromAABB(aabb, model));
+    }
+
+    return boxes;
+}
+
+static Frustum RandomFrustum(std::mt19937& rng, bool orthographic)
+{
+    std::uniform_real_distribution<float> position(-30.0f, 30.0f);
+
+    glm::vec3 eye(position(rng), position(rng), position(rng));
+    glm::vec3 target(position(rng), position(rng), position(rng) + 61.0f); // never equal to eye
+
+    glm::mat4 projection = orthographic ? glm::ortho(-40.0f, 40.0f, -40.0f, 40.0f, 0.1f, 100.0f)
+                                        : glm::perspective(glm::radians(70.0f), 16.0f / 9.0f, 0.1f, 100.0f);
+
+    Frustum frustum;
+    ExtractFrustum(frustum, projection * glm::lookAt(eye, target, glm::vec3(0.0f, 1.0f, 0.0f)));
+    return frustum;
+}
+
+static void CheckCullingPaths(bool orthographic)
+{
+    std::mt19937 rng(orthographic ? 2 : 1);
+
+    for(int i = 0; i < 50; i++){
+        Frustum frustum = RandomFrustum(rng, orthographic);
+        std::vector<OBB> boxes = RandomBoxes(rng);
+
+        CullingBatch batch;
+        batch.Reserve(boxes.size());
+
+        std::vector<uint32_t> expected;
+        for(const OBB& box : boxes){
+            uint32_t index = batch.Add(box);
+
+            if(OBBInFrustum(frustum, box.center, box.extents, box.rotation)){
+                expected.push_back(index);
+            }
+        }
+
+        std::vector<uint32_t> visible;
+
+        CullBatchScalar(frustum, batch, visible);
+        CHECK(visible == expected);
+
+    #if defined(CULLING_SSE)
+        CullBatchSSE(frustum, batch, visible);
+        CHECK(visible == expected);
+    #endif
+
+    #if defined(CULLING_AVX)
+        CullBatchAVX(frustum, batch, visible);
+        CHECK(visible == expected);
+    #endif
+
+        CullBatch(frustum, batch, visible);
+        CHECK(visible == expected);
+    }
+}
+
+TEST(CullBatchMatchesOBBInFrustum)
+{
+    CheckCullingPaths(false);
+}
+
+TEST(CullBatchMatchesOBBInFrustumOrthographic)
+{
+    CheckCullingPaths(true);
+}
+
+TEST(CullBatchEmpty)
+{
+    Frustum frustum;
+    ExtractFrustum(frustum, glm::perspective(glm::radians(70.0f), 1.0f, 0.1f, 100.0f));
+
+    CullingBatch batch;
+    std::vector<uint32_t> visible = {0, 1, 2};
+
+    CullBatch(frustum, batch, visible);
+    CHECK(visible.empty());
+}
\ No newline at end of file
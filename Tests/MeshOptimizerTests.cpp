@@ -0,0 +1,139 @@
+#include <Tests.hpp>
+#include <MeshOptimizer.hpp>
+#include <Mesh.hpp>
+
+#include <array>
+#include <random>
+#include <algorithm>
+
+static const unsigned int GRID_SIZE = 32; // quads per side, a row of vertices doesn't fit in the vertex cache
+
+/**
+ * \brief Flat grid with the triangles in row order, the way a naive exporter writes them
+ */
+static void GridMesh(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices)
+{
+    const int boneIDs[MAX_BONE_INFLUENCE] = {-1, -1, -1, -1};
+    const float weights[MAX_BONE_INFLUENCE] = {0.0f, 0.0f, 0.0f, 0.0f};
+
+    for(unsigned int z = 0; z <= GRID_SIZE; z++){
+        for(unsigned int x = 0; x <= GRID_SIZE; x++){
+            vertices.emplace_back(glm::vec3(x, 0.0f, z), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec2(x, z) / float(GRID_SIZE),
+                                  glm::vec3(1.0f, 0.0f, 0.0f), boneIDs, weights);
+        }
+    }
+
+    for(unsigned int z = 0; z < GRID_SIZE; z++){
+        for(unsigned int x = 0; x < GRID_SIZE; x++){
+            unsigned int i = z * (GRID_SIZE + 1) + x;
+            unsigned int below = i + GRID_SIZE + 1;
+
+            indices.insert(indices.end(), {i, below, i + 1});
+            indices.insert(indices.end(), {i + 1, below, below + 1});
+        }
+    }
+}
+
+/**
+ * \brief Triangles as vertex positions, rotated so the smallest corner is first (keeps the winding), then sorted
+ */
+static std::vector<std::array<float, 9>> SortedTriangles(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices)
+{
+    std::vector<std::array<float, 9>> triangles;
+    triangles.reserve(indices.size() / 3);
+
+    for(size_t i = 0; i + 2 < indices.size(); i += 3){
+        std::array<float, 9> corners;
+        for(int c = 0; c < 3; c++){
+            const glm::vec3& position = vertices[indices[i + c]].Position;
+            corners[c * 3 + 0] = position.x;
+            corners[c * 3 + 1] = position.y;
+            corners[c * 3 + 2] = position.z;
+        }
+
+        auto lowest = corners.begin();
+        for(int c = 1; c < 3; c++){
+            if(std::lexicographical_compare(corners.begin() + c * 3, corners.begin() + c * 3 + 3, lowest, lowest + 3)){
+                lowest = corners.begin() + c * 3;
+            }
+        }
+        std::rotate(corners.begin(), lowest, corners.end());
+
+        triangles.push_back(corners);
+    }
+
+    std::sort(triangles.begin(), triangles.end());
+    return triangles;
+}
+
+TEST(OptimizeVertexCacheKeepsTriangles)
+{
+    std::vector<Vertex> vertices;
+    std::vector<unsigned int> indices;
+    GridMesh(vertices, indices);
+
+    std::vector<unsigned int> optimized = OptimizeVertexCache(indices, vertices.size());
+
+    CHECK(optimized.size() == indices.size());
+    CHECK(SortedTriangles(vertices, optimized) == SortedTriangles(vertices, indices));
+    CHECK(AnalyzeVertexCache(optimized, vertices.size()).acmr <= AnalyzeVertexCache(indices, vertices.size()).acmr);
+}
+
+TEST(OptimizeOverdrawKeepsTriangles)
+{
+    std::vector<Vertex> vertices;
+    std::vector<unsigned int> indices;
+    GridMesh(vertices, indices);
+
+    std::vector<unsigned int> optimized = OptimizeVertexCache(indices, vertices.size());
+    std::vector<unsigned int> sorted = OptimizeOverdraw(optimized, vertices);
+
+    CHECK(sorted.size() == indices.size());
+    CHECK(SortedTriangles(vertices, sorted) == SortedTriangles(vertices, indices));
+    CHECK(AnalyzeVertexCache(sorted, vertices.size()).acmr <= AnalyzeVertexCache(optimized, vertices.size()).acmr * OVERDRAW_THRESHOLD);
+}
+
+TEST(OptimizeMeshKeepsTriangles)
+{
+    std::vector<Vertex> vertices;
+    std::vector<unsigned int> indices;
+    GridMesh(vertices, indices);
+
+    std::vector<Vertex> optimizedVertices = vertices;
+    std::vector<unsigned int> optimizedIndices = indices;
+    MeshOptimizationStatistics statistics = OptimizeMesh(optimizedVertices, optimizedIndices);
+
+    CHECK(optimizedVertices.size() == vertices.size()); // every vertex of the grid is used
+    CHECK(optimizedIndices.size() == indices.size());
+    CHECK(SortedTriangles(optimizedVertices, optimizedIndices) == SortedTriangles(vertices, indices));
+    CHECK(statistics.after.acmr <= statistics.before.acmr);
+    CHECK(statistics.after.acmr == AnalyzeVertexCache(optimizedIndices, optimizedVertices.size()).acmr);
+}
+
+TEST(OptimizeMeshShuffledGrid)
+{
+    std::vector<Vertex> vertices;
+    std::vector<unsigned int> indices;
+    GridMesh(vertices, indices);
+
+    // shuffle whole triangles, so the input has no locality at all
+    std::vector<unsigned int> order(indices.size() / 3);
+    for(unsigned int i = 0; i < order.size(); i++){
+        order[i] = i;
+    }
+    std::shuffle(order.begin(), order.end(), std::mt19937(1));
+
+    std::vector<unsigned int> shuffled;
+    shuffled.reserve(indices.size());
+    for(unsigned int triangle : order){
+        shuffled.insert(shuffled.end(), indices.begin() + triangle * 3, indices.begin() + triangle * 3 + 3);
+    }
+    indices = std::move(shuffled);
+
+    std::vector<Vertex> optimizedVertices = vertices;
+    std::vector<unsigned int> optimizedIndices = indices;
+    MeshOptimizationStatistics statistics = OptimizeMesh(optimizedVertices, optimizedIndices);
+
+    CHECK(SortedTriangles(optimizedVertices, optimizedIndices) == SortedTriangles(vertices, indices));
+    CHECK(statistics.after.acmr < statistics.before.acmr);
+}
\ No newline at end of file
@@ -0,0 +1,59 @@
+#include <Tests.hpp>
+
+#include <vector>
+#include <cstring>
+
+struct TestCase{
+    const char* name;
+    TestFunction function;
+    bool benchmark;
+};
+
+// function local so it exists before the static initializers of the other files register their tests
+static std::vector<TestCase>& GetTests()
+{
+    static std::vector<TestCase> tests;
+    return tests;
+}
+
+static unsigned int g_Failures = 0;
+
+int RegisterTest(const char* name, TestFunction function, bool benchmark)
+{
+    GetTests().push_back({name, function, benchmark});
+    return 0;
+}
+
+void ReportFailure(const char* file, int line, const char* expression)
+{
+    printf("    %s:%d: CHECK(%s) failed\n", file, line, expression);
+    g_Failures++;
+}
+
+int main(int argc, char** argv)
+{
+    bool benchmarks = (argc > 1 && strcmp(argv[1], "--benchmark") == 0);
+
+    unsigned int failed = 0;
+    unsigned int run = 0;
+
+    for(const TestCase& test : GetTests()){
+        if(test.benchmark != benchmarks){
+            continue;
+        }
+
+        printf("[%s]\n", test.name);
+
+        unsigned int failures = g_Failures;
+        test.function();
+        run++;
+
+        if(g_Failures != failures){
+            failed++;
+        }
+    }
+
+    printf("%u/%u passed\n", run - failed, run);
+
+    return failed == 0 ? 0 : 1;
+}
\ No newline at end of file
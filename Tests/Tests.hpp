@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdio>
+
+using TestFunction = void(*)();
+
+#define TEST(name) \
+    static void name(); \
+    static int name##Registered = RegisterTest(#name, name, false); \
+    static void name()
+
+#define BENCHMARK(name) \
+    static void name(); \
+    static int name##Registered = RegisterTest(#name, name, true); \
+    static void name()
+
+#define CHECK(expression) \
+    do{ \
+        if(!(expression)){ \
+            ReportFailure(__FILE__, __LINE__, #expression); \
+        } \
+    }while(0)
+
+/**
+ * \brief Add a test to the list run by the test executable
+ * \param benchmark benchmarks only run when the executable is started with --benchmark
+ * \returns always 0, so it can initialize a static variable
+ */
+extern int RegisterTest(const char* name, TestFunction function, bool benchmark);
+
+/**
+ * \brief Mark the running test as failed
+ */
+extern void ReportFailure(const char* file, int line, const char* expression);
\ No newline at end of file
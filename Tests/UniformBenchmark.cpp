@@ -0,0 +1,83 @@
+#include <Tests.hpp>
+#include <UniformHandle.hpp>
+
+#include <chrono>
+#include <string>
+#include <unordered_map>
+
+static const int DRAWS = 200000;
+static const int NUM_TEXTURES = 4; // hasTextures[4] (AO) is skipped, like Mesh::Draw did
+
+// the uniforms of GBuffer.frag/vert with the locations the driver could give them
+static const std::vector<std::pair<std::string, int>> GBUFFER_UNIFORMS = {
+    {"albedoMap", 0}, {"normalMap", 1}, {"metallicMap", 2}, {"roughnessMap", 3}, {"aoMap", 4},
+    {"hasTextures", 5}, {"hasTextures[0]", 5}, {"hasTextures[1]", 6}, {"hasTextures[2]", 7}, {"hasTextures[3]", 8}, {"hasTextures[4]", 9},
+    {"projection", 10}, {"view", 11}, {"model", 12}
+};
+
+// the texture types, kept as strings by the textures
+static const std::string TEXTURE_TYPES[NUM_TEXTURES] = {"albedoMap", "normalMap", "metallicMap", "roughnessMap"};
+
+/**
+ * \brief Shader::GetUniformLocation before the handles, without the glGetUniformLocation of the first call
+ */
+static int GetCachedLocation(std::unordered_map<std::string, int>& cache, const std::string& name)
+{
+    if(cache.find(name) != cache.end()){
+        return cache[name];
+    }
+
+    return -1;
+}
+
+BENCHMARK(UniformHandlesAgainstStringLookups)
+{
+    std::unordered_map<std::string, int> cache(GBUFFER_UNIFORMS.begin(), GBUFFER_UNIFORMS.end());
+
+    UniformTable table;
+    table.Build(GBUFFER_UNIFORMS);
+
+    static constexpr UniformHandle HAS_TEXTURES[NUM_TEXTURES] = {
+        UniformHandle::Indexed("hasTextures[", 0), UniformHandle::Indexed("hasTextures[", 1),
+        UniformHandle::Indexed("hasTextures[", 2), UniformHandle::Indexed("hasTextures[", 3)
+    };
+
+    UniformHandle textureUniforms[NUM_TEXTURES] = {TEXTURE_TYPES[0], TEXTURE_TYPES[1], TEXTURE_TYPES[2], TEXTURE_TYPES[3]};
+
+    // the uniform lookups of one Mesh::Draw: the samplers, hasTextures, view and model. The sums keep the loops from being optimized out
+    long long stringSum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for(int draw = 0; draw < DRAWS; draw++){
+        for(int i = 0; i < NUM_TEXTURES; i++){
+            stringSum += GetCachedLocation(cache, TEXTURE_TYPES[i].c_str());
+        }
+        for(int i = 0; i < NUM_TEXTURES; i++){
+            stringSum += GetCachedLocation(cache, "hasTextures[" + std::to_string(i) + "]");
+        }
+        stringSum += GetCachedLocation(cache, "view");
+        stringSum += GetCachedLocation(cache, "model");
+    }
+    double stringNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / DRAWS;
+
+    long long handleSum = 0;
+    start = std::chrono::steady_clock::now();
+    for(int draw = 0; draw < DRAWS; draw++){
+        for(int i = 0; i < NUM_TEXTURES; i++){
+            handleSum += table.GetLocation(textureUniforms[i]);
+        }
+        for(int i = 0; i < NUM_TEXTURES; i++){
+            handleSum += table.GetLocation(HAS_TEXTURES[i]);
+        }
+        handleSum += table.GetLocation("view");
+        handleSum += table.GetLocation("model");
+    }
+    double handleNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / DRAWS;
+
+    CHECK(stringSum == handleSum); // both resolved the same locations
+    CHECK(table.GetLocation("aoMap") == 4);
+    CHECK(table.GetLocation("hasTextures") == table.GetLocation(HAS_TEXTURES[0]));
+    CHECK(table.GetLocation("notAUniform") == -1);
+
+    printf("    string lookups: %8.1f ns per draw\n", stringNs);
+    printf("    handles:        %8.1f ns per draw\n", handleNs);
+}
\ No newline at end of file